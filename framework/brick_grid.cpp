@@ -0,0 +1,216 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Brick_grid
+// -----------------------------------------------------------------------------
+
+#include "brick_grid.hpp"
+#include "volume_data.hpp"
+
+#include <glm/common.hpp>
+#include <glm/vector_relational.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// first and last brick that contain a voxel, bricks overlap by one voxel
+void get_brick_span(int voxel, int brick_size, int brick_count, int& first, int& last)
+{
+  first = voxel == 0 ? 0 : (voxel - 1) / brick_size;
+  last = std::min((voxel + 1) / brick_size, brick_count - 1);
+}
+
+} // namespace
+
+Brick_grid::Brick_grid()
+  : m_dimensions(0)
+  , m_brick_count(0)
+  , m_brick_size(16)
+  , m_min()
+  , m_max()
+{}
+
+unsigned Brick_grid::get_brick_index(glm::ivec3 const& brick) const
+{
+  return brick.x + m_brick_count.x * (brick.y + m_brick_count.y * brick.z);
+}
+
+void Brick_grid::build(volume_data_type const& data, glm::ivec3 const& dimensions,
+                       unsigned byte_per_channel, glm::vec2 const& data_range,
+                       unsigned brick_size)
+{
+  m_dimensions = dimensions;
+  m_brick_size = brick_size;
+  m_brick_count = (dimensions + glm::ivec3(brick_size - 1)) / glm::ivec3(brick_size);
+
+  unsigned brick_total = m_brick_count.x * m_brick_count.y * m_brick_count.z;
+  m_min.assign(brick_total, 255);
+  m_max.assign(brick_total, 0);
+
+  if (data.empty() || brick_total == 0)
+    return;
+
+  std::vector<int> first_x(dimensions.x), last_x(dimensions.x);
+  for (int x = 0; x != dimensions.x; ++x)
+    get_brick_span(x, brick_size, m_brick_count.x, first_x[x], last_x[x]);
+
+  for (int z = 0; z != dimensions.z; ++z) {
+    int first_z, last_z;
+    get_brick_span(z, brick_size, m_brick_count.z, first_z, last_z);
+
+    for (int y = 0; y != dimensions.y; ++y) {
+      int first_y, last_y;
+      get_brick_span(y, brick_size, m_brick_count.y, first_y, last_y);
+
+      size_t row = (size_t)dimensions.x * (y + (size_t)dimensions.y * z);
+
+      for (int x = 0; x != dimensions.x; ++x) {
+        float value = get_windowed_value(data, row + x, byte_per_channel, data_range) * 255.0f;
+        unsigned char lo = (unsigned char)std::floor(value);
+        unsigned char hi = (unsigned char)std::ceil(value);
+
+        for (int bz = first_z; bz <= last_z; ++bz) {
+          for (int by = first_y; by <= last_y; ++by) {
+            for (int bx = first_x[x]; bx <= last_x[x]; ++bx) {
+              unsigned b = get_brick_index(glm::ivec3(bx, by, bz));
+              m_min[b] = std::min(m_min[b], lo);
+              m_max[b] = std::max(m_max[b], hi);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+Brick_grid::occupancy_type Brick_grid::classify(image_data_type const& transfer_function) const
+{
+  // prefix count of transfer function entries with opacity
+  unsigned entries = (unsigned)transfer_function.size() / 4;
+  std::vector<unsigned> opaque(entries + 1, 0);
+  for (unsigned i = 0; i != entries; ++i) {
+    opaque[i + 1] = opaque[i] + (transfer_function[i * 4 + 3] > 0 ? 1 : 0);
+  }
+
+  occupancy_type occupancy(m_min.size(), false);
+
+  if (entries == 0)
+    return occupancy;
+
+  for (unsigned b = 0; b != m_min.size(); ++b) {
+    if (m_min[b] > m_max[b])
+      continue;
+
+    // one entry margin for the linear filtering of the transfer texture
+    unsigned lo = m_min[b] * (entries - 1) / 255;
+    unsigned hi = m_max[b] * (entries - 1) / 255;
+    lo = lo > 0 ? lo - 1 : 0;
+    hi = std::min(hi + 1, entries - 1);
+
+    occupancy[b] = opaque[hi + 1] - opaque[lo] > 0;
+  }
+
+  return occupancy;
+}
+
+void Brick_grid::clip(occupancy_type& occupancy, glm::ivec3 const& voxel_begin, glm::ivec3 const& voxel_end) const
+{
+  // a brick reaches one voxel into its upper neighbours
+  glm::ivec3 first = glm::max(voxel_begin - glm::ivec3(1), glm::ivec3(0)) / glm::ivec3(m_brick_size);
+  glm::ivec3 last = glm::min((voxel_end + glm::ivec3(m_brick_size - 1)) / glm::ivec3(m_brick_size), m_brick_count);
+
+  glm::ivec3 brick;
+  for (brick.z = 0; brick.z != m_brick_count.z; ++brick.z) {
+    for (brick.y = 0; brick.y != m_brick_count.y; ++brick.y) {
+      for (brick.x = 0; brick.x != m_brick_count.x; ++brick.x) {
+        if (glm::any(glm::lessThan(brick, first)) || glm::any(glm::greaterThanEqual(brick, last)))
+          occupancy[get_brick_index(brick)] = false;
+      }
+    }
+  }
+}
+
+std::vector<glm::vec3> Brick_grid::get_boundary_faces(occupancy_type const& occupancy,
+                                                      glm::vec3 const& volume_bounds) const
+{
+  std::vector<glm::vec3> triangles;
+
+  if (occupancy.size() != m_min.size())
+    return triangles;
+
+  glm::vec3 voxel_to_object = volume_bounds / glm::vec3(m_dimensions);
+
+  for (int axis = 0; axis != 3; ++axis) {
+    // u and v span the face, cross(u, v) points along the axis
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+
+    for (int side = -1; side <= 1; side += 2) {
+      for (int a = 0; a != m_brick_count[axis]; ++a) {
+        for (int bv = 0; bv != m_brick_count[v]; ++bv) {
+
+          int run_start = -1;
+
+          for (int bu = 0; bu <= m_brick_count[u]; ++bu) {
+            bool face = false;
+
+            if (bu != m_brick_count[u]) {
+              glm::ivec3 brick;
+              brick[axis] = a;
+              brick[u] = bu;
+              brick[v] = bv;
+
+              glm::ivec3 neighbour = brick;
+              neighbour[axis] += side;
+
+              bool outside = neighbour[axis] < 0 || neighbour[axis] >= m_brick_count[axis];
+              face = occupancy[get_brick_index(brick)]
+                  && (outside || !occupancy[get_brick_index(neighbour)]);
+            }
+
+            if (face && run_start < 0) {
+              run_start = bu;
+            }
+            else if (!face && run_start >= 0) {
+              // merged quad for the run [run_start, bu)
+              int size = (int)m_brick_size;
+              float plane = (float)std::min((side > 0 ? a + 1 : a) * size, m_dimensions[axis]);
+              float u0 = (float)(run_start * size);
+              float u1 = (float)std::min(bu * size, m_dimensions[u]);
+              float v0 = (float)(bv * size);
+              float v1 = (float)std::min((bv + 1) * size, m_dimensions[v]);
+
+              glm::vec3 corners[4];
+              const float corner_u[4] = { u0, u1, u1, u0 };
+              const float corner_v[4] = { v0, v0, v1, v1 };
+              for (int c = 0; c != 4; ++c) {
+                corners[c][axis] = plane;
+                corners[c][u] = corner_u[c];
+                corners[c][v] = corner_v[c];
+                corners[c] *= voxel_to_object;
+              }
+
+              if (side > 0) {
+                triangles.push_back(corners[0]); triangles.push_back(corners[1]); triangles.push_back(corners[2]);
+                triangles.push_back(corners[0]); triangles.push_back(corners[2]); triangles.push_back(corners[3]);
+              }
+              else {
+                triangles.push_back(corners[0]); triangles.push_back(corners[2]); triangles.push_back(corners[1]);
+                triangles.push_back(corners[0]); triangles.push_back(corners[3]); triangles.push_back(corners[2]);
+              }
+
+              run_start = -1;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return triangles;
+}
@@ -0,0 +1,61 @@
+#ifndef BRICK_GRID_HPP
+#define BRICK_GRID_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Brick_grid
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+// min/max of the windowed data (0..255, the transfer function index) per brick
+class Brick_grid
+{
+public:
+  typedef std::vector<bool> occupancy_type;
+
+  Brick_grid();
+
+  // bricks overlap their neighbours by one voxel so trilinear samples are covered
+  void build(volume_data_type const& data, glm::ivec3 const& dimensions,
+             unsigned byte_per_channel, glm::vec2 const& data_range,
+             unsigned brick_size = 16);
+
+  // a brick is occupied if the transfer function has any opacity in its range
+  occupancy_type classify(image_data_type const& transfer_function) const;
+
+  // empties bricks without voxels in [voxel_begin, voxel_end)
+  void clip(occupancy_type& occupancy, glm::ivec3 const& voxel_begin, glm::ivec3 const& voxel_end) const;
+
+  // outward facing triangles of the boundary between occupied and empty bricks,
+  // coplanar neighbouring faces are merged into strips
+  std::vector<glm::vec3> get_boundary_faces(occupancy_type const& occupancy,
+                                            glm::vec3 const& volume_bounds) const;
+
+  glm::ivec3 get_brick_count() const { return m_brick_count; }
+  glm::ivec3 get_dimensions() const { return m_dimensions; }
+  unsigned   get_brick_size() const { return m_brick_size; }
+  unsigned   get_brick_index(glm::ivec3 const& brick) const;
+
+  unsigned char get_min(unsigned brick_index) const { return m_min[brick_index]; }
+  unsigned char get_max(unsigned brick_index) const { return m_max[brick_index]; }
+
+private:
+  glm::ivec3                 m_dimensions;
+  glm::ivec3                 m_brick_count;
+  unsigned                   m_brick_size;
+  std::vector<unsigned char> m_min;
+  std::vector<unsigned char> m_max;
+};
+
+#endif // BRICK_GRID_HPP
@@ -0,0 +1,129 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Camera_path
+// -----------------------------------------------------------------------------
+
+#include "camera_path.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/constants.hpp>
+
+namespace {
+
+// rotation, panning and zoom as one vector, so all are interpolated alike
+struct Pose_values
+{
+  float v[5];
+};
+
+Pose_values get_values(Turntable const& pose)
+{
+  Pose_values values = { { pose.rotation().x, pose.rotation().y,
+                           pose.panning().x, pose.panning().y, pose.zoom() } };
+  return values;
+}
+
+// tangent at key i from its neighbours, one sided at the ends
+float get_tangent(std::vector<Camera_key> const& keys, std::vector<Pose_values> const& values,
+                  size_t i, int c)
+{
+  size_t previous = i == 0 ? i : i - 1;
+  size_t next = i + 1 == keys.size() ? i : i + 1;
+  double dt = keys[next].time - keys[previous].time;
+  return dt > 0.0 ? float((values[next].v[c] - values[previous].v[c]) / dt) : 0.0f;
+}
+
+} // namespace
+
+Camera_path::Camera_path()
+  : m_keys()
+{}
+
+void Camera_path::add_key(double time, Turntable const& pose)
+{
+  Camera_key key = { time, pose };
+
+  std::vector<Camera_key>::iterator k = m_keys.begin();
+  while (k != m_keys.end() && k->time < time)
+    ++k;
+
+  if (k != m_keys.end() && k->time == time)
+    *k = key;
+  else
+    m_keys.insert(k, key);
+}
+
+void Camera_path::remove_key(unsigned index)
+{
+  if (index < m_keys.size())
+    m_keys.erase(m_keys.begin() + index);
+}
+
+double Camera_path::get_duration() const
+{
+  return m_keys.empty() ? 0.0 : m_keys.back().time;
+}
+
+Turntable Camera_path::evaluate(double time) const
+{
+  if (m_keys.empty())
+    return Turntable();
+  if (m_keys.size() == 1 || time <= m_keys.front().time)
+    return m_keys.front().pose;
+  if (time >= m_keys.back().time)
+    return m_keys.back().pose;
+
+  size_t i = 1;
+  while (m_keys[i].time < time)
+    ++i;
+  size_t k0 = i - 1, k1 = i;
+
+  // the neighbours of the segment are enough for the tangents
+  std::vector<Pose_values> values(m_keys.size());
+  size_t first = k0 == 0 ? 0 : k0 - 1;
+  size_t last = std::min(k1 + 1, m_keys.size() - 1);
+  for (size_t k = first; k <= last; ++k)
+    values[k] = get_values(m_keys[k].pose);
+
+  // cubic Hermite segment with Catmull-Rom tangents scaled to the segment length
+  double length = m_keys[k1].time - m_keys[k0].time;
+  float t = float((time - m_keys[k0].time) / length);
+  float t2 = t * t, t3 = t2 * t;
+  float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+  float h10 = t3 - 2.0f * t2 + t;
+  float h01 = -2.0f * t3 + 3.0f * t2;
+  float h11 = t3 - t2;
+
+  Pose_values result;
+  for (int c = 0; c != 5; ++c) {
+    float m0 = get_tangent(m_keys, values, k0, c) * float(length);
+    float m1 = get_tangent(m_keys, values, k1, c) * float(length);
+    result.v[c] = h00 * values[k0].v[c] + h10 * m0 + h01 * values[k1].v[c] + h11 * m1;
+  }
+
+  Turntable pose = m_keys[k0].pose;
+  pose.set(glm::vec2(result.v[0], result.v[1]), glm::vec2(result.v[2], result.v[3]), result.v[4]);
+  return pose;
+}
+
+Camera_path Camera_path::orbit(Turntable const& pose, double duration, float turns)
+{
+  Camera_path path;
+  int segments = std::max(1, int(std::ceil(std::abs(turns) * 4.0f)));
+
+  for (int s = 0; s <= segments; ++s) {
+    float fraction = float(s) / float(segments);
+    Turntable key = pose;
+    key.set(pose.rotation() + glm::vec2(fraction * turns * 2.0f * glm::pi<float>(), 0.0f),
+            pose.panning(), pose.zoom());
+    path.add_key(fraction * duration, key);
+  }
+
+  return path;
+}
@@ -0,0 +1,53 @@
+#ifndef CAMERA_PATH_HPP
+#define CAMERA_PATH_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Camera_path
+// -----------------------------------------------------------------------------
+
+#include "turntable.hpp"
+
+#include <vector>
+
+struct Camera_key
+{
+  double    time;    // seconds from the start of the path
+  Turntable pose;
+};
+
+// turntable poses over time; rotation, panning and zoom follow Catmull-Rom
+// splines through the keys, which may be spaced unevenly
+class Camera_path
+{
+public:
+  Camera_path();
+
+  // keys stay sorted by time, a key at an existing time replaces it
+  void add_key(double time, Turntable const& pose);
+  void remove_key(unsigned index);
+  void clear() { m_keys.clear(); }
+
+  unsigned          size() const { return unsigned(m_keys.size()); }
+  bool              empty() const { return m_keys.empty(); }
+  Camera_key const& operator[](unsigned index) const { return m_keys[index]; }
+
+  // time of the last key
+  double get_duration() const;
+
+  // pose at time, clamped to the first and last key
+  Turntable evaluate(double time) const;
+
+  // full turns around the vertical axis starting at pose, keys every quarter
+  // turn so the spline keeps the angular speed constant
+  static Camera_path orbit(Turntable const& pose, double duration, float turns = 1.0f);
+
+private:
+  std::vector<Camera_key> m_keys;
+};
+
+#endif // CAMERA_PATH_HPP
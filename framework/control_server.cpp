@@ -0,0 +1,320 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Control_server
+// -----------------------------------------------------------------------------
+
+#include "control_server.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+namespace {
+
+// commands longer than this without a newline close the client
+const size_t max_line_length = 1 << 16;
+
+#ifndef _WIN32
+bool set_non_blocking(int socket)
+{
+  int flags = fcntl(socket, F_GETFL, 0);
+  return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+#endif
+
+} // namespace
+
+Control_server::Control_server()
+  : m_socket_path()
+  , m_listen_socket(-1)
+  , m_thread()
+  , m_running(false)
+  , m_client_count(0)
+  , m_mutex()
+  , m_commands()
+  , m_replies()
+  , m_disconnected()
+  , m_clients()
+  , m_next_client(1)
+{
+  m_wake_pipe[0] = m_wake_pipe[1] = -1;
+}
+
+Control_server::~Control_server()
+{
+  stop();
+}
+
+bool Control_server::start(std::string const& socket_path)
+{
+  stop();
+
+#ifndef _WIN32
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+    return false;
+  std::strcpy(address.sun_path, socket_path.c_str());
+
+  m_listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (m_listen_socket < 0)
+    return false;
+
+  unlink(socket_path.c_str());
+  if (bind(m_listen_socket, (sockaddr*)&address, sizeof(address)) != 0
+      || listen(m_listen_socket, 8) != 0
+      || !set_non_blocking(m_listen_socket)
+      || pipe(m_wake_pipe) != 0) {
+    close(m_listen_socket);
+    m_listen_socket = -1;
+    unlink(socket_path.c_str());
+    return false;
+  }
+  set_non_blocking(m_wake_pipe[0]);
+  set_non_blocking(m_wake_pipe[1]);
+
+  m_socket_path = socket_path;
+  m_running = true;
+  m_thread = std::thread(&Control_server::serve, this);
+  return true;
+#else
+  (void)socket_path;
+  return false;
+#endif
+}
+
+void Control_server::stop()
+{
+  if (!m_running)
+    return;
+
+  m_running = false;
+  wake();
+  m_thread.join();
+
+#ifndef _WIN32
+  for (std::map<unsigned, Client>::iterator c = m_clients.begin(); c != m_clients.end(); ++c)
+    close(c->second.socket);
+  close(m_listen_socket);
+  close(m_wake_pipe[0]);
+  close(m_wake_pipe[1]);
+  unlink(m_socket_path.c_str());
+#endif
+
+  m_clients.clear();
+  m_client_count = 0;
+  m_listen_socket = -1;
+  m_wake_pipe[0] = m_wake_pipe[1] = -1;
+  m_socket_path.clear();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_commands.clear();
+  m_replies.clear();
+  m_disconnected.clear();
+}
+
+std::vector<Control_command> Control_server::take_commands()
+{
+  std::vector<Control_command> commands;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  commands.swap(m_commands);
+  return commands;
+}
+
+void Control_server::reply(unsigned client, std::string const& line)
+{
+  if (!m_running)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_replies[client].push_back(line + "\n");
+  }
+  wake();
+}
+
+std::vector<unsigned> Control_server::take_disconnected()
+{
+  std::vector<unsigned> clients;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  clients.swap(m_disconnected);
+  return clients;
+}
+
+void Control_server::wake()
+{
+#ifndef _WIN32
+  // a full pipe already wakes the thread
+  char byte = 0;
+  if (m_wake_pipe[1] >= 0 && write(m_wake_pipe[1], &byte, 1) < 0) {}
+#endif
+}
+
+Control_command Control_server::parse(std::string const& line)
+{
+  Control_command command;
+  command.client = 0;
+
+  std::vector<std::string> tokens;
+  size_t i = 0;
+  while (i < line.size()) {
+    while (i < line.size() && std::isspace((unsigned char)line[i]))
+      ++i;
+    if (i == line.size())
+      break;
+
+    std::string token;
+    if (line[i] == '"') {
+      for (++i; i < line.size() && line[i] != '"'; ++i)
+        token += line[i];
+      ++i;
+    }
+    else {
+      for (; i < line.size() && !std::isspace((unsigned char)line[i]); ++i)
+        token += line[i];
+    }
+    tokens.push_back(token);
+  }
+
+  if (!tokens.empty()) {
+    command.name = tokens[0];
+    command.arguments.assign(tokens.begin() + 1, tokens.end());
+  }
+  return command;
+}
+
+void Control_server::serve()
+{
+#ifndef _WIN32
+  std::vector<pollfd> fds;
+  std::vector<unsigned> ids;
+
+  while (m_running) {
+    // replies queued by the application
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (std::map<unsigned, std::vector<std::string> >::iterator r = m_replies.begin(); r != m_replies.end(); ++r) {
+        std::map<unsigned, Client>::iterator c = m_clients.find(r->first);
+        if (c == m_clients.end())
+          continue;
+        for (size_t l = 0; l != r->second.size(); ++l)
+          c->second.output += r->second[l];
+        c->second.pending -= std::min(c->second.pending, unsigned(r->second.size()));
+      }
+      m_replies.clear();
+    }
+
+    fds.clear();
+    ids.clear();
+    pollfd listen_fd = { m_listen_socket, POLLIN, 0 };
+    pollfd wake_fd = { m_wake_pipe[0], POLLIN, 0 };
+    fds.push_back(listen_fd);
+    fds.push_back(wake_fd);
+    for (std::map<unsigned, Client>::iterator c = m_clients.begin(); c != m_clients.end(); ++c) {
+      short events = short((c->second.reading_done ? 0 : POLLIN) | (c->second.output.empty() ? 0 : POLLOUT));
+      pollfd client_fd = { c->second.socket, events, 0 };
+      fds.push_back(client_fd);
+      ids.push_back(c->first);
+    }
+
+    if (poll(&fds[0], nfds_t(fds.size()), 100) < 0 && errno != EINTR)
+      break;
+
+    if (fds[1].revents & POLLIN) {
+      char buffer[64];
+      while (read(m_wake_pipe[0], buffer, sizeof(buffer)) > 0) {}
+    }
+
+    if (fds[0].revents & POLLIN) {
+      int socket = -1;
+      while ((socket = accept(m_listen_socket, 0, 0)) >= 0) {
+        set_non_blocking(socket);
+        Client client = { socket, std::string(), std::string(), 0, false };
+        m_clients[m_next_client++] = client;
+      }
+    }
+
+    std::vector<Control_command> commands;
+    std::vector<unsigned> disconnected;
+    for (size_t i = 0; i != ids.size(); ++i) {
+      Client& client = m_clients[ids[i]];
+      short events = fds[i + 2].revents;
+      bool closed = (events & (POLLERR | POLLNVAL)) != 0;
+
+      if (!closed && !client.reading_done && (events & (POLLIN | POLLHUP))) {
+        char buffer[4096];
+        ssize_t count = 0;
+        while ((count = recv(client.socket, buffer, sizeof(buffer), 0)) > 0)
+          client.input.append(buffer, size_t(count));
+        if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+          closed = true;
+
+        // end of input, a last line may lack its newline
+        if (count == 0) {
+          client.reading_done = true;
+          if (!client.input.empty())
+            client.input += '\n';
+        }
+
+        size_t end = 0;
+        while ((end = client.input.find('\n')) != std::string::npos) {
+          Control_command command = parse(client.input.substr(0, end));
+          client.input.erase(0, end + 1);
+          if (command.name.empty())
+            continue;
+          command.client = ids[i];
+          commands.push_back(command);
+          ++client.pending;
+        }
+        if (client.input.size() > max_line_length)
+          closed = true;
+      }
+
+      if (!closed && (events & POLLOUT) && !client.output.empty()) {
+        ssize_t count = send(client.socket, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+        if (count > 0)
+          client.output.erase(0, size_t(count));
+        else if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+          closed = true;
+      }
+
+      // done once all its commands are answered, a hang up leaves nobody to
+      // read the answers
+      if (client.reading_done && ((events & POLLHUP) || (client.pending == 0 && client.output.empty())))
+        closed = true;
+
+      if (closed) {
+        close(client.socket);
+        m_clients.erase(ids[i]);
+        disconnected.push_back(ids[i]);
+      }
+    }
+
+    m_client_count = unsigned(m_clients.size());
+
+    if (!commands.empty() || !disconnected.empty()) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_commands.insert(m_commands.end(), commands.begin(), commands.end());
+      m_disconnected.insert(m_disconnected.end(), disconnected.begin(), disconnected.end());
+    }
+  }
+#endif
+}
@@ -0,0 +1,90 @@
+#ifndef CONTROL_SERVER_HPP
+#define CONTROL_SERVER_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Control_server
+// -----------------------------------------------------------------------------
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Control_command
+{
+  unsigned                 client;
+  std::string              name;
+  std::vector<std::string> arguments;
+};
+
+// text commands over a Unix domain socket, one per line, arguments separated
+// by blanks and quoted if they contain any ("load_volume \"my file.raw\"").
+// A thread serves the clients; the application takes the commands queued since
+// its last frame and answers each with one line. Not available on Windows
+class Control_server
+{
+public:
+  Control_server();
+  ~Control_server();
+
+  // replaces an old socket file at path
+  bool start(std::string const& socket_path);
+  void stop();
+
+  bool               is_running() const { return m_running; }
+  std::string const& get_socket_path() const { return m_socket_path; }
+  unsigned           get_client_count() const { return m_client_count; }
+
+  // never waits for the sockets, only for the queue
+  std::vector<Control_command> take_commands();
+
+  // newline appended; lines for clients that left are dropped
+  void reply(unsigned client, std::string const& line);
+
+  // clients closed since the last call. One that stops sending is only closed
+  // once every command it sent is answered and the answers are written
+  std::vector<unsigned> take_disconnected();
+
+  // name and arguments of a line, empty name for a blank line
+  static Control_command parse(std::string const& line);
+
+private:
+  struct Client
+  {
+    int         socket;
+    std::string input;
+    std::string output;
+    unsigned    pending;      // commands queued but not answered yet
+    bool        reading_done; // the client shut down its sending side
+  };
+
+  Control_server(Control_server const&);
+  Control_server& operator=(Control_server const&);
+
+  void serve();
+  void wake();
+
+  std::string                     m_socket_path;
+  int                             m_listen_socket;
+  int                             m_wake_pipe[2];
+  std::thread                     m_thread;
+  std::atomic<bool>               m_running;
+  std::atomic<unsigned>           m_client_count;
+
+  std::mutex                                    m_mutex;   // guards the queues
+  std::vector<Control_command>                  m_commands;
+  std::map<unsigned, std::vector<std::string> > m_replies;
+  std::vector<unsigned>                         m_disconnected;
+
+  std::map<unsigned, Client>      m_clients;      // owned by the serving thread
+  unsigned                        m_next_client;
+};
+
+#endif // CONTROL_SERVER_HPP
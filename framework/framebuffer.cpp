@@ -0,0 +1,141 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Framebuffer
+// -----------------------------------------------------------------------------
+
+#include "framebuffer.hpp"
+
+namespace {
+
+GLenum get_pixel_format(GLenum internal_format)
+{
+  switch (internal_format) {
+  case GL_R8: case GL_R16F: case GL_R32F: return GL_RED;
+  case GL_RG8: case GL_RG16F: case GL_RG32F: return GL_RG;
+  case GL_RGB8: case GL_RGB16F: case GL_RGB32F: return GL_RGB;
+  default: return GL_RGBA;
+  }
+}
+
+GLenum get_pixel_type(GLenum internal_format)
+{
+  switch (internal_format) {
+  case GL_R8: case GL_RG8: case GL_RGB8: case GL_RGBA8: return GL_UNSIGNED_BYTE;
+  default: return GL_FLOAT;
+  }
+}
+
+} // namespace
+
+Framebuffer::Framebuffer()
+  : m_color_formats()
+  , m_color_textures()
+  , m_depth(false)
+  , m_depth_texture(0)
+  , m_fbo(0)
+  , m_size(0)
+{}
+
+Framebuffer::Framebuffer(std::vector<GLenum> const& color_formats, bool depth)
+  : m_color_formats(color_formats)
+  , m_color_textures(color_formats.size(), 0)
+  , m_depth(depth)
+  , m_depth_texture(0)
+  , m_fbo(0)
+  , m_size(0)
+{}
+
+void Framebuffer::resize(glm::ivec2 const& size)
+{
+  if (size == m_size && m_fbo != 0)
+    return;
+
+  free();
+  m_size = size;
+
+  glGenFramebuffers(1, &m_fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+
+  std::vector<GLenum> draw_buffers;
+
+  for (unsigned i = 0; i != m_color_formats.size(); ++i) {
+    glGenTextures(1, &m_color_textures[i]);
+    glBindTexture(GL_TEXTURE_2D, m_color_textures[i]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, m_color_formats[i], size.x, size.y, 0,
+        get_pixel_format(m_color_formats[i]), get_pixel_type(m_color_formats[i]), nullptr);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_color_textures[i], 0);
+    draw_buffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+  }
+
+  if (m_depth) {
+    glGenTextures(1, &m_depth_texture);
+    glBindTexture(GL_TEXTURE_2D, m_depth_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size.x, size.y, 0,
+        GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth_texture, 0);
+  }
+
+  if (!draw_buffers.empty())
+    glDrawBuffers((GLsizei)draw_buffers.size(), &draw_buffers[0]);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::bind() const
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+  glViewport(0, 0, m_size.x, m_size.y);
+}
+
+void Framebuffer::unbind() const
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::blit_to_screen(unsigned attachment) const
+{
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+  glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, m_size.x, m_size.y, 0, 0, m_size.x, m_size.y,
+      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::read_pixels(unsigned attachment, GLenum format, GLenum type, void* data) const
+{
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+  glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, m_size.x, m_size.y, format, type, data);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::free()
+{
+  for (unsigned i = 0; i != m_color_textures.size(); ++i) {
+    if (m_color_textures[i])
+      glDeleteTextures(1, &m_color_textures[i]);
+    m_color_textures[i] = 0;
+  }
+  if (m_depth_texture)
+    glDeleteTextures(1, &m_depth_texture);
+  if (m_fbo)
+    glDeleteFramebuffers(1, &m_fbo);
+  m_depth_texture = 0;
+  m_fbo = 0;
+  m_size = glm::ivec2(0);
+}
@@ -0,0 +1,52 @@
+#ifndef FRAMEBUFFER_HPP
+#define FRAMEBUFFER_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Framebuffer
+// -----------------------------------------------------------------------------
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+
+#include <vector>
+
+// offscreen render target with one texture per color attachment
+class Framebuffer
+{
+public:
+  Framebuffer();
+  Framebuffer(std::vector<GLenum> const& color_formats, bool depth = false);
+
+  // (re)allocates the attachments if the size changed
+  void resize(glm::ivec2 const& size);
+
+  // binds for drawing into all color attachments and sets the viewport
+  void bind() const;
+  void unbind() const;
+
+  void blit_to_screen(unsigned attachment = 0) const;
+  void read_pixels(unsigned attachment, GLenum format, GLenum type, void* data) const;
+
+  GLuint     get_color_texture(unsigned attachment) const { return m_color_textures[attachment]; }
+  unsigned   get_color_attachment_count() const { return unsigned(m_color_formats.size()); }
+  glm::ivec2 get_size() const { return m_size; }
+  void       free();
+
+private:
+  std::vector<GLenum> m_color_formats;
+  std::vector<GLuint> m_color_textures;
+  bool                m_depth;
+  GLuint              m_depth_texture;
+  GLuint              m_fbo;
+  glm::ivec2          m_size;
+};
+
+#endif // FRAMEBUFFER_HPP
@@ -0,0 +1,178 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Illumination_volume
+// -----------------------------------------------------------------------------
+
+#include "illumination_volume.hpp"
+#include "parallel.hpp"
+#include "volume_data.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+Illumination_volume::Illumination_volume()
+  : m_dimensions(0)
+  , m_voxel_size(1.0f)
+  , m_bounds(1.0f)
+  , m_values()
+  , m_illumination()
+  , m_transfer_function()
+  , m_reference_step(1.0f)
+  , m_light_direction(glm::normalize(glm::vec3(1.0f)))
+  , m_reverse(false)
+  , m_shift(0.0f)
+  , m_previous()
+  , m_current()
+  , m_slice_count(0)
+  , m_next_slice(0)
+{
+  m_axis[0] = 0;
+  m_axis[1] = 1;
+  m_axis[2] = 2;
+  std::fill(m_transmittance, m_transmittance + 256, 1.0f);
+}
+
+void Illumination_volume::set_volume(volume_data_type const& data, glm::ivec3 const& dimensions,
+                                     unsigned byte_per_channel, glm::vec2 const& data_range,
+                                     glm::vec3 const& volume_bounds, int max_resolution)
+{
+  m_values = downsample_windowed(data, dimensions, byte_per_channel, data_range, max_resolution, m_dimensions);
+  m_bounds = volume_bounds;
+  m_voxel_size = volume_bounds / glm::vec3(m_dimensions);
+  m_illumination.assign(m_values.size(), 255);
+
+  restart();
+}
+
+void Illumination_volume::set_transfer_function(image_data_type const& transfer_function, float reference_step)
+{
+  m_transfer_function = transfer_function;
+  m_reference_step = reference_step;
+  restart();
+}
+
+void Illumination_volume::set_light(glm::vec3 const& light_position)
+{
+  glm::vec3 direction = light_position - 0.5f * m_bounds;
+  if (glm::dot(direction, direction) == 0.0f)
+    return;
+
+  direction = glm::normalize(direction);
+  if (glm::dot(direction, m_light_direction) > 0.99999f)
+    return;
+
+  m_light_direction = direction;
+  restart();
+}
+
+bool Illumination_volume::update(double budget_ms)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  while (!is_complete()) {
+    sweep_slice(m_next_slice++);
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed.count() >= budget_ms)
+      break;
+  }
+
+  return is_complete();
+}
+
+void Illumination_volume::restart()
+{
+  m_next_slice = 0;
+  m_slice_count = 0;
+
+  unsigned entries = (unsigned)m_transfer_function.size() / 4;
+  if (m_values.empty() || entries == 0)
+    return;
+
+  // dominant axis of the light direction measured in voxels
+  glm::vec3 direction = m_light_direction / m_voxel_size;
+  int a = 0;
+  for (int i = 1; i != 3; ++i) {
+    if (std::abs(direction[i]) > std::abs(direction[a]))
+      a = i;
+  }
+
+  m_axis[0] = a;
+  m_axis[1] = (a + 1) % 3;
+  m_axis[2] = (a + 2) % 3;
+
+  // with the light on the high side the sweep runs from the last slice down,
+  // one slice toward the light moves the footprint by m_shift voxels
+  m_reverse = direction[a] > 0.0f;
+  m_shift = glm::vec2(direction[m_axis[1]], direction[m_axis[2]]) / std::abs(direction[a]);
+
+  // transmittance of one slice step, corrected from the reference step
+  float step = m_voxel_size[a] / std::abs(m_light_direction[a]);
+  for (unsigned v = 0; v != 256; ++v) {
+    float alpha = m_transfer_function[(v * (entries - 1) / 255) * 4 + 3] / 255.0f;
+    m_transmittance[v] = std::pow(1.0f - alpha, step / m_reference_step);
+  }
+
+  m_slice_count = m_dimensions[a];
+  m_previous.assign(m_dimensions[m_axis[1]] * m_dimensions[m_axis[2]], 1.0f);
+  m_current.assign(m_previous.size(), 1.0f);
+}
+
+int Illumination_volume::get_index(int a, int u, int v) const
+{
+  glm::ivec3 p;
+  p[m_axis[0]] = a;
+  p[m_axis[1]] = u;
+  p[m_axis[2]] = v;
+  return p.x + m_dimensions.x * (p.y + m_dimensions.y * p.z);
+}
+
+void Illumination_volume::sweep_slice(int slice)
+{
+  int size_u = m_dimensions[m_axis[1]];
+  int size_v = m_dimensions[m_axis[2]];
+  int a = m_reverse ? m_slice_count - 1 - slice : slice;
+
+  parallel_for(0, size_v, [&](int v_begin, int v_end) {
+    for (int v = v_begin; v != v_end; ++v) {
+      for (int u = 0; u != size_u; ++u) {
+        float light = 1.0f;
+
+        if (slice > 0) {
+          // light leaving the previous slice, bilinear around the footprint,
+          // outside the volume nothing attenuates it
+          float pu = u + m_shift.x;
+          float pv = v + m_shift.y;
+          int u0 = (int)std::floor(pu);
+          int v0 = (int)std::floor(pv);
+          float fu = pu - u0;
+          float fv = pv - v0;
+
+          float taps[4];
+          for (int t = 0; t != 4; ++t) {
+            int tu = u0 + (t & 1);
+            int tv = v0 + (t >> 1);
+            taps[t] = (tu < 0 || tv < 0 || tu >= size_u || tv >= size_v)
+              ? 1.0f : m_previous[tu + size_u * tv];
+          }
+
+          light = (taps[0] * (1.0f - fu) + taps[1] * fu) * (1.0f - fv)
+                + (taps[2] * (1.0f - fu) + taps[3] * fu) * fv;
+        }
+
+        int index = get_index(a, u, v);
+        m_illumination[index] = (unsigned char)(light * 255.0f + 0.5f);
+        m_current[u + size_u * v] = light * m_transmittance[m_values[index]];
+      }
+    }
+  });
+
+  std::swap(m_previous, m_current);
+}
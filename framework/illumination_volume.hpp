@@ -0,0 +1,74 @@
+#ifndef ILLUMINATION_VOLUME_HPP
+#define ILLUMINATION_VOLUME_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Illumination_volume
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+// low resolution light transmittance (0..255) through the classified volume,
+// swept slice by slice away from the light along its dominant axis
+class Illumination_volume
+{
+public:
+  Illumination_volume();
+
+  // averages the windowed data down to at most max_resolution voxels per axis
+  void set_volume(volume_data_type const& data, glm::ivec3 const& dimensions,
+                  unsigned byte_per_channel, glm::vec2 const& data_range,
+                  glm::vec3 const& volume_bounds, int max_resolution = 128);
+
+  // opacities are given per reference_step, like the compositing ray loop sees them
+  void set_transfer_function(image_data_type const& transfer_function, float reference_step);
+
+  // the light is treated as directional from the volume center, the sweep
+  // only restarts if that direction changed
+  void set_light(glm::vec3 const& light_position);
+
+  // sweeps slices until budget_ms passed, true once the volume is complete
+  bool update(double budget_ms);
+
+  bool       is_complete() const { return m_next_slice >= m_slice_count; }
+  glm::ivec3 get_dimensions() const { return m_dimensions; }
+
+  std::vector<unsigned char> const& get_illumination() const { return m_illumination; }
+
+private:
+  void restart();
+  void sweep_slice(int slice);
+  int  get_index(int a, int u, int v) const;
+
+  glm::ivec3                 m_dimensions;
+  glm::vec3                  m_voxel_size;
+  glm::vec3                  m_bounds;
+  std::vector<unsigned char> m_values;
+  std::vector<unsigned char> m_illumination;
+
+  std::vector<unsigned char> m_transfer_function;
+  float                      m_reference_step;
+  glm::vec3                  m_light_direction;
+
+  // sweep state, axis a runs away from the light, u and v span the slices
+  int                        m_axis[3];
+  bool                       m_reverse;
+  glm::vec2                  m_shift;
+  float                      m_transmittance[256];
+  std::vector<float>         m_previous;
+  std::vector<float>         m_current;
+  int                        m_slice_count;
+  int                        m_next_slice;
+};
+
+#endif // ILLUMINATION_VOLUME_HPP
@@ -0,0 +1,395 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Iso_surface_extractor
+// -----------------------------------------------------------------------------
+
+#include "iso_surface.hpp"
+#include "volume_data.hpp"
+#include "parallel.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <unordered_map>
+
+namespace {
+
+// cell corners are indexed by bits, bit 0 = x, bit 1 = y, bit 2 = z
+// every tetrahedron is a path from corner 0 to corner 7 along the axes, so
+// for two of its corners one is always a subset of the other and all edges
+// point in a positive direction, neighbouring cells share faces consistently
+const int tetrahedra[6][4] = {
+  { 0, 1, 3, 7 },
+  { 0, 1, 5, 7 },
+  { 0, 2, 3, 7 },
+  { 0, 2, 6, 7 },
+  { 0, 4, 5, 7 },
+  { 0, 4, 6, 7 }
+};
+
+typedef unsigned long long edge_key_type;
+
+glm::ivec3 get_corner_offset(int corner)
+{
+  return glm::ivec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+}
+
+// triangles of one z range of bricks, extracted by one thread
+struct Chunk
+{
+  Chunk() : first_z(0), processed(false) {}
+
+  std::vector<glm::vec3>     positions;
+  std::vector<glm::vec3>     normals;
+  std::vector<unsigned>      indices;
+  std::vector<edge_key_type> keys;
+  std::unordered_map<edge_key_type, unsigned> vertex_map;
+  int                        first_z;
+  bool                       processed;
+};
+
+struct Volume_view
+{
+  volume_data_type const* data;
+  glm::ivec3              dimensions;
+  unsigned                byte_per_channel;
+  glm::vec2               data_range;
+  glm::vec3               voxel_size;
+
+  size_t get_index(glm::ivec3 const& p) const
+  {
+    return p.x + (size_t)dimensions.x * (p.y + (size_t)dimensions.y * p.z);
+  }
+
+  float get_value(glm::ivec3 const& p) const
+  {
+    return get_windowed_value(*data, get_index(p), byte_per_channel, data_range);
+  }
+
+  // central differences in object space
+  glm::vec3 get_gradient(glm::ivec3 const& p) const
+  {
+    glm::vec3 gradient;
+    for (int a = 0; a != 3; ++a) {
+      glm::ivec3 lo = p;
+      glm::ivec3 hi = p;
+      lo[a] = std::max(p[a] - 1, 0);
+      hi[a] = std::min(p[a] + 1, dimensions[a] - 1);
+      float distance = (hi[a] - lo[a]) * voxel_size[a];
+      gradient[a] = distance > 0.0f ? (get_value(hi) - get_value(lo)) / distance : 0.0f;
+    }
+    return gradient;
+  }
+};
+
+// vertex on the edge from corner a to corner b (a is a subset of b)
+unsigned get_edge_vertex(Chunk& chunk, Volume_view const& volume, glm::ivec3 const& cell,
+                         int a, int b, float value_a, float value_b, float iso_value)
+{
+  glm::ivec3 pa = cell + get_corner_offset(a);
+  glm::ivec3 pb = cell + get_corner_offset(b);
+
+  edge_key_type key = (edge_key_type)volume.get_index(pa) * 7 + ((a ^ b) - 1);
+
+  std::unordered_map<edge_key_type, unsigned>::const_iterator found = chunk.vertex_map.find(key);
+  if (found != chunk.vertex_map.end())
+    return found->second;
+
+  float delta = value_b - value_a;
+  float t = std::fabs(delta) > 1e-7f ? (iso_value - value_a) / delta : 0.5f;
+
+  glm::vec3 voxel = glm::vec3(pa) + t * glm::vec3(pb - pa);
+  glm::vec3 gradient = (1.0f - t) * volume.get_gradient(pa) + t * volume.get_gradient(pb);
+  float gradient_length = glm::length(gradient);
+
+  unsigned index = (unsigned)chunk.positions.size();
+  chunk.positions.push_back((voxel + 0.5f) * volume.voxel_size);
+  chunk.normals.push_back(gradient_length > 0.0f ? -gradient / gradient_length : glm::vec3(0.0f));
+  chunk.keys.push_back(key);
+  chunk.vertex_map[key] = index;
+
+  return index;
+}
+
+void add_triangle(Chunk& chunk, unsigned i0, unsigned i1, unsigned i2)
+{
+  if (i0 == i1 || i1 == i2 || i0 == i2)
+    return;
+
+  // wind counter clockwise around the normal, which points to lower values
+  glm::vec3 face = glm::cross(chunk.positions[i1] - chunk.positions[i0],
+                              chunk.positions[i2] - chunk.positions[i0]);
+  glm::vec3 normal = chunk.normals[i0] + chunk.normals[i1] + chunk.normals[i2];
+
+  chunk.indices.push_back(i0);
+  if (glm::dot(face, normal) >= 0.0f) {
+    chunk.indices.push_back(i1);
+    chunk.indices.push_back(i2);
+  }
+  else {
+    chunk.indices.push_back(i2);
+    chunk.indices.push_back(i1);
+  }
+}
+
+void polygonize_cell(Chunk& chunk, Volume_view const& volume, glm::ivec3 const& cell, float iso_value)
+{
+  float values[8];
+  unsigned inside = 0;
+  for (int c = 0; c != 8; ++c) {
+    values[c] = volume.get_value(cell + get_corner_offset(c));
+    inside += values[c] >= iso_value ? 1 : 0;
+  }
+
+  if (inside == 0 || inside == 8)
+    return;
+
+  for (int t = 0; t != 6; ++t) {
+    const int* tet = tetrahedra[t];
+
+    int in[4], out[4];
+    int in_count = 0, out_count = 0;
+    for (int v = 0; v != 4; ++v) {
+      if (values[tet[v]] >= iso_value)
+        in[in_count++] = tet[v];
+      else
+        out[out_count++] = tet[v];
+    }
+
+    // tetrahedron corners are sorted along the path, the smaller one is the subset
+    auto edge = [&](int a, int b) {
+      return a < b ? get_edge_vertex(chunk, volume, cell, a, b, values[a], values[b], iso_value)
+                   : get_edge_vertex(chunk, volume, cell, b, a, values[b], values[a], iso_value);
+    };
+
+    if (in_count == 1 || out_count == 1) {
+      int single = in_count == 1 ? in[0] : out[0];
+      int* others = in_count == 1 ? out : in;
+      add_triangle(chunk, edge(single, others[0]), edge(single, others[1]), edge(single, others[2]));
+    }
+    else if (in_count == 2) {
+      unsigned ac = edge(in[0], out[0]);
+      unsigned ad = edge(in[0], out[1]);
+      unsigned bd = edge(in[1], out[1]);
+      unsigned bc = edge(in[1], out[0]);
+      add_triangle(chunk, ac, ad, bd);
+      add_triangle(chunk, ac, bd, bc);
+    }
+  }
+}
+
+// writes little endian regardless of the host
+void write_little_endian(std::ofstream& file, const void* value, size_t size)
+{
+  const unsigned one = 1u;
+  const char* bytes = (const char*)value;
+
+  if (*(const char*)&one == 1) {
+    file.write(bytes, size);
+  }
+  else {
+    for (size_t i = size; i != 0; --i)
+      file.write(bytes + i - 1, 1);
+  }
+}
+
+} // namespace
+
+bool Iso_mesh::save_obj(std::string const& file_path) const
+{
+  std::ofstream file(file_path.c_str());
+  if (!file.good())
+    return false;
+
+  file << "# iso surface, iso value " << iso_value << "\n";
+  for (size_t i = 0; i != positions.size(); ++i)
+    file << "v " << positions[i].x << " " << positions[i].y << " " << positions[i].z << "\n";
+  for (size_t i = 0; i != normals.size(); ++i)
+    file << "vn " << normals[i].x << " " << normals[i].y << " " << normals[i].z << "\n";
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    file << "f";
+    for (size_t c = 0; c != 3; ++c)
+      file << " " << indices[i + c] + 1 << "//" << indices[i + c] + 1;
+    file << "\n";
+  }
+
+  return file.good();
+}
+
+bool Iso_mesh::save_ply(std::string const& file_path) const
+{
+  std::ofstream file(file_path.c_str(), std::ios::out | std::ios::binary);
+  if (!file.good())
+    return false;
+
+  file << "ply\n"
+       << "format binary_little_endian 1.0\n"
+       << "comment iso surface, iso value " << iso_value << "\n"
+       << "element vertex " << positions.size() << "\n"
+       << "property float x\nproperty float y\nproperty float z\n"
+       << "property float nx\nproperty float ny\nproperty float nz\n"
+       << "element face " << indices.size() / 3 << "\n"
+       << "property list uchar uint vertex_indices\n"
+       << "end_header\n";
+
+  for (size_t i = 0; i != positions.size(); ++i) {
+    for (int c = 0; c != 3; ++c)
+      write_little_endian(file, &positions[i][c], sizeof(float));
+    for (int c = 0; c != 3; ++c)
+      write_little_endian(file, &normals[i][c], sizeof(float));
+  }
+
+  const unsigned char corners = 3;
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    file.write((const char*)&corners, 1);
+    for (size_t c = 0; c != 3; ++c)
+      write_little_endian(file, &indices[i + c], sizeof(unsigned));
+  }
+
+  return file.good();
+}
+
+Iso_surface_extractor::Iso_surface_extractor()
+  : m_data(nullptr)
+  , m_brick_grid()
+  , m_span_space()
+  , m_dimensions(0)
+  , m_byte_per_channel(1)
+  , m_data_range(0.0f, 1.0f)
+  , m_volume_bounds(1.0f)
+{}
+
+void Iso_surface_extractor::set_volume(volume_data_type const& data, glm::ivec3 const& dimensions,
+                                       unsigned byte_per_channel, glm::vec2 const& data_range,
+                                       glm::vec3 const& volume_bounds, unsigned brick_size)
+{
+  m_data = &data;
+  m_dimensions = dimensions;
+  m_byte_per_channel = byte_per_channel;
+  m_data_range = data_range;
+  m_volume_bounds = volume_bounds;
+
+  m_brick_grid.build(data, dimensions, byte_per_channel, data_range, brick_size);
+  m_span_space.build(m_brick_grid);
+}
+
+std::vector<unsigned> Iso_surface_extractor::get_active_bricks(float iso_value) const
+{
+  return m_span_space.query(iso_value * 255.0f);
+}
+
+std::vector<unsigned> Iso_surface_extractor::get_active_bricks(float iso_value, glm::ivec3 const& voxel_begin,
+                                                               glm::ivec3 const& voxel_end) const
+{
+  std::vector<unsigned> bricks = get_active_bricks(iso_value);
+
+  glm::ivec3 brick_count = m_brick_grid.get_brick_count();
+  int brick_size = (int)m_brick_grid.get_brick_size();
+
+  std::vector<unsigned>::iterator kept = bricks.begin();
+  for (std::vector<unsigned>::const_iterator b = bricks.begin(); b != bricks.end(); ++b) {
+    glm::ivec3 brick(*b % brick_count.x, (*b / brick_count.x) % brick_count.y, *b / (brick_count.x * brick_count.y));
+    glm::ivec3 first = brick * brick_size;
+    glm::ivec3 last = first + brick_size;
+    if (glm::all(glm::lessThan(first, voxel_end)) && glm::all(glm::greaterThanEqual(last, voxel_begin)))
+      *kept++ = *b;
+  }
+  bricks.erase(kept, bricks.end());
+
+  return bricks;
+}
+
+Iso_mesh Iso_surface_extractor::extract(float iso_value) const
+{
+  return extract(iso_value, get_active_bricks(iso_value));
+}
+
+Iso_mesh Iso_surface_extractor::extract(float iso_value, std::vector<unsigned> const& active_bricks) const
+{
+  Iso_mesh mesh;
+  mesh.iso_value = iso_value;
+
+  if (!m_data || m_data->empty() || glm::any(glm::lessThan(m_dimensions, glm::ivec3(2))))
+    return mesh;
+
+  Volume_view volume;
+  volume.data = m_data;
+  volume.dimensions = m_dimensions;
+  volume.byte_per_channel = m_byte_per_channel;
+  volume.data_range = m_data_range;
+  volume.voxel_size = m_volume_bounds / glm::vec3(m_dimensions);
+
+  std::vector<unsigned> bricks(active_bricks);
+  std::sort(bricks.begin(), bricks.end());
+
+  glm::ivec3 brick_count = m_brick_grid.get_brick_count();
+  int brick_size = (int)m_brick_grid.get_brick_size();
+  unsigned layer_size = brick_count.x * brick_count.y;
+
+  // one chunk per contiguous range of brick layers, indexed by its first layer
+  std::vector<Chunk> chunks(brick_count.z);
+
+  parallel_for(0, brick_count.z, [&](int first_layer, int end_layer) {
+    Chunk& chunk = chunks[first_layer];
+    chunk.first_z = first_layer * brick_size;
+    chunk.processed = true;
+
+    std::vector<unsigned>::const_iterator b = std::lower_bound(bricks.begin(), bricks.end(), first_layer * layer_size);
+    std::vector<unsigned>::const_iterator e = std::lower_bound(bricks.begin(), bricks.end(), end_layer * layer_size);
+
+    for (; b != e; ++b) {
+      glm::ivec3 brick(*b % brick_count.x, (*b / brick_count.x) % brick_count.y, *b / layer_size);
+      glm::ivec3 first = brick * brick_size;
+      glm::ivec3 last = glm::min(first + brick_size, m_dimensions - 1);
+
+      glm::ivec3 cell;
+      for (cell.z = first.z; cell.z < last.z; ++cell.z)
+        for (cell.y = first.y; cell.y < last.y; ++cell.y)
+          for (cell.x = first.x; cell.x < last.x; ++cell.x)
+            polygonize_cell(chunk, volume, cell, iso_value);
+    }
+  });
+
+  // merge the chunks, vertices on the seam to the previous chunk are shared
+  size_t layer_voxels = (size_t)m_dimensions.x * m_dimensions.y;
+  Chunk const* previous = nullptr;
+  std::vector<unsigned> previous_remap;
+
+  for (std::vector<Chunk>::const_iterator chunk = chunks.begin(); chunk != chunks.end(); ++chunk) {
+    if (!chunk->processed)
+      continue;
+
+    std::vector<unsigned> remap(chunk->positions.size());
+
+    for (size_t i = 0; i != chunk->positions.size(); ++i) {
+      edge_key_type key = chunk->keys[i];
+      int z = (int)((key / 7) / layer_voxels);
+
+      if (previous && z == chunk->first_z) {
+        std::unordered_map<edge_key_type, unsigned>::const_iterator found = previous->vertex_map.find(key);
+        if (found != previous->vertex_map.end()) {
+          remap[i] = previous_remap[found->second];
+          continue;
+        }
+      }
+
+      remap[i] = (unsigned)mesh.positions.size();
+      mesh.positions.push_back(chunk->positions[i]);
+      mesh.normals.push_back(chunk->normals[i]);
+    }
+
+    for (std::vector<unsigned>::const_iterator i = chunk->indices.begin(); i != chunk->indices.end(); ++i)
+      mesh.indices.push_back(remap[*i]);
+
+    previous = &(*chunk);
+    previous_remap.swap(remap);
+  }
+
+  return mesh;
+}
@@ -0,0 +1,72 @@
+#ifndef ISO_SURFACE_HPP
+#define ISO_SURFACE_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Iso_surface_extractor
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+#include "brick_grid.hpp"
+#include "span_space_index.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <string>
+#include <vector>
+
+// indexed triangle mesh in object space, normals point to lower data values
+struct Iso_mesh
+{
+  Iso_mesh() : iso_value(-1.0f) {}
+
+  bool save_obj(std::string const& file_path) const;
+  bool save_ply(std::string const& file_path) const;
+
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<unsigned>  indices;
+  float                  iso_value;
+};
+
+// multithreaded iso surface extraction over the windowed data (0..1),
+// each cell is split into six tetrahedra sharing the main diagonal
+class Iso_surface_extractor
+{
+public:
+  Iso_surface_extractor();
+
+  // the data is referenced, not copied, and indexed once per volume
+  void set_volume(volume_data_type const& data, glm::ivec3 const& dimensions,
+                  unsigned byte_per_channel, glm::vec2 const& data_range,
+                  glm::vec3 const& volume_bounds, unsigned brick_size = 8);
+
+  // the same samples moved to another container, the index stays valid
+  void rebind(volume_data_type const& data) { m_data = &data; }
+
+  // bricks whose value range contains the iso value, from the span space index
+  std::vector<unsigned> get_active_bricks(float iso_value) const;
+  // only bricks with cells inside [voxel_begin, voxel_end)
+  std::vector<unsigned> get_active_bricks(float iso_value, glm::ivec3 const& voxel_begin,
+                                          glm::ivec3 const& voxel_end) const;
+
+  Iso_mesh extract(float iso_value) const;
+  Iso_mesh extract(float iso_value, std::vector<unsigned> const& active_bricks) const;
+
+private:
+  volume_data_type const* m_data;
+  Brick_grid              m_brick_grid;
+  Span_space_index        m_span_space;
+  glm::ivec3              m_dimensions;
+  unsigned                m_byte_per_channel;
+  glm::vec2               m_data_range;
+  glm::vec3               m_volume_bounds;
+};
+
+#endif // ISO_SURFACE_HPP
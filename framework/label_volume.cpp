@@ -0,0 +1,189 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Label_volume
+// -----------------------------------------------------------------------------
+
+#include "label_volume.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+
+#include <glm/common.hpp>
+
+namespace {
+
+// first and last brick that contain a voxel, bricks overlap by one voxel
+void get_brick_span(int voxel, int brick_size, int brick_count, int& first, int& last)
+{
+  first = voxel == 0 ? 0 : (voxel - 1) / brick_size;
+  last = std::min((voxel + 1) / brick_size, brick_count - 1);
+}
+
+template<typename T>
+unsigned get_max_label(const T* data, size_t count)
+{
+  T max_label = 0;
+  for (size_t i = 0; i != count; ++i)
+    max_label = std::max(max_label, data[i]);
+  return max_label;
+}
+
+// each brick layer is marked by one task, the voxels it reads overlap with the
+// neighbouring layers but the bits written do not
+template<typename T>
+void mark_bricks(const T* data, glm::ivec3 const& dimensions, int brick_size,
+                 glm::ivec3 const& brick_count, unsigned words, unsigned long long* bits)
+{
+  std::vector<int> first_x(dimensions.x), last_x(dimensions.x);
+  for (int x = 0; x != dimensions.x; ++x)
+    get_brick_span(x, brick_size, brick_count.x, first_x[x], last_x[x]);
+
+  parallel_for(0, brick_count.z, [&](int begin, int end) {
+    for (int bz = begin; bz != end; ++bz) {
+      int z_begin = std::max(bz * brick_size - 1, 0);
+      int z_end = std::min((bz + 1) * brick_size + 1, dimensions.z);
+
+      for (int z = z_begin; z != z_end; ++z) {
+        for (int y = 0; y != dimensions.y; ++y) {
+          int first_y, last_y;
+          get_brick_span(y, brick_size, brick_count.y, first_y, last_y);
+          const T* row = data + dimensions.x * (y + size_t(dimensions.y) * z);
+
+          // runs of one label within the same bricks are marked once
+          unsigned previous = ~0u;
+          int previous_x = -1;
+          for (int x = 0; x != dimensions.x; ++x) {
+            unsigned label = row[x];
+            if (label == previous && first_x[x] == first_x[previous_x] && last_x[x] == last_x[previous_x])
+              continue;
+            previous = label;
+            previous_x = x;
+
+            for (int by = first_y; by <= last_y; ++by) {
+              for (int bx = first_x[x]; bx <= last_x[x]; ++bx) {
+                size_t brick = bx + brick_count.x * (by + size_t(brick_count.y) * bz);
+                bits[brick * words + label / 64] |= 1ull << (label % 64);
+              }
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+} // namespace
+
+Label_volume::Label_volume()
+  : m_dimensions(0)
+  , m_brick_count(0)
+  , m_label_count(0)
+  , m_words(0)
+  , m_bits()
+{}
+
+void Label_volume::build(volume_data_type const& labels, glm::ivec3 const& dimensions,
+                         unsigned byte_per_label, unsigned brick_size)
+{
+  m_dimensions = dimensions;
+  m_brick_count = (dimensions + glm::ivec3(brick_size - 1)) / glm::ivec3(brick_size);
+  m_label_count = 0;
+  m_words = 0;
+  m_bits.clear();
+
+  size_t voxels = size_t(dimensions.x) * dimensions.y * dimensions.z;
+  if (labels.size() < voxels * byte_per_label || voxels == 0)
+    return;
+
+  const unsigned short* labels_16 = (const unsigned short*)&labels[0];
+  m_label_count = 1 + (byte_per_label == 2 ? get_max_label(labels_16, voxels)
+                                           : get_max_label(&labels[0], voxels));
+  m_words = (m_label_count + 63) / 64;
+  m_bits.assign(size_t(m_brick_count.x) * m_brick_count.y * m_brick_count.z * m_words, 0);
+
+  if (byte_per_label == 2)
+    mark_bricks(labels_16, dimensions, brick_size, m_brick_count, m_words, &m_bits[0]);
+  else
+    mark_bricks(&labels[0], dimensions, brick_size, m_brick_count, m_words, &m_bits[0]);
+}
+
+bool Label_volume::contains(unsigned brick_index, unsigned label) const
+{
+  if (label >= m_label_count)
+    return false;
+  return (m_bits[size_t(brick_index) * m_words + label / 64] >> (label % 64)) & 1;
+}
+
+void Label_volume::get_transfer_row(image_data_type const& transfer_function, Label_style const& style,
+                                    unsigned char* row)
+{
+  image_data_type const& source = style.transfer_function.size() == transfer_function.size()
+                                ? style.transfer_function : transfer_function;
+  glm::vec4 scale(glm::clamp(style.color, 0.0f, 1.0f), style.visible ? glm::clamp(style.opacity, 0.0f, 1.0f) : 0.0f);
+
+  for (size_t i = 0; i != source.size(); ++i)
+    row[i] = (unsigned char)(source[i] * scale[i % 4] + 0.5f);
+}
+
+image_data_type Label_volume::get_transfer_rows(image_data_type const& transfer_function,
+                                                std::vector<Label_style> const& styles)
+{
+  image_data_type rows(transfer_function.size() * styles.size());
+  for (size_t l = 0; l != styles.size(); ++l)
+    get_transfer_row(transfer_function, styles[l], &rows[l * transfer_function.size()]);
+  return rows;
+}
+
+Brick_grid::occupancy_type Label_volume::classify(Brick_grid const& grid, image_data_type const& rows) const
+{
+  glm::ivec3 count = grid.get_brick_count();
+  Brick_grid::occupancy_type occupancy(size_t(count.x) * count.y * count.z, false);
+
+  // a grid of another layout cannot be matched, nothing is skipped then
+  if (count != m_brick_count || m_label_count == 0) {
+    occupancy.assign(occupancy.size(), true);
+    return occupancy;
+  }
+
+  unsigned entries = unsigned(rows.size() / 4 / m_label_count);
+  if (entries == 0)
+    return occupancy;
+
+  // prefix count of entries with opacity per label row
+  std::vector<unsigned> opaque(size_t(m_label_count) * (entries + 1), 0);
+  for (unsigned l = 0; l != m_label_count; ++l) {
+    unsigned* prefix = &opaque[size_t(l) * (entries + 1)];
+    const unsigned char* row = &rows[size_t(l) * entries * 4];
+    for (unsigned i = 0; i != entries; ++i)
+      prefix[i + 1] = prefix[i] + (row[i * 4 + 3] > 0 ? 1 : 0);
+  }
+
+  for (unsigned b = 0; b != occupancy.size(); ++b) {
+    if (grid.get_min(b) > grid.get_max(b))
+      continue;
+
+    // one entry margin for the linear filtering of the transfer texture
+    unsigned lo = grid.get_min(b) * (entries - 1) / 255;
+    unsigned hi = grid.get_max(b) * (entries - 1) / 255;
+    lo = lo > 0 ? lo - 1 : 0;
+    hi = std::min(hi + 1, entries - 1);
+
+    const unsigned long long* bits = &m_bits[size_t(b) * m_words];
+    for (unsigned w = 0; w != m_words && !occupancy[b]; ++w) {
+      unsigned long long word = bits[w];
+      for (unsigned l = w * 64; word != 0; ++l, word >>= 1) {
+        const unsigned* prefix = &opaque[size_t(l) * (entries + 1)];
+        if ((word & 1) && prefix[hi + 1] - prefix[lo] > 0) {
+          occupancy[b] = true;
+          break;
+        }
+      }
+    }
+  }
+
+  return occupancy;
+}
@@ -0,0 +1,69 @@
+#ifndef LABEL_VOLUME_HPP
+#define LABEL_VOLUME_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Label_volume
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+#include "brick_grid.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+// appearance of one label, its transfer function is empty while it follows
+// the global one
+struct Label_style
+{
+  bool            visible;
+  glm::vec3       color;
+  float           opacity;
+  image_data_type transfer_function;
+};
+
+// which labels of a segmentation occur in every brick of a Brick_grid layout,
+// one bit per label and brick
+class Label_volume
+{
+public:
+  Label_volume();
+
+  // ids are 8 or 16 bit; bricks overlap by one voxel like the Brick_grid
+  // built with the same size
+  void build(volume_data_type const& labels, glm::ivec3 const& dimensions,
+             unsigned byte_per_label, unsigned brick_size = 16);
+
+  // highest id + 1
+  unsigned   get_label_count() const { return m_label_count; }
+  glm::ivec3 get_dimensions() const { return m_dimensions; }
+
+  bool contains(unsigned brick_index, unsigned label) const;
+
+  // one row per label of the transfer function entries, RGBA: the color
+  // modulated by the label color, the opacity scaled by the label opacity and
+  // 0 for hidden labels
+  static void get_transfer_row(image_data_type const& transfer_function, Label_style const& style,
+                               unsigned char* row);
+  static image_data_type get_transfer_rows(image_data_type const& transfer_function,
+                                           std::vector<Label_style> const& styles);
+
+  // a brick is occupied if one of its labels has opacity in the value range
+  // of the brick; rows as from get_transfer_rows
+  Brick_grid::occupancy_type classify(Brick_grid const& grid, image_data_type const& rows) const;
+
+private:
+  glm::ivec3                      m_dimensions;
+  glm::ivec3                      m_brick_count;
+  unsigned                        m_label_count;
+  unsigned                        m_words;        // bitset words per brick
+  std::vector<unsigned long long> m_bits;
+};
+
+#endif // LABEL_VOLUME_HPP
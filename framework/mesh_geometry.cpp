@@ -0,0 +1,80 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Mesh_geometry
+// -----------------------------------------------------------------------------
+
+#include "mesh_geometry.hpp"
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+Mesh_geometry::Mesh_geometry()
+  : m_vao(0)
+  , m_vbo(0)
+  , m_ibo(0)
+  , m_index_count(0)
+{}
+
+void Mesh_geometry::update(std::vector<glm::vec3> const& positions,
+                           std::vector<glm::vec3> const& normals,
+                           std::vector<unsigned> const& indices)
+{
+  if (m_vao == 0) {
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ibo);
+  }
+
+  // interleaved position and normal
+  std::vector<glm::vec3> vertices(positions.size() * 2);
+  for (size_t i = 0; i != positions.size(); ++i) {
+    vertices[i * 2] = positions[i];
+    vertices[i * 2 + 1] = i < normals.size() ? normals[i] : glm::vec3(0.0f);
+  }
+
+  glBindVertexArray(m_vao);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * vertices.size(),
+      vertices.empty() ? nullptr : &vertices[0], GL_STATIC_DRAW);
+
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), nullptr);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned) * indices.size(),
+      indices.empty() ? nullptr : &indices[0], GL_STATIC_DRAW);
+
+  glBindVertexArray(0);
+
+  m_index_count = (unsigned)indices.size();
+}
+
+void Mesh_geometry::draw() const
+{
+  if (m_index_count == 0)
+    return;
+
+  glBindVertexArray(m_vao);
+  glDrawElements(GL_TRIANGLES, m_index_count, GL_UNSIGNED_INT, 0);
+  glBindVertexArray(0);
+}
+
+void Mesh_geometry::freeVAO()
+{
+  if (m_ibo)
+    glDeleteBuffers(1, &m_ibo);
+  if (m_vbo)
+    glDeleteBuffers(1, &m_vbo);
+  if (m_vao)
+    glDeleteVertexArrays(1, &m_vao);
+  m_ibo = 0;
+  m_vbo = 0;
+  m_vao = 0;
+  m_index_count = 0;
+}
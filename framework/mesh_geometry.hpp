@@ -0,0 +1,39 @@
+#ifndef MESH_GEOMETRY_HPP
+#define MESH_GEOMETRY_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Mesh_geometry
+// -----------------------------------------------------------------------------
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+// indexed triangles, position at location 0 and normal at location 1
+class Mesh_geometry
+{
+public:
+  Mesh_geometry();
+
+  void update(std::vector<glm::vec3> const& positions,
+              std::vector<glm::vec3> const& normals,
+              std::vector<unsigned> const& indices);
+  void draw() const;
+  void freeVAO();
+
+  unsigned get_index_count() const { return m_index_count; }
+
+private:
+  unsigned int m_vao;
+  unsigned int m_vbo;
+  unsigned int m_ibo;
+  unsigned     m_index_count;
+};
+
+#endif // MESH_GEOMETRY_HPP
@@ -0,0 +1,166 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Occlusion_volume
+// -----------------------------------------------------------------------------
+
+#include "occlusion_volume.hpp"
+#include "parallel.hpp"
+#include "volume_data.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_VOLUME_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// acc += row
+void add_row(float* acc, const float* row, int count)
+{
+  int i = 0;
+#ifdef OCCLUSION_VOLUME_SSE2
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(row + i)));
+#endif
+  for (; i != count; ++i)
+    acc[i] += row[i];
+}
+
+// acc -= row
+void sub_row(float* acc, const float* row, int count)
+{
+  int i = 0;
+#ifdef OCCLUSION_VOLUME_SSE2
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_ps(acc + i, _mm_sub_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(row + i)));
+#endif
+  for (; i != count; ++i)
+    acc[i] -= row[i];
+}
+
+// dst = acc * scale
+void scale_row(float* dst, const float* acc, float scale, int count)
+{
+  int i = 0;
+#ifdef OCCLUSION_VOLUME_SSE2
+  __m128 s = _mm_set1_ps(scale);
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(acc + i), s));
+#endif
+  for (; i != count; ++i)
+    dst[i] = acc[i] * scale;
+}
+
+// box filter along the middle axis of [outer][length][inner], a sliding window
+// of whole rows so the inner loops run over contiguous memory, zero outside
+void blur_rows(std::vector<float> const& src, std::vector<float>& dst,
+               int outer, int length, int inner, int radius)
+{
+  const int chunk = 1024;
+  int chunks = (inner + chunk - 1) / chunk;
+  float scale = 1.0f / (2 * radius + 1);
+
+  parallel_for(0, outer * chunks, [&](int begin, int end) {
+    std::vector<float> acc(chunk);
+    for (int job = begin; job != end; ++job) {
+      int o = job / chunks;
+      int first = (job % chunks) * chunk;
+      int count = std::min(chunk, inner - first);
+      size_t base = size_t(o) * length * inner + first;
+
+      std::fill(acc.begin(), acc.begin() + count, 0.0f);
+      for (int l = 0; l < std::min(radius, length); ++l)
+        add_row(&acc[0], &src[base + size_t(l) * inner], count);
+
+      for (int l = 0; l != length; ++l) {
+        if (l + radius < length)
+          add_row(&acc[0], &src[base + size_t(l + radius) * inner], count);
+        scale_row(&dst[base + size_t(l) * inner], &acc[0], scale, count);
+        if (l - radius >= 0)
+          sub_row(&acc[0], &src[base + size_t(l - radius) * inner], count);
+      }
+    }
+  });
+}
+
+// box filter along x, rows are short so a scalar running sum per row
+void blur_x(std::vector<float> const& src, std::vector<float>& dst, int rows, int length, int radius)
+{
+  float scale = 1.0f / (2 * radius + 1);
+
+  parallel_for(0, rows, [&](int begin, int end) {
+    for (int r = begin; r != end; ++r) {
+      const float* in = &src[size_t(r) * length];
+      float* out = &dst[size_t(r) * length];
+
+      float acc = 0.0f;
+      for (int x = 0; x < std::min(radius, length); ++x)
+        acc += in[x];
+
+      for (int x = 0; x != length; ++x) {
+        if (x + radius < length)
+          acc += in[x + radius];
+        out[x] = acc * scale;
+        if (x - radius >= 0)
+          acc -= in[x - radius];
+      }
+    }
+  });
+}
+
+} // namespace
+
+Occlusion_volume::Occlusion_volume()
+  : m_dimensions(0)
+  , m_voxel_size(1.0f)
+  , m_values()
+{}
+
+void Occlusion_volume::set_volume(volume_data_type const& data, glm::ivec3 const& dimensions,
+                                  unsigned byte_per_channel, glm::vec2 const& data_range,
+                                  glm::vec3 const& volume_bounds, int max_resolution)
+{
+  m_values = downsample_windowed(data, dimensions, byte_per_channel, data_range, max_resolution, m_dimensions);
+  m_voxel_size = volume_bounds / glm::vec3(m_dimensions);
+}
+
+volume_data_type Occlusion_volume::compute(image_data_type const& transfer_function, float reference_step,
+                                           int radius, float strength) const
+{
+  volume_data_type visibility(m_values.size(), 255);
+
+  unsigned entries = (unsigned)transfer_function.size() / 4;
+  if (m_values.empty() || entries == 0)
+    return visibility;
+
+  // opacity of a whole low resolution voxel, corrected from the reference step
+  float step = std::min(std::min(m_voxel_size.x, m_voxel_size.y), m_voxel_size.z);
+  float opacity_lut[256];
+  for (unsigned v = 0; v != 256; ++v) {
+    float alpha = transfer_function[(v * (entries - 1) / 255) * 4 + 3] / 255.0f;
+    opacity_lut[v] = 1.0f - std::pow(1.0f - alpha, step / reference_step);
+  }
+
+  std::vector<float> opacity(m_values.size());
+  for (size_t i = 0; i != m_values.size(); ++i)
+    opacity[i] = opacity_lut[m_values[i]];
+
+  std::vector<float> blurred(opacity.size());
+  blur_x(opacity, blurred, m_dimensions.y * m_dimensions.z, m_dimensions.x, radius);
+  blur_rows(blurred, opacity, m_dimensions.z, m_dimensions.y, m_dimensions.x, radius);
+  blur_rows(opacity, blurred, 1, m_dimensions.z, m_dimensions.x * m_dimensions.y, radius);
+
+  for (size_t i = 0; i != blurred.size(); ++i) {
+    float v = 1.0f - std::min(std::max(strength * blurred[i], 0.0f), 1.0f);
+    visibility[i] = (unsigned char)(v * 255.0f + 0.5f);
+  }
+
+  return visibility;
+}
@@ -0,0 +1,45 @@
+#ifndef OCCLUSION_VOLUME_HPP
+#define OCCLUSION_VOLUME_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Occlusion_volume
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+// low resolution ambient occlusion, the opacity under the transfer function
+// averaged over a box around each voxel
+class Occlusion_volume
+{
+public:
+  Occlusion_volume();
+
+  void set_volume(volume_data_type const& data, glm::ivec3 const& dimensions,
+                  unsigned byte_per_channel, glm::vec2 const& data_range,
+                  glm::vec3 const& volume_bounds, int max_resolution = 64);
+
+  // ambient visibility (0..255), 1 - strength * mean opacity within radius voxels,
+  // opacities are given per reference_step; safe to call from a worker thread
+  volume_data_type compute(image_data_type const& transfer_function, float reference_step,
+                           int radius, float strength) const;
+
+  glm::ivec3 get_dimensions() const { return m_dimensions; }
+
+private:
+  glm::ivec3       m_dimensions;
+  glm::vec3        m_voxel_size;
+  volume_data_type m_values;
+};
+
+#endif // OCCLUSION_VOLUME_HPP
@@ -0,0 +1,22 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// parallel helpers
+// -----------------------------------------------------------------------------
+
+#include "parallel.hpp"
+#include "thread_pool.hpp"
+
+unsigned get_thread_count()
+{
+  // the calling thread takes part in parallel_for
+  return Thread_pool::instance().get_thread_count() + 1;
+}
+
+void parallel_for(int begin, int end, std::function<void(int, int)> const& body)
+{
+  Thread_pool::instance().parallel_for(begin, end, body);
+}
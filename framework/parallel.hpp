@@ -0,0 +1,21 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// parallel helpers
+// -----------------------------------------------------------------------------
+
+#include <functional>
+
+unsigned get_thread_count();
+
+// splits [begin, end) into ranges processed on the shared Thread_pool and
+// blocks until all of them are done, body(range_begin, range_end)
+void parallel_for(int begin, int end, std::function<void(int, int)> const& body);
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,130 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Pixel_readback
+// -----------------------------------------------------------------------------
+
+#include "pixel_readback.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+Pixel_readback::Pixel_readback(unsigned buffer_count)
+  : m_slots(std::max(buffer_count, 1u))
+  , m_pending()
+  , m_next(0)
+{
+  for (size_t i = 0; i != m_slots.size(); ++i) {
+    m_slots[i].buffer = 0;
+    m_slots[i].capacity = 0;
+    m_slots[i].fence = 0;
+    m_slots[i].size = glm::ivec2(0);
+    m_slots[i].tag = 0;
+  }
+}
+
+bool Pixel_readback::request(glm::ivec2 const& origin, glm::ivec2 const& size, int tag)
+{
+  if (m_pending.size() == m_slots.size() || size.x < 1 || size.y < 1)
+    return false;
+
+  Slot& slot = m_slots[m_next];
+  size_t bytes = size_t(size.x) * size.y * 4;
+
+  if (!slot.buffer)
+    glGenBuffers(1, &slot.buffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  if (slot.capacity < bytes) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, bytes, 0, GL_STREAM_READ);
+    slot.capacity = bytes;
+  }
+
+  // with a pack buffer bound the read returns at once, the pointer is an offset
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(origin.x, origin.y, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.size = size;
+  slot.tag = tag;
+
+  m_pending.push_back(m_next);
+  m_next = (m_next + 1) % m_slots.size();
+  return true;
+}
+
+Pixel_readback::Slot* Pixel_readback::take(bool wait)
+{
+  if (m_pending.empty())
+    return 0;
+
+  Slot& slot = m_slots[m_pending.front()];
+  GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GLuint64(1000000000) : 0);
+  if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+    return 0;
+
+  glDeleteSync(slot.fence);
+  slot.fence = 0;
+  m_pending.pop_front();
+  return &slot;
+}
+
+bool Pixel_readback::copy(Slot const& slot, unsigned char* pixels)
+{
+  size_t bytes = size_t(slot.size.x) * slot.size.y * 4;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+  if (mapped) {
+    std::memcpy(pixels, mapped, bytes);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  return mapped != 0;
+}
+
+bool Pixel_readback::poll(image_data_type& pixels, glm::ivec2& size, int& tag, bool wait)
+{
+  Slot* slot = take(wait);
+  if (!slot)
+    return false;
+
+  size = slot->size;
+  tag = slot->tag;
+  pixels.resize(size_t(size.x) * size.y * 4);
+  return copy(*slot, &pixels[0]);
+}
+
+bool Pixel_readback::poll(unsigned char* pixels, size_t capacity, glm::ivec2& size, int& tag, bool& copied, bool wait)
+{
+  copied = false;
+  Slot* slot = take(wait);
+  if (!slot)
+    return false;
+
+  size = slot->size;
+  tag = slot->tag;
+  if (pixels && capacity >= size_t(size.x) * size.y * 4)
+    copied = copy(*slot, pixels);
+  return true;
+}
+
+void Pixel_readback::free()
+{
+  for (size_t i = 0; i != m_slots.size(); ++i) {
+    if (m_slots[i].fence)
+      glDeleteSync(m_slots[i].fence);
+    if (m_slots[i].buffer)
+      glDeleteBuffers(1, &m_slots[i].buffer);
+    m_slots[i].fence = 0;
+    m_slots[i].buffer = 0;
+    m_slots[i].capacity = 0;
+  }
+  m_pending.clear();
+  m_next = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef PIXEL_READBACK_HPP
+#define PIXEL_READBACK_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Pixel_readback
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+
+#include <deque>
+#include <vector>
+
+// asynchronous RGBA8 reads of the current read framebuffer; the copy goes
+// into a pixel pack buffer guarded by a fence and is fetched frames later,
+// so reading back never waits for the GPU
+class Pixel_readback
+{
+public:
+  explicit Pixel_readback(unsigned buffer_count = 3);
+
+  // queues a read of the rectangle, tag is returned with the pixels; false
+  // while all buffers are in flight
+  bool request(glm::ivec2 const& origin, glm::ivec2 const& size, int tag);
+
+  // oldest read if its copy has finished (or always with wait), rows bottom up
+  bool poll(image_data_type& pixels, glm::ivec2& size, int& tag, bool wait = false);
+
+  // the same into memory of the caller, e.g. shared with another process; true
+  // once a read was taken, copied only if its pixels were written, which they
+  // are not with no pixels, too little capacity or a buffer that failed to map
+  bool poll(unsigned char* pixels, size_t capacity, glm::ivec2& size, int& tag, bool& copied, bool wait = false);
+
+  unsigned get_pending_count() const { return unsigned(m_pending.size()); }
+  void     free();
+
+private:
+  struct Slot
+  {
+    GLuint     buffer;
+    size_t     capacity;
+    GLsync     fence;
+    glm::ivec2 size;
+    int        tag;
+  };
+
+  // the oldest slot once its copy has finished, removed from the pending ones
+  Slot* take(bool wait);
+  bool  copy(Slot const& slot, unsigned char* pixels);
+
+  std::vector<Slot>  m_slots;
+  std::deque<size_t> m_pending;    // slots in request order
+  size_t             m_next;
+};
+
+#endif // PIXEL_READBACK_HPP
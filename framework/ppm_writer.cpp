@@ -0,0 +1,65 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Ppm_writer
+// -----------------------------------------------------------------------------
+
+#include "ppm_writer.hpp"
+
+Ppm_writer::Ppm_writer()
+  : m_file()
+  , m_size(0)
+  , m_rows_written(0)
+{}
+
+bool Ppm_writer::open(std::string const& file_path, glm::ivec2 const& size)
+{
+  close();
+
+  m_file.open(file_path.c_str(), std::ios::out | std::ios::binary);
+  if (!m_file.is_open())
+    return false;
+
+  m_size = size;
+  m_rows_written = 0;
+  m_file << "P6\n" << size.x << " " << size.y << "\n255\n";
+  return m_file.good();
+}
+
+bool Ppm_writer::write_rows(const unsigned char* rgb, unsigned row_count)
+{
+  if (!m_file.is_open())
+    return false;
+
+  m_file.write((const char*)rgb, std::streamsize(m_size.x) * 3 * row_count);
+  m_rows_written += row_count;
+  return m_file.good();
+}
+
+bool Ppm_writer::close()
+{
+  if (!m_file.is_open())
+    return false;
+
+  bool complete = m_file.good() && m_rows_written == unsigned(m_size.y);
+  m_file.close();
+  return complete;
+}
+
+void Ppm_writer::rgba_to_rgb(image_data_type const& rgba, glm::ivec2 const& size,
+                             int first_column, int width, int first_row, int row_count,
+                             unsigned char* rgb, size_t rgb_stride)
+{
+  for (int r = 0; r != row_count; ++r) {
+    const unsigned char* source = &rgba[(size_t(size.y - 1 - (first_row + r)) * size.x + first_column) * 4];
+    unsigned char* target = rgb + r * rgb_stride;
+    for (int x = 0; x != width; ++x) {
+      target[x * 3] = source[x * 4];
+      target[x * 3 + 1] = source[x * 4 + 1];
+      target[x * 3 + 2] = source[x * 4 + 2];
+    }
+  }
+}
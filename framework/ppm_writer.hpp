@@ -0,0 +1,52 @@
+#ifndef PPM_WRITER_HPP
+#define PPM_WRITER_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Ppm_writer
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+
+#include <fstream>
+#include <string>
+
+// binary 8 bit RGB image written row by row from the top, images of any size
+// can be streamed without holding them in memory
+class Ppm_writer
+{
+public:
+  Ppm_writer();
+
+  bool open(std::string const& file_path, glm::ivec2 const& size);
+
+  // rows of size.x RGB pixels, top to bottom; false once an error occurred
+  bool write_rows(const unsigned char* rgb, unsigned row_count);
+
+  // false if fewer rows than the height were written
+  bool close();
+
+  bool       is_open() const { return m_file.is_open(); }
+  glm::ivec2 get_size() const { return m_size; }
+
+  // RGBA rows bottom up (as read back from GL) to RGB rows top down; the
+  // columns [first_column, first_column + width) of rows [first_row, first_row + row_count)
+  // counted from the top
+  static void rgba_to_rgb(image_data_type const& rgba, glm::ivec2 const& size,
+                          int first_column, int width, int first_row, int row_count,
+                          unsigned char* rgb, size_t rgb_stride);
+
+private:
+  std::ofstream m_file;
+  glm::ivec2    m_size;
+  unsigned      m_rows_written;
+};
+
+#endif // PPM_WRITER_HPP
@@ -0,0 +1,61 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Proxy_geometry
+// -----------------------------------------------------------------------------
+
+#include "proxy_geometry.hpp"
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+Proxy_geometry::Proxy_geometry()
+  : m_vao(0)
+  , m_vbo(0)
+  , m_vertex_count(0)
+{}
+
+void Proxy_geometry::update(std::vector<glm::vec3> const& triangles)
+{
+  if (m_vao == 0) {
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+
+    glGenBuffers(1, &m_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
+    glBindVertexArray(0);
+  }
+
+  m_vertex_count = (unsigned)triangles.size();
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * triangles.size(),
+      triangles.empty() ? nullptr : &triangles[0], GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Proxy_geometry::draw() const
+{
+  if (m_vertex_count == 0)
+    return;
+
+  glBindVertexArray(m_vao);
+  glDrawArrays(GL_TRIANGLES, 0, m_vertex_count);
+  glBindVertexArray(0);
+}
+
+void Proxy_geometry::freeVAO()
+{
+  if (m_vbo)
+    glDeleteBuffers(1, &m_vbo);
+  if (m_vao)
+    glDeleteVertexArrays(1, &m_vao);
+  m_vbo = 0;
+  m_vao = 0;
+  m_vertex_count = 0;
+}
@@ -0,0 +1,36 @@
+#ifndef PROXY_GEOMETRY_HPP
+#define PROXY_GEOMETRY_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Proxy_geometry
+// -----------------------------------------------------------------------------
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+// triangle soup with the same position attribute (location 0) as Cube
+class Proxy_geometry
+{
+public:
+  Proxy_geometry();
+
+  void update(std::vector<glm::vec3> const& triangles);
+  void draw() const;
+  void freeVAO();
+
+  unsigned get_vertex_count() const { return m_vertex_count; }
+
+private:
+  unsigned int m_vao;
+  unsigned int m_vbo;
+  unsigned     m_vertex_count;
+};
+
+#endif // PROXY_GEOMETRY_HPP
@@ -0,0 +1,171 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Shared_frame_ring
+// -----------------------------------------------------------------------------
+
+#include "shared_frame_ring.hpp"
+
+#include <chrono>
+#include <new>
+
+namespace {
+
+// slots start on cache lines, so the pixels of one never share a line with
+// the header of the next
+const size_t cache_line = 64;
+
+size_t align(size_t bytes)
+{
+  return (bytes + cache_line - 1) / cache_line * cache_line;
+}
+
+} // namespace
+
+Shared_frame_ring::Shared_frame_ring()
+  : m_memory()
+  , m_header(0)
+  , m_producer(false)
+{}
+
+bool Shared_frame_ring::create(std::string const& name, unsigned slot_count, size_t pixel_capacity)
+{
+  free();
+  if (slot_count == 0)
+    return false;
+
+  size_t slot_offset = align(sizeof(Shared_frame_ring_header));
+  size_t slot_stride = align(pixel_offset + pixel_capacity);
+  if (!m_memory.create(name, slot_offset + slot_stride * slot_count))
+    return false;
+
+  // the fresh object is zero filled, the atomics are constructed in place
+  m_header = new (m_memory.get_data()) Shared_frame_ring_header;
+  m_header->slot_count = slot_count;
+  m_header->slot_offset = slot_offset;
+  m_header->slot_stride = slot_stride;
+  m_header->pixel_capacity = pixel_capacity;
+  m_header->write_index.store(0);
+  m_header->read_index.store(0);
+  m_header->closed.store(0);
+  // readers check the magic last
+  std::atomic_thread_fence(std::memory_order_release);
+  m_header->magic = magic;
+
+  m_producer = true;
+  return true;
+}
+
+bool Shared_frame_ring::open(std::string const& name)
+{
+  free();
+
+  if (!m_memory.open(name))
+    return false;
+
+  Shared_frame_ring_header* header = (Shared_frame_ring_header*)m_memory.get_data();
+  if (m_memory.get_size() < sizeof(Shared_frame_ring_header) || header->magic != magic
+      || m_memory.get_size() < header->slot_offset + header->slot_stride * header->slot_count) {
+    m_memory.free();
+    return false;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  m_header = header;
+  m_producer = false;
+  return true;
+}
+
+void Shared_frame_ring::free()
+{
+  if (m_header && m_producer)
+    m_header->closed.store(1, std::memory_order_release);
+
+  m_memory.free();
+  m_header = 0;
+  m_producer = false;
+}
+
+size_t Shared_frame_ring::get_pixel_capacity() const
+{
+  return m_header ? size_t(m_header->pixel_capacity) : 0;
+}
+
+bool Shared_frame_ring::is_closed() const
+{
+  return !m_header || m_header->closed.load(std::memory_order_acquire) != 0;
+}
+
+Shared_frame_header* Shared_frame_ring::get_slot(std::uint64_t index) const
+{
+  unsigned char* base = (unsigned char*)m_memory.get_data() + m_header->slot_offset;
+  return (Shared_frame_header*)(base + (index % m_header->slot_count) * m_header->slot_stride);
+}
+
+unsigned char* Shared_frame_ring::begin_write()
+{
+  if (!m_header)
+    return 0;
+
+  std::uint64_t write = m_header->write_index.load(std::memory_order_relaxed);
+  std::uint64_t read = m_header->read_index.load(std::memory_order_acquire);
+  if (write - read >= m_header->slot_count)
+    return 0;
+
+  return (unsigned char*)get_slot(write) + pixel_offset;
+}
+
+void Shared_frame_ring::end_write(std::uint64_t frame_id, std::uint64_t timestamp,
+                                  glm::ivec2 const& size, std::uint32_t bytes)
+{
+  std::uint64_t write = m_header->write_index.load(std::memory_order_relaxed);
+  Shared_frame_header* frame = get_slot(write);
+  frame->frame_id = frame_id;
+  frame->timestamp = timestamp;
+  frame->width = std::uint32_t(size.x);
+  frame->height = std::uint32_t(size.y);
+  frame->format = rgba8_bottom_up;
+  frame->bytes = bytes;
+
+  // pixels and header become visible together with the index
+  m_header->write_index.store(write + 1, std::memory_order_release);
+}
+
+Shared_frame_header const* Shared_frame_ring::acquire() const
+{
+  if (!m_header)
+    return 0;
+
+  std::uint64_t read = m_header->read_index.load(std::memory_order_relaxed);
+  std::uint64_t write = m_header->write_index.load(std::memory_order_acquire);
+  return read == write ? 0 : get_slot(read);
+}
+
+const unsigned char* Shared_frame_ring::get_pixels(Shared_frame_header const* frame) const
+{
+  return (const unsigned char*)frame + pixel_offset;
+}
+
+void Shared_frame_ring::release()
+{
+  std::uint64_t read = m_header->read_index.load(std::memory_order_relaxed);
+  if (read != m_header->write_index.load(std::memory_order_acquire))
+    m_header->read_index.store(read + 1, std::memory_order_release);
+}
+
+unsigned Shared_frame_ring::get_pending_count() const
+{
+  if (!m_header)
+    return 0;
+  return unsigned(m_header->write_index.load(std::memory_order_acquire)
+                  - m_header->read_index.load(std::memory_order_acquire));
+}
+
+std::uint64_t Shared_frame_ring::get_timestamp()
+{
+  return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
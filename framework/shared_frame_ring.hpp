@@ -0,0 +1,100 @@
+#ifndef SHARED_FRAME_RING_HPP
+#define SHARED_FRAME_RING_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Shared_frame_ring
+// -----------------------------------------------------------------------------
+
+#include "shared_memory.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// start of the shared object; readers in other languages map the same layout
+// (native byte order, 64 bit lock free atomics)
+struct Shared_frame_ring_header
+{
+  std::uint32_t              magic;           // Shared_frame_ring::magic
+  std::uint32_t              slot_count;
+  std::uint64_t              slot_offset;     // of the first slot
+  std::uint64_t              slot_stride;     // from one slot to the next
+  std::uint64_t              pixel_capacity;  // bytes per slot after its header
+  std::atomic<std::uint64_t> write_index;     // frames published, only the producer stores
+  std::atomic<std::uint64_t> read_index;      // frames consumed, only the consumer stores
+  std::atomic<std::uint32_t> closed;          // the producer went away, reopen by name
+};
+
+// start of a slot, the pixels follow at Shared_frame_ring::pixel_offset
+struct Shared_frame_header
+{
+  std::uint64_t frame_id;
+  std::uint64_t timestamp;  // steady clock nanoseconds when the frame was rendered
+  std::uint32_t width;
+  std::uint32_t height;
+  std::uint32_t format;     // Shared_frame_ring::rgba8_bottom_up
+  std::uint32_t bytes;
+};
+
+// single producer, single consumer ring of frames in POSIX shared memory.
+// The indices only grow; slot index % slot_count is written before the write
+// index is published, and is free again once the read index passed it. The
+// consumer reads frames in place. A full ring makes the producer skip frames
+// instead of waiting
+class Shared_frame_ring
+{
+public:
+  enum { magic = 0x52465653, pixel_offset = 64, rgba8_bottom_up = 0 };
+
+  Shared_frame_ring();
+
+  // producer side, an existing ring of the name is replaced
+  bool create(std::string const& name, unsigned slot_count, size_t pixel_capacity);
+
+  // consumer side
+  bool open(std::string const& name);
+
+  // marks the ring closed for the consumer when producing
+  void free();
+
+  bool   is_open() const { return m_header != 0; }
+  size_t get_pixel_capacity() const;
+  bool   is_closed() const;
+
+  // pixels of the next slot to fill, 0 while all slots hold unread frames
+  unsigned char* begin_write();
+  // publishes the slot returned by begin_write
+  void           end_write(std::uint64_t frame_id, std::uint64_t timestamp,
+                           glm::ivec2 const& size, std::uint32_t bytes);
+
+  // oldest unread frame in place, 0 if none; stays valid until release
+  Shared_frame_header const* acquire() const;
+  const unsigned char*       get_pixels(Shared_frame_header const* frame) const;
+  void                       release();
+
+  // unread frames
+  unsigned get_pending_count() const;
+
+  // for timestamps comparable between processes on the same machine
+  static std::uint64_t get_timestamp();
+
+private:
+  Shared_frame_ring(Shared_frame_ring const&);
+  Shared_frame_ring& operator=(Shared_frame_ring const&);
+
+  Shared_frame_header* get_slot(std::uint64_t index) const;
+
+  Shared_memory             m_memory;
+  Shared_frame_ring_header* m_header;
+  bool                      m_producer;
+};
+
+#endif // SHARED_FRAME_RING_HPP
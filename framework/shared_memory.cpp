@@ -0,0 +1,106 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Shared_memory
+// -----------------------------------------------------------------------------
+
+#include "shared_memory.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Shared_memory::Shared_memory()
+  : m_name()
+  , m_data(0)
+  , m_size(0)
+  , m_owner(false)
+{}
+
+Shared_memory::~Shared_memory()
+{
+  free();
+}
+
+bool Shared_memory::create(std::string const& name, size_t bytes)
+{
+  free();
+
+#ifndef _WIN32
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+    return false;
+
+  void* data = MAP_FAILED;
+  if (ftruncate(fd, off_t(bytes)) == 0)
+    data = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  // the mapping stays valid without the descriptor
+  close(fd);
+
+  if (data == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  m_name = name;
+  m_data = data;
+  m_size = bytes;
+  m_owner = true;
+  return true;
+#else
+  (void)name;
+  (void)bytes;
+  return false;
+#endif
+}
+
+bool Shared_memory::open(std::string const& name)
+{
+  free();
+
+#ifndef _WIN32
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0)
+    return false;
+
+  struct stat status;
+  void* data = MAP_FAILED;
+  if (fstat(fd, &status) == 0 && status.st_size > 0)
+    data = mmap(0, size_t(status.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (data == MAP_FAILED)
+    return false;
+
+  m_name = name;
+  m_data = data;
+  m_size = size_t(status.st_size);
+  m_owner = false;
+  return true;
+#else
+  (void)name;
+  return false;
+#endif
+}
+
+void Shared_memory::free()
+{
+#ifndef _WIN32
+  if (m_data) {
+    munmap(m_data, m_size);
+    if (m_owner)
+      shm_unlink(m_name.c_str());
+  }
+#endif
+  m_name.clear();
+  m_data = 0;
+  m_size = 0;
+  m_owner = false;
+}
@@ -0,0 +1,48 @@
+#ifndef SHARED_MEMORY_HPP
+#define SHARED_MEMORY_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Shared_memory
+// -----------------------------------------------------------------------------
+
+#include <string>
+
+// named POSIX shared memory object mapped into this process, other processes
+// open it by name with shm_open; not available on Windows
+class Shared_memory
+{
+public:
+  Shared_memory();
+  ~Shared_memory();
+
+  // name starts with a slash, e.g. "/scivis_frame"; an existing object of the
+  // name is replaced. False (and nothing mapped) on failure
+  bool create(std::string const& name, size_t bytes);
+
+  // maps an object created by another process, read and write
+  bool open(std::string const& name);
+
+  // unmaps; the creator also removes the name, others keep their mappings
+  void free();
+
+  bool               is_mapped() const { return m_data != 0; }
+  void*              get_data() const { return m_data; }
+  size_t             get_size() const { return m_size; }
+  std::string const& get_name() const { return m_name; }
+
+private:
+  Shared_memory(Shared_memory const&);
+  Shared_memory& operator=(Shared_memory const&);
+
+  std::string m_name;
+  void*       m_data;
+  size_t      m_size;
+  bool        m_owner;
+};
+
+#endif // SHARED_MEMORY_HPP
@@ -0,0 +1,346 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Slab_projector
+// -----------------------------------------------------------------------------
+
+#include "slab_projector.hpp"
+#include "parallel.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SLAB_PROJECTOR_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include <glm/common.hpp>
+
+namespace {
+
+// texture units of a stored value, normalized for 8 and 16 bit
+template<typename T> float get_scale() { return 1.0f; }
+template<> float get_scale<unsigned char>() { return 1.0f / 255.0f; }
+template<> float get_scale<unsigned short>() { return 1.0f / 65535.0f; }
+
+// running sums of the average, integer formats cannot overflow below 65536 layers
+template<typename T> struct Sum { typedef unsigned type; };
+template<> struct Sum<float> { typedef float type; };
+
+// values in one 16 byte register
+template<typename T> struct Lanes { enum { count = 16 / sizeof(T) }; };
+
+// acc = max(acc, in) / min(acc, in) / acc + in over n values
+
+inline void max_row(unsigned char* acc, const unsigned char* in, int n)
+{
+  int i = 0;
+#ifdef SLAB_PROJECTOR_SSE2
+  for (; i + 16 <= n; i += 16)
+    _mm_storeu_si128((__m128i*)(acc + i), _mm_max_epu8(_mm_loadu_si128((const __m128i*)(acc + i)),
+                                                       _mm_loadu_si128((const __m128i*)(in + i))));
+#endif
+  for (; i < n; ++i)
+    acc[i] = std::max(acc[i], in[i]);
+}
+
+inline void min_row(unsigned char* acc, const unsigned char* in, int n)
+{
+  int i = 0;
+#ifdef SLAB_PROJECTOR_SSE2
+  for (; i + 16 <= n; i += 16)
+    _mm_storeu_si128((__m128i*)(acc + i), _mm_min_epu8(_mm_loadu_si128((const __m128i*)(acc + i)),
+                                                       _mm_loadu_si128((const __m128i*)(in + i))));
+#endif
+  for (; i < n; ++i)
+    acc[i] = std::min(acc[i], in[i]);
+}
+
+inline void add_row(unsigned* acc, const unsigned char* in, int n)
+{
+  int i = 0;
+#ifdef SLAB_PROJECTOR_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    __m128i bytes = _mm_loadu_si128((const __m128i*)(in + i));
+    __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    __m128i words[4] = { _mm_unpacklo_epi16(low, zero), _mm_unpackhi_epi16(low, zero),
+                         _mm_unpacklo_epi16(high, zero), _mm_unpackhi_epi16(high, zero) };
+    for (int k = 0; k != 4; ++k) {
+      __m128i* a = (__m128i*)(acc + i + 4 * k);
+      _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), words[k]));
+    }
+  }
+#endif
+  for (; i < n; ++i)
+    acc[i] += in[i];
+}
+
+// SSE2 only compares signed 16 bit words, the sign bit is flipped around it
+inline void max_row(unsigned short* acc, const unsigned short* in, int n)
+{
+  int i = 0;
+#ifdef SLAB_PROJECTOR_SSE2
+  const __m128i bias = _mm_set1_epi16(short(0x8000));
+  for (; i + 8 <= n; i += 8) {
+    __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(acc + i)), bias);
+    __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + i)), bias);
+    _mm_storeu_si128((__m128i*)(acc + i), _mm_xor_si128(_mm_max_epi16(a, b), bias));
+  }
+#endif
+  for (; i < n; ++i)
+    acc[i] = std::max(acc[i], in[i]);
+}
+
+inline void min_row(unsigned short* acc, const unsigned short* in, int n)
+{
+  int i = 0;
+#ifdef SLAB_PROJECTOR_SSE2
+  const __m128i bias = _mm_set1_epi16(short(0x8000));
+  for (; i + 8 <= n; i += 8) {
+    __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(acc + i)), bias);
+    __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + i)), bias);
+    _mm_storeu_si128((__m128i*)(acc + i), _mm_xor_si128(_mm_min_epi16(a, b), bias));
+  }
+#endif
+  for (; i < n; ++i)
+    acc[i] = std::min(acc[i], in[i]);
+}
+
+inline void add_row(unsigned* acc, const unsigned short* in, int n)
+{
+  int i = 0;
+#ifdef SLAB_PROJECTOR_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= n; i += 8) {
+    __m128i words = _mm_loadu_si128((const __m128i*)(in + i));
+    __m128i* a = (__m128i*)(acc + i);
+    _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_unpacklo_epi16(words, zero)));
+    _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_unpackhi_epi16(words, zero)));
+  }
+#endif
+  for (; i < n; ++i)
+    acc[i] += in[i];
+}
+
+inline void max_row(float* acc, const float* in, int n)
+{
+  int i = 0;
+#ifdef SLAB_PROJECTOR_SSE2
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(acc + i, _mm_max_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(in + i)));
+#endif
+  for (; i < n; ++i)
+    acc[i] = std::max(acc[i], in[i]);
+}
+
+inline void min_row(float* acc, const float* in, int n)
+{
+  int i = 0;
+#ifdef SLAB_PROJECTOR_SSE2
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(acc + i, _mm_min_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(in + i)));
+#endif
+  for (; i < n; ++i)
+    acc[i] = std::min(acc[i], in[i]);
+}
+
+inline void add_row(float* acc, const float* in, int n)
+{
+  int i = 0;
+#ifdef SLAB_PROJECTOR_SSE2
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(in + i)));
+#endif
+  for (; i < n; ++i)
+    acc[i] += in[i];
+}
+
+struct Window
+{
+  float gain;     // native value to 0..255, value * gain - offset
+  float offset;
+
+  unsigned char operator()(float value) const
+  {
+    return (unsigned char)(std::min(std::max(value * gain - offset, 0.0f), 255.0f) + 0.5f);
+  }
+};
+
+// reduction of n contiguous values, one register of lanes at a time and the
+// lanes at the end
+template<typename T>
+float reduce_run(const T* in, int n, Slab_projector::Mode mode)
+{
+  const int w = Lanes<T>::count;
+  int i = 0;
+
+  if (mode == Slab_projector::average) {
+    typename Sum<T>::type lanes[w] = {};
+    for (; i + w <= n; i += w)
+      add_row(lanes, in + i, w);
+    typename Sum<T>::type sum = 0;
+    for (int l = 0; l != w; ++l)
+      sum += lanes[l];
+    for (; i < n; ++i)
+      sum += in[i];
+    return float(sum) / float(n);
+  }
+
+  T lanes[w];
+  std::fill(lanes, lanes + w, in[0]);
+  for (; i + w <= n; i += w) {
+    if (mode == Slab_projector::maximum)
+      max_row(lanes, in + i, w);
+    else
+      min_row(lanes, in + i, w);
+  }
+  for (; i < n; ++i)
+    lanes[i % w] = (mode == Slab_projector::maximum) ? std::max(lanes[i % w], in[i])
+                                                     : std::min(lanes[i % w], in[i]);
+  T result = lanes[0];
+  for (int l = 1; l != w; ++l)
+    result = (mode == Slab_projector::maximum) ? std::max(result, lanes[l]) : std::min(result, lanes[l]);
+  return float(result);
+}
+
+// reduces the rows rows[0 .. count) of width values elementwise into out;
+// rows are apart by stride values
+template<typename T>
+void reduce_rows(const T* rows, size_t stride, int count, int width, Slab_projector::Mode mode,
+                 Window const& window, std::vector<T>& acc,
+                 std::vector<typename Sum<T>::type>& sum, unsigned char* out)
+{
+  if (mode == Slab_projector::average) {
+    sum.assign(width, 0);
+    for (int k = 0; k != count; ++k)
+      add_row(&sum[0], rows + k * stride, width);
+    float inverse = 1.0f / float(count);
+    for (int x = 0; x != width; ++x)
+      out[x] = window(float(sum[x]) * inverse);
+    return;
+  }
+
+  acc.assign(rows, rows + width);
+  for (int k = 1; k != count; ++k) {
+    if (mode == Slab_projector::maximum)
+      max_row(&acc[0], rows + k * stride, width);
+    else
+      min_row(&acc[0], rows + k * stride, width);
+  }
+  for (int x = 0; x != width; ++x)
+    out[x] = window(float(acc[x]));
+}
+
+template<typename T>
+void project(const T* data, glm::ivec3 const& d, int axis, int first, int count,
+             Slab_projector::Mode mode, Window const& window, unsigned char* out)
+{
+  size_t stride_y = size_t(d.x);
+  size_t stride_z = size_t(d.x) * d.y;
+
+  if (axis == 2) {
+    // image rows are volume rows, the slab is walked a whole layer apart
+    parallel_for(0, d.y, [&](int begin, int end) {
+      std::vector<T> acc;
+      std::vector<typename Sum<T>::type> sum;
+      for (int y = begin; y != end; ++y)
+        reduce_rows(data + first * stride_z + y * stride_y, stride_z, count, d.x, mode, window,
+                    acc, sum, out + size_t(y) * d.x);
+    });
+  }
+  else if (axis == 1) {
+    // image row z, consecutive rows of one layer
+    parallel_for(0, d.z, [&](int begin, int end) {
+      std::vector<T> acc;
+      std::vector<typename Sum<T>::type> sum;
+      for (int z = begin; z != end; ++z)
+        reduce_rows(data + z * stride_z + first * stride_y, stride_y, count, d.x, mode, window,
+                    acc, sum, out + size_t(z) * d.x);
+    });
+  }
+  else {
+    // the slab is a contiguous run within every volume row
+    parallel_for(0, d.z, [&](int begin, int end) {
+      for (int z = begin; z != end; ++z)
+        for (int y = 0; y != d.y; ++y)
+          out[size_t(z) * d.y + y] = window(reduce_run(data + z * stride_z + y * stride_y + first, count, mode));
+    });
+  }
+}
+
+Window get_window(float scale, glm::vec2 const& data_range)
+{
+  float range = std::max(data_range.y - data_range.x, 1e-12f);
+  Window window;
+  window.gain = scale / range * 255.0f;
+  window.offset = data_range.x / range * 255.0f;
+  return window;
+}
+
+} // namespace
+
+void Slab_projector::project_axis(volume_data_type const& data, glm::ivec3 const& dimensions,
+                                  unsigned byte_per_channel, glm::vec2 const& data_range,
+                                  int axis, int first, int last, Mode mode,
+                                  image_data_type& out, glm::ivec2& size)
+{
+  axis = std::min(std::max(axis, 0), 2);
+  size = axis == 0 ? glm::ivec2(dimensions.y, dimensions.z)
+       : axis == 1 ? glm::ivec2(dimensions.x, dimensions.z)
+                   : glm::ivec2(dimensions.x, dimensions.y);
+  size = glm::max(size, glm::ivec2(0));
+  out.assign(size_t(size.x) * size.y, 0);
+
+  first = std::max(first, 0);
+  last = std::min(last, dimensions[axis]);
+  if (out.empty() || data.empty() || first >= last)
+    return;
+
+  if (byte_per_channel == 2)
+    project((const unsigned short*)&data[0], dimensions, axis, first, last - first, mode,
+            get_window(get_scale<unsigned short>(), data_range), &out[0]);
+  else if (byte_per_channel == 4)
+    project((const float*)&data[0], dimensions, axis, first, last - first, mode,
+            get_window(get_scale<float>(), data_range), &out[0]);
+  else
+    project(&data[0], dimensions, axis, first, last - first, mode,
+            get_window(get_scale<unsigned char>(), data_range), &out[0]);
+}
+
+void Slab_projector::project_plane(volume_data_type const& data, glm::ivec3 const& dimensions,
+                                   unsigned byte_per_channel, glm::vec2 const& data_range,
+                                   Slice_plane const& plane, glm::vec3 const& step, int count,
+                                   glm::ivec2 const& size, Mode mode, image_data_type& out)
+{
+  out.assign(size_t(std::max(size.x, 0)) * std::max(size.y, 0), 0);
+  if (out.empty() || count < 1)
+    return;
+
+  // slices are already windowed, which only changes averages over clamped values
+  image_data_type slice;
+  std::vector<unsigned> sum(mode == average ? out.size() : 0, 0);
+  for (int k = 0; k != count; ++k) {
+    Slice_plane layer = plane;
+    layer.origin += float(k) * step;
+    Slice_extractor::extract(data, dimensions, byte_per_channel, data_range, layer, size, slice);
+
+    if (mode == average)
+      add_row(&sum[0], &slice[0], int(slice.size()));
+    else if (k == 0)
+      out.swap(slice);
+    else if (mode == maximum)
+      max_row(&out[0], &slice[0], int(slice.size()));
+    else
+      min_row(&out[0], &slice[0], int(slice.size()));
+  }
+
+  if (mode == average)
+    for (size_t i = 0; i != out.size(); ++i)
+      out[i] = (unsigned char)((sum[i] + count / 2) / count);
+}
@@ -0,0 +1,43 @@
+#ifndef SLAB_PROJECTOR_HPP
+#define SLAB_PROJECTOR_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Slab_projector
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+#include "slice_extractor.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+// thick slab projections of a single channel volume into 8 bit images of the
+// windowed values
+class Slab_projector
+{
+public:
+  enum Mode { maximum, minimum, average };
+
+  // reduces the voxels [first, last) along axis (0 x, 1 y, 2 z) in their stored
+  // format, 16 bytes at a time; the image spans the two remaining axes with
+  // the lower one along the rows, its size is returned in size
+  static void project_axis(volume_data_type const& data, glm::ivec3 const& dimensions,
+                           unsigned byte_per_channel, glm::vec2 const& data_range,
+                           int axis, int first, int last, Mode mode,
+                           image_data_type& out, glm::ivec2& size);
+
+  // any orientation: count trilinear slices of plane, each shifted by step
+  // voxels, reduced per pixel
+  static void project_plane(volume_data_type const& data, glm::ivec3 const& dimensions,
+                            unsigned byte_per_channel, glm::vec2 const& data_range,
+                            Slice_plane const& plane, glm::vec3 const& step, int count,
+                            glm::ivec2 const& size, Mode mode, image_data_type& out);
+};
+
+#endif // SLAB_PROJECTOR_HPP
@@ -0,0 +1,226 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Slice_extractor
+// -----------------------------------------------------------------------------
+
+#include "slice_extractor.hpp"
+#include "parallel.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SLICE_EXTRACTOR_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/common.hpp>
+
+namespace {
+
+// texture units of a stored value, normalized for 8 and 16 bit
+template<typename T> float get_scale() { return 1.0f; }
+template<> float get_scale<unsigned char>() { return 1.0f / 255.0f; }
+template<> float get_scale<unsigned short>() { return 1.0f / 65535.0f; }
+
+struct Row_setup
+{
+  glm::ivec3 dimensions;
+  glm::ivec3 last;         // highest lower corner, dimensions - 2 clamped to 0
+  glm::ivec3 step;         // 0 along axes with a single voxel
+  size_t     stride_y;
+  size_t     stride_z;
+  float      offset;       // windowing, value * scale * gain - offset
+  float      gain;
+};
+
+// scalar version of one pixel, also used for row tails
+template<typename T>
+unsigned char sample(const T* data, Row_setup const& s, glm::vec3 const& p)
+{
+  glm::vec3 extent = glm::vec3(s.dimensions) - 0.5f;
+  if (p.x < -0.5f || p.y < -0.5f || p.z < -0.5f || p.x > extent.x || p.y > extent.y || p.z > extent.z)
+    return 0;
+
+  glm::vec3 c = glm::min(glm::max(p, glm::vec3(0.0f)), glm::vec3(s.dimensions - 1));
+  glm::vec3 f0 = glm::min(glm::floor(c), glm::vec3(s.last));
+  glm::vec3 f = c - f0;
+  glm::ivec3 i(f0);
+
+  size_t base = i.x + i.y * s.stride_y + i.z * s.stride_z;
+  size_t sx = s.step.x;
+  size_t sy = s.step.y * s.stride_y;
+  size_t sz = s.step.z * s.stride_z;
+
+  float c00 = data[base] + (data[base + sx] - float(data[base])) * f.x;
+  float c10 = data[base + sy] + (data[base + sy + sx] - float(data[base + sy])) * f.x;
+  float c01 = data[base + sz] + (data[base + sz + sx] - float(data[base + sz])) * f.x;
+  float c11 = data[base + sz + sy] + (data[base + sz + sy + sx] - float(data[base + sz + sy])) * f.x;
+
+  float c0 = c00 + (c10 - c00) * f.y;
+  float c1 = c01 + (c11 - c01) * f.y;
+  float value = (c0 + (c1 - c0) * f.z) * s.gain - s.offset;
+
+  return (unsigned char)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+template<typename T>
+void extract_row(const T* data, Row_setup const& s, glm::vec3 const& start, glm::vec3 const& u,
+                 int width, unsigned char* out)
+{
+  int x = 0;
+
+#ifdef SLICE_EXTRACTOR_SSE2
+  // four neighbouring pixels per iteration, their positions advance by 4 u
+  __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+  __m128 px = _mm_add_ps(_mm_set1_ps(start.x), _mm_mul_ps(lanes, _mm_set1_ps(u.x)));
+  __m128 py = _mm_add_ps(_mm_set1_ps(start.y), _mm_mul_ps(lanes, _mm_set1_ps(u.y)));
+  __m128 pz = _mm_add_ps(_mm_set1_ps(start.z), _mm_mul_ps(lanes, _mm_set1_ps(u.z)));
+  const __m128 ux = _mm_set1_ps(4.0f * u.x);
+  const __m128 uy = _mm_set1_ps(4.0f * u.y);
+  const __m128 uz = _mm_set1_ps(4.0f * u.z);
+
+  const __m128 low = _mm_set1_ps(-0.5f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 high[3] = { _mm_set1_ps(s.dimensions.x - 0.5f), _mm_set1_ps(s.dimensions.y - 0.5f),
+                           _mm_set1_ps(s.dimensions.z - 0.5f) };
+  const __m128 top[3] = { _mm_set1_ps(float(s.dimensions.x - 1)), _mm_set1_ps(float(s.dimensions.y - 1)),
+                          _mm_set1_ps(float(s.dimensions.z - 1)) };
+  const __m128 last[3] = { _mm_set1_ps(float(s.last.x)), _mm_set1_ps(float(s.last.y)),
+                           _mm_set1_ps(float(s.last.z)) };
+  const __m128 gain = _mm_set1_ps(s.gain * 255.0f);
+  const __m128 offset = _mm_set1_ps(s.offset * 255.0f - 0.5f);
+  const __m128 max_value = _mm_set1_ps(255.5f);
+
+  size_t sx = s.step.x;
+  size_t sy = s.step.y * s.stride_y;
+  size_t sz = s.step.z * s.stride_z;
+
+  for (; x + 4 <= width; x += 4) {
+    __m128 p[3] = { px, py, pz };
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    __m128 frac[3];
+    int corner[3][4];
+
+    for (int a = 0; a != 3; ++a) {
+      inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(p[a], low), _mm_cmple_ps(p[a], high[a])));
+      __m128 c = _mm_min_ps(_mm_max_ps(p[a], zero), top[a]);
+      __m128 f0 = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(c)), last[a]);
+      frac[a] = _mm_sub_ps(c, f0);
+      _mm_storeu_si128((__m128i*)corner[a], _mm_cvttps_epi32(f0));
+    }
+
+    // no gathers in SSE2, the eight corners are loaded per lane
+    float v[8][4];
+    for (int l = 0; l != 4; ++l) {
+      size_t base = corner[0][l] + corner[1][l] * s.stride_y + corner[2][l] * s.stride_z;
+      v[0][l] = data[base];
+      v[1][l] = data[base + sx];
+      v[2][l] = data[base + sy];
+      v[3][l] = data[base + sy + sx];
+      v[4][l] = data[base + sz];
+      v[5][l] = data[base + sz + sx];
+      v[6][l] = data[base + sz + sy];
+      v[7][l] = data[base + sz + sy + sx];
+    }
+
+    __m128 c[8];
+    for (int k = 0; k != 8; ++k)
+      c[k] = _mm_loadu_ps(v[k]);
+
+    __m128 c00 = _mm_add_ps(c[0], _mm_mul_ps(_mm_sub_ps(c[1], c[0]), frac[0]));
+    __m128 c10 = _mm_add_ps(c[2], _mm_mul_ps(_mm_sub_ps(c[3], c[2]), frac[0]));
+    __m128 c01 = _mm_add_ps(c[4], _mm_mul_ps(_mm_sub_ps(c[5], c[4]), frac[0]));
+    __m128 c11 = _mm_add_ps(c[6], _mm_mul_ps(_mm_sub_ps(c[7], c[6]), frac[0]));
+    __m128 c0 = _mm_add_ps(c00, _mm_mul_ps(_mm_sub_ps(c10, c00), frac[1]));
+    __m128 c1 = _mm_add_ps(c01, _mm_mul_ps(_mm_sub_ps(c11, c01), frac[1]));
+    __m128 value = _mm_add_ps(c0, _mm_mul_ps(_mm_sub_ps(c1, c0), frac[2]));
+
+    // window, round and clamp to 0..255, pixels outside the volume stay black
+    value = _mm_sub_ps(_mm_mul_ps(value, gain), offset);
+    value = _mm_and_ps(_mm_min_ps(_mm_max_ps(value, zero), max_value), inside);
+    __m128i bytes = _mm_cvttps_epi32(value);
+    bytes = _mm_packs_epi32(bytes, bytes);
+    bytes = _mm_packus_epi16(bytes, bytes);
+    int packed = _mm_cvtsi128_si32(bytes);
+    out[x] = (unsigned char)(packed & 0xFF);
+    out[x + 1] = (unsigned char)((packed >> 8) & 0xFF);
+    out[x + 2] = (unsigned char)((packed >> 16) & 0xFF);
+    out[x + 3] = (unsigned char)((packed >> 24) & 0xFF);
+
+    px = _mm_add_ps(px, ux);
+    py = _mm_add_ps(py, uy);
+    pz = _mm_add_ps(pz, uz);
+  }
+#endif
+
+  for (; x < width; ++x)
+    out[x] = sample(data, s, start + float(x) * u);
+}
+
+template<typename T>
+void extract_slice(const T* data, Row_setup const& s, Slice_plane const& plane,
+                   glm::ivec2 const& size, unsigned char* out)
+{
+  parallel_for(0, size.y, [&](int first, int last) {
+    for (int y = first; y != last; ++y)
+      extract_row(data, s, plane.origin + float(y) * plane.v, plane.u, size.x, out + size_t(y) * size.x);
+  });
+}
+
+} // namespace
+
+Slice_plane Slice_plane::make(glm::vec3 const& center, glm::vec3 const& axis_u, glm::vec3 const& axis_v,
+                              float extent, int resolution, glm::ivec3 const& dimensions,
+                              glm::vec3 const& volume_bounds)
+{
+  resolution = std::max(resolution, 1);
+  glm::vec3 to_voxel = glm::vec3(dimensions) / volume_bounds;
+  float pixel = extent / float(resolution);
+
+  // pixel centers, the first one half a pixel inside the corner
+  glm::vec3 corner = center + (0.5f * pixel - 0.5f * extent) * (axis_u + axis_v);
+
+  Slice_plane plane;
+  plane.origin = corner * to_voxel - 0.5f;
+  plane.u = axis_u * pixel * to_voxel;
+  plane.v = axis_v * pixel * to_voxel;
+  return plane;
+}
+
+void Slice_extractor::extract(volume_data_type const& data, glm::ivec3 const& dimensions,
+                              unsigned byte_per_channel, glm::vec2 const& data_range,
+                              Slice_plane const& plane, glm::ivec2 const& size,
+                              image_data_type& out)
+{
+  out.assign(size_t(std::max(size.x, 0)) * std::max(size.y, 0), 0);
+  if (out.empty() || data.empty() || dimensions.x < 1 || dimensions.y < 1 || dimensions.z < 1)
+    return;
+
+  Row_setup s;
+  s.dimensions = dimensions;
+  s.last = glm::max(dimensions - 2, glm::ivec3(0));
+  s.step = glm::ivec3(dimensions.x > 1, dimensions.y > 1, dimensions.z > 1);
+  s.stride_y = size_t(dimensions.x);
+  s.stride_z = size_t(dimensions.x) * dimensions.y;
+
+  float range = std::max(data_range.y - data_range.x, 1e-12f);
+  s.offset = data_range.x / range;
+
+  if (byte_per_channel == 2) {
+    s.gain = get_scale<unsigned short>() / range;
+    extract_slice((const unsigned short*)&data[0], s, plane, size, &out[0]);
+  }
+  else if (byte_per_channel == 4) {
+    s.gain = get_scale<float>() / range;
+    extract_slice((const float*)&data[0], s, plane, size, &out[0]);
+  }
+  else {
+    s.gain = get_scale<unsigned char>() / range;
+    extract_slice(&data[0], s, plane, size, &out[0]);
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef SLICE_EXTRACTOR_HPP
+#define SLICE_EXTRACTOR_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Slice_extractor
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+// planar slice in voxel coordinates (voxel centers at integers),
+// pixel (i, j) lies at origin + i * u + j * v
+struct Slice_plane
+{
+  glm::vec3 origin;
+  glm::vec3 u;
+  glm::vec3 v;
+
+  // square slice through center (object space, like the proxy geometry) spanned
+  // by the unit directions axis_u and axis_v over extent object units
+  static Slice_plane make(glm::vec3 const& center, glm::vec3 const& axis_u, glm::vec3 const& axis_v,
+                          float extent, int resolution, glm::ivec3 const& dimensions,
+                          glm::vec3 const& volume_bounds);
+};
+
+// trilinear reformation of a single channel volume into an 8 bit image of the
+// windowed values; pixels outside the volume are 0
+class Slice_extractor
+{
+public:
+  // rows are processed in parallel, each walks the plane incrementally
+  static void extract(volume_data_type const& data, glm::ivec3 const& dimensions,
+                      unsigned byte_per_channel, glm::vec2 const& data_range,
+                      Slice_plane const& plane, glm::ivec2 const& size,
+                      image_data_type& out);
+};
+
+#endif // SLICE_EXTRACTOR_HPP
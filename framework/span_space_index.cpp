@@ -0,0 +1,78 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Span_space_index
+// -----------------------------------------------------------------------------
+
+#include "span_space_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+Span_space_index::Span_space_index()
+  : m_bricks()
+  , m_max()
+  , m_bucket_offsets()
+{
+  m_bucket_offsets.fill(0);
+}
+
+void Span_space_index::build(Brick_grid const& brick_grid)
+{
+  glm::ivec3 count = brick_grid.get_brick_count();
+  unsigned brick_total = count.x * count.y * count.z;
+
+  m_bricks.clear();
+  m_bucket_offsets.fill(0);
+
+  // counting sort by min value, bricks without data (min > max) are left out
+  for (unsigned b = 0; b != brick_total; ++b) {
+    if (brick_grid.get_min(b) <= brick_grid.get_max(b))
+      ++m_bucket_offsets[brick_grid.get_min(b) + 1];
+  }
+  for (unsigned i = 1; i != m_bucket_offsets.size(); ++i) {
+    m_bucket_offsets[i] += m_bucket_offsets[i - 1];
+  }
+
+  m_bricks.resize(m_bucket_offsets[256]);
+  std::array<unsigned, 257> fill = m_bucket_offsets;
+  for (unsigned b = 0; b != brick_total; ++b) {
+    if (brick_grid.get_min(b) <= brick_grid.get_max(b))
+      m_bricks[fill[brick_grid.get_min(b)]++] = b;
+  }
+
+  for (unsigned i = 0; i != 256; ++i) {
+    std::sort(m_bricks.begin() + m_bucket_offsets[i], m_bricks.begin() + m_bucket_offsets[i + 1],
+        [&brick_grid](unsigned a, unsigned b) { return brick_grid.get_max(a) > brick_grid.get_max(b); });
+  }
+
+  m_max.resize(m_bricks.size());
+  for (unsigned i = 0; i != m_bricks.size(); ++i) {
+    m_max[i] = brick_grid.get_max(m_bricks[i]);
+  }
+}
+
+std::vector<unsigned> Span_space_index::query(float value) const
+{
+  std::vector<unsigned> result;
+
+  if (value < 0.0f || value > 255.0f)
+    return result;
+
+  // min and max are integers: min <= value <=> min <= floor, max >= value <=> max >= ceil
+  unsigned last_bucket = (unsigned)std::floor(value);
+  unsigned char lowest_max = (unsigned char)std::ceil(value);
+
+  for (unsigned bucket = 0; bucket <= last_bucket; ++bucket) {
+    for (unsigned i = m_bucket_offsets[bucket]; i != m_bucket_offsets[bucket + 1]; ++i) {
+      if (m_max[i] < lowest_max)
+        break;
+      result.push_back(m_bricks[i]);
+    }
+  }
+
+  return result;
+}
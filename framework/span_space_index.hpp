@@ -0,0 +1,39 @@
+#ifndef SPAN_SPACE_INDEX_HPP
+#define SPAN_SPACE_INDEX_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Span_space_index
+// -----------------------------------------------------------------------------
+
+#include "brick_grid.hpp"
+
+#include <array>
+#include <vector>
+
+// bricks bucketed by their 8 bit min value and sorted by descending max value
+// within a bucket, so the bricks containing a value are a prefix of every
+// bucket at or below it
+class Span_space_index
+{
+public:
+  Span_space_index();
+
+  void build(Brick_grid const& brick_grid);
+
+  // bricks with min <= value <= max, value in 0..255
+  std::vector<unsigned> query(float value) const;
+
+  size_t get_size() const { return m_bricks.size(); }
+
+private:
+  std::vector<unsigned>         m_bricks;
+  std::vector<unsigned char>    m_max;
+  std::array<unsigned, 257>     m_bucket_offsets;
+};
+
+#endif // SPAN_SPACE_INDEX_HPP
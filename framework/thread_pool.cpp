@@ -0,0 +1,244 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Thread_pool
+// -----------------------------------------------------------------------------
+
+#include "thread_pool.hpp"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+
+// a task starts once pending drops to zero, one count is held while it is scheduled
+struct Thread_pool::Task
+{
+  std::function<void()>    work;
+  std::atomic<int>         pending;
+  std::mutex               mutex;
+  bool                     finished;
+  std::vector<task_handle> dependents;
+};
+
+namespace {
+
+// queue of the worker running on this thread, workers push to their own queue
+thread_local Thread_pool const* t_pool = 0;
+thread_local unsigned           t_queue = 0;
+
+// chunks are claimed through a counter, so whoever is free takes the next one
+struct Parallel_for_state
+{
+  std::function<void(int, int)> body;
+  int                           begin;
+  int                           end;
+  int                           chunk;
+  int                           chunks;
+  std::atomic<int>              next;
+  std::atomic<int>              done;
+
+  void run()
+  {
+    for (int c = next++; c < chunks; c = next++) {
+      int b = begin + c * chunk;
+      body(b, std::min(b + chunk, end));
+      ++done;
+    }
+  }
+};
+
+} // namespace
+
+Thread_pool::Thread_pool(unsigned thread_count)
+  : m_queues()
+  , m_threads()
+  , m_wake_mutex()
+  , m_wake()
+  , m_queued(0)
+  , m_next_queue(0)
+  , m_stop(false)
+{
+  if (thread_count == 0)
+    thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+  for (unsigned i = 0; i != thread_count; ++i)
+    m_queues.push_back(std::unique_ptr<Worker_queue>(new Worker_queue));
+
+  for (unsigned i = 0; i != thread_count; ++i)
+    m_threads.push_back(std::thread(&Thread_pool::worker, this, i));
+}
+
+Thread_pool::~Thread_pool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_wake_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+
+  for (std::vector<std::thread>::iterator t = m_threads.begin(); t != m_threads.end(); ++t)
+    t->join();
+}
+
+Thread_pool& Thread_pool::instance()
+{
+  static Thread_pool pool;
+  return pool;
+}
+
+Thread_pool::task_handle Thread_pool::create_task(std::function<void()> const& work)
+{
+  task_handle task = std::make_shared<Task>();
+  task->work = work;
+  task->pending = 1;
+  task->finished = false;
+  return task;
+}
+
+void Thread_pool::schedule(task_handle const& task, std::vector<task_handle> const& after)
+{
+  for (std::vector<task_handle>::const_iterator d = after.begin(); d != after.end(); ++d) {
+    if (!*d)
+      continue;
+
+    std::lock_guard<std::mutex> lock((*d)->mutex);
+    if (!(*d)->finished) {
+      ++task->pending;
+      (*d)->dependents.push_back(task);
+    }
+  }
+
+  release(task);
+}
+
+void Thread_pool::release(task_handle const& task)
+{
+  if (--task->pending == 0)
+    enqueue(task);
+}
+
+void Thread_pool::enqueue(task_handle const& task)
+{
+  unsigned index = t_pool == this ? t_queue : m_next_queue++ % unsigned(m_queues.size());
+
+  // counted before it is visible, so a pop never sees the count below zero
+  {
+    std::lock_guard<std::mutex> lock(m_wake_mutex);
+    ++m_queued;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+    m_queues[index]->tasks.push_back(task);
+  }
+  m_wake.notify_one();
+}
+
+bool Thread_pool::try_pop(unsigned index, task_handle& task)
+{
+  // newest of the own queue first, it is likely still in cache
+  {
+    std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+    if (!m_queues[index]->tasks.empty()) {
+      task = m_queues[index]->tasks.back();
+      m_queues[index]->tasks.pop_back();
+      --m_queued;
+      return true;
+    }
+  }
+
+  // steal the oldest task of another worker
+  for (unsigned i = 1; i != m_queues.size(); ++i) {
+    Worker_queue& victim = *m_queues[(index + i) % m_queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = victim.tasks.front();
+      victim.tasks.pop_front();
+      --m_queued;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void Thread_pool::execute(task_handle const& task)
+{
+  task->work();
+
+  std::vector<task_handle> dependents;
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->finished = true;
+    dependents.swap(task->dependents);
+  }
+
+  for (std::vector<task_handle>::iterator d = dependents.begin(); d != dependents.end(); ++d)
+    release(*d);
+}
+
+void Thread_pool::worker(unsigned index)
+{
+  t_pool = this;
+  t_queue = index;
+
+  for (;;) {
+    task_handle task;
+    if (try_pop(index, task)) {
+      execute(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_wake_mutex);
+    m_wake.wait(lock, [this]() { return m_stop || m_queued > 0; });
+    if (m_stop)
+      return;
+  }
+}
+
+void Thread_pool::parallel_for(int begin, int end, std::function<void(int, int)> const& body, int grain)
+{
+  if (end <= begin)
+    return;
+
+  // a few chunks per thread balance uneven work
+  int count = end - begin;
+  int chunks = std::max(1, std::min((count + grain - 1) / grain, int(get_thread_count() + 1) * 4));
+
+  std::shared_ptr<Parallel_for_state> state = std::make_shared<Parallel_for_state>();
+  state->body = body;
+  state->begin = begin;
+  state->end = end;
+  state->chunk = (count + chunks - 1) / chunks;
+  state->chunks = (count + state->chunk - 1) / state->chunk;
+  state->next = 0;
+  state->done = 0;
+
+  int helpers = std::min<int>(state->chunks - 1, get_thread_count());
+  for (int h = 0; h < helpers; ++h)
+    enqueue(create_task([state]() { state->run(); }));
+
+  state->run();
+
+  // only chunks already taken by other threads are left
+  while (state->done < state->chunks)
+    std::this_thread::yield();
+}
+
+void Thread_pool::parallel_for(glm::ivec3 const& begin, glm::ivec3 const& end, glm::ivec3 const& block_size,
+                               std::function<void(glm::ivec3 const&, glm::ivec3 const&)> const& body)
+{
+  glm::ivec3 size = glm::max(end - begin, glm::ivec3(0));
+  glm::ivec3 blocks = (size + block_size - glm::ivec3(1)) / block_size;
+
+  parallel_for(0, blocks.x * blocks.y * blocks.z, [&](int first, int last) {
+    for (int b = first; b != last; ++b) {
+      glm::ivec3 block(b % blocks.x, (b / blocks.x) % blocks.y, b / (blocks.x * blocks.y));
+      glm::ivec3 block_begin = begin + block * block_size;
+      body(block_begin, glm::min(block_begin + block_size, end));
+    }
+  });
+}
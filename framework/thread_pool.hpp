@@ -0,0 +1,104 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Thread_pool
+// -----------------------------------------------------------------------------
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec3.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// work stealing pool, each worker runs its own queue newest first and steals
+// the oldest tasks of the others when it runs dry
+class Thread_pool
+{
+public:
+  struct Task;
+  typedef std::shared_ptr<Task> task_handle;
+
+  // 0 picks one worker per hardware thread besides the calling one
+  explicit Thread_pool(unsigned thread_count = 0);
+  ~Thread_pool();
+
+  // pool shared by the framework and the application
+  static Thread_pool& instance();
+
+  unsigned get_thread_count() const { return unsigned(m_threads.size()); }
+
+  // runs f once all tasks in after have finished, handle (if given) receives
+  // the task so later submissions can depend on it
+  template<typename F>
+  std::future<typename std::result_of<F()>::type>
+  submit(F f, std::vector<task_handle> const& after = std::vector<task_handle>(),
+         task_handle* handle = 0);
+
+  // splits [begin, end) into chunks of at least grain, blocks until all are done;
+  // the caller claims chunks as well, so nested calls from workers cannot stall
+  void parallel_for(int begin, int end, std::function<void(int, int)> const& body, int grain = 1);
+
+  // blocks of at most block_size voxels, body(block_begin, block_end)
+  void parallel_for(glm::ivec3 const& begin, glm::ivec3 const& end, glm::ivec3 const& block_size,
+                    std::function<void(glm::ivec3 const&, glm::ivec3 const&)> const& body);
+
+private:
+  struct Worker_queue
+  {
+    std::mutex              mutex;
+    std::deque<task_handle> tasks;
+  };
+
+  Thread_pool(Thread_pool const&);
+  Thread_pool& operator=(Thread_pool const&);
+
+  task_handle create_task(std::function<void()> const& work);
+  void        schedule(task_handle const& task, std::vector<task_handle> const& after);
+  void        release(task_handle const& task);
+  void        enqueue(task_handle const& task);
+  bool        try_pop(unsigned index, task_handle& task);
+  void        execute(task_handle const& task);
+  void        worker(unsigned index);
+
+  std::vector<std::unique_ptr<Worker_queue>> m_queues;
+  std::vector<std::thread>                   m_threads;
+  std::mutex                                 m_wake_mutex;
+  std::condition_variable                    m_wake;
+  std::atomic<unsigned>                      m_queued;
+  std::atomic<unsigned>                      m_next_queue;
+  bool                                       m_stop;
+};
+
+template<typename F>
+std::future<typename std::result_of<F()>::type>
+Thread_pool::submit(F f, std::vector<task_handle> const& after, task_handle* handle)
+{
+  typedef typename std::result_of<F()>::type result_type;
+
+  std::shared_ptr<std::packaged_task<result_type()> > job =
+    std::make_shared<std::packaged_task<result_type()> >(f);
+  std::future<result_type> future = job->get_future();
+
+  task_handle task = create_task([job]() { (*job)(); });
+  if (handle)
+    *handle = task;
+
+  schedule(task, after);
+  return future;
+}
+
+#endif // THREAD_POOL_HPP
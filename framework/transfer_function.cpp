@@ -104,6 +104,11 @@ Transfer_function::remove(unsigned data_value)
 }
 
 image_data_type Transfer_function::get_RGBA_transfer_function_buffer() const
+{
+  return bake(m_piecewise_container);
+}
+
+image_data_type Transfer_function::bake(container_type const& points)
 {
   size_t buffer_size = 255 * 4; // width =255 height = 1 channels = 4 ///TODO: maybe dont hardcode?
   image_data_type transfer_function_buffer;
@@ -117,7 +122,7 @@ image_data_type Transfer_function::get_RGBA_transfer_function_buffer() const
   unsigned  e_value;
   glm::vec4 e_color;
 
-  for (element_type e : m_piecewise_container) {
+  for (element_type e : points) {
     e_value = e.first;
     e_color = e.second;
 
@@ -32,6 +32,8 @@ public:
   void reset();
 
   image_data_type          get_RGBA_transfer_function_buffer() const;
+  // piecewise linear RGBA lookup table, 255 entries
+  static image_data_type   bake(container_type const& points);
   //void                  update_and_draw();
   void                  draw_texture(glm::vec2 const& window_dim, glm::vec2 const& tf_pos, GLuint const& texture) const;
   container_type&       get_piecewise_container(){ return m_piecewise_container;};
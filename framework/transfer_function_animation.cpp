@@ -0,0 +1,85 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Transfer_function_animation
+// -----------------------------------------------------------------------------
+
+#include "transfer_function_animation.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFER_FUNCTION_ANIMATION_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+
+Transfer_function_animation::Transfer_function_animation()
+  : m_from()
+  , m_to()
+  , m_start(0.0)
+  , m_duration(0.0)
+  , m_active(false)
+{}
+
+void Transfer_function_animation::blend(image_data_type const& from, image_data_type const& to,
+                                        float weight, image_data_type& out)
+{
+  size_t size = std::min(from.size(), to.size());
+  out.resize(size);
+
+  // 8 bit fixed point weights that sum to 256, a * (256 - w) + b * w fits 16 bits
+  unsigned w = (unsigned)(std::min(std::max(weight, 0.0f), 1.0f) * 256.0f + 0.5f);
+  unsigned w_from = 256 - w;
+
+  size_t i = 0;
+#ifdef TRANSFER_FUNCTION_ANIMATION_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i v_w = _mm_set1_epi16((short)w);
+  const __m128i v_w_from = _mm_set1_epi16((short)w_from);
+
+  for (; i + 16 <= size; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i*)&from[i]);
+    __m128i b = _mm_loadu_si128((const __m128i*)&to[i]);
+
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), v_w_from),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), v_w));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), v_w_from),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), v_w));
+
+    _mm_storeu_si128((__m128i*)&out[i], _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+  }
+#endif
+  for (; i != size; ++i)
+    out[i] = (unsigned char)((from[i] * w_from + to[i] * w) >> 8);
+}
+
+void Transfer_function_animation::start(image_data_type const& from, image_data_type const& to,
+                                        double duration, double now)
+{
+  m_from = from;
+  m_to = to;
+  m_start = now;
+  m_duration = duration;
+  m_active = true;
+}
+
+bool Transfer_function_animation::update(double now, image_data_type& out)
+{
+  if (!m_active)
+    return false;
+
+  double t = m_duration > 0.0 ? (now - m_start) / m_duration : 1.0;
+  if (t >= 1.0) {
+    out = m_to;
+    m_active = false;
+    return true;
+  }
+
+  // smoothstep, the transition eases in and out
+  float s = (float)std::max(t, 0.0);
+  blend(m_from, m_to, s * s * (3.0f - 2.0f * s), out);
+  return true;
+}
@@ -0,0 +1,43 @@
+#ifndef TRANSFER_FUNCTION_ANIMATION_HPP
+#define TRANSFER_FUNCTION_ANIMATION_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Transfer_function_animation
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+
+// timed per-entry RGBA blend between two baked lookup tables
+class Transfer_function_animation
+{
+public:
+  Transfer_function_animation();
+
+  // out = from * (1 - weight) + to * weight, weight in 0..1, tables of equal size
+  static void blend(image_data_type const& from, image_data_type const& to,
+                    float weight, image_data_type& out);
+
+  void start(image_data_type const& from, image_data_type const& to,
+             double duration, double now);
+
+  // writes the table for time now, false if no transition is running;
+  // the last call of a transition writes the target table
+  bool update(double now, image_data_type& out);
+  void stop() { m_active = false; }
+
+  bool is_active() const { return m_active; }
+
+private:
+  image_data_type m_from;
+  image_data_type m_to;
+  double          m_start;
+  double          m_duration;
+  bool            m_active;
+};
+
+#endif // TRANSFER_FUNCTION_ANIMATION_HPP
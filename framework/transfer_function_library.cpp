@@ -0,0 +1,295 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Transfer_function_library
+// -----------------------------------------------------------------------------
+
+#include "transfer_function_library.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+const char magic[4] = { 'T', 'F', 'L', 'B' };
+
+// explicit little endian fields, independent of padding and host byte order
+void write_u16(std::vector<unsigned char>& out, unsigned value)
+{
+  out.push_back((unsigned char)(value & 0xFF));
+  out.push_back((unsigned char)((value >> 8) & 0xFF));
+}
+
+void write_u32(std::vector<unsigned char>& out, unsigned value)
+{
+  write_u16(out, value & 0xFFFF);
+  write_u16(out, (value >> 16) & 0xFFFF);
+}
+
+void write_f32(std::vector<unsigned char>& out, float value)
+{
+  unsigned bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  write_u32(out, bits);
+}
+
+void write_bytes(std::vector<unsigned char>& out, const unsigned char* data, size_t size)
+{
+  out.insert(out.end(), data, data + size);
+}
+
+struct Reader
+{
+  std::vector<unsigned char> const& data;
+  size_t                            pos;
+  bool                              ok;
+
+  bool has(size_t size)
+  {
+    ok = ok && pos + size <= data.size();
+    return ok;
+  }
+
+  unsigned u16()
+  {
+    if (!has(2))
+      return 0;
+    unsigned value = data[pos] | (data[pos + 1] << 8);
+    pos += 2;
+    return value;
+  }
+
+  unsigned u32()
+  {
+    unsigned lo = u16();
+    return lo | (u16() << 16);
+  }
+
+  float f32()
+  {
+    unsigned bits = u32();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  void bytes(unsigned char* out, size_t size)
+  {
+    if (!has(size))
+      return;
+    std::memcpy(out, &data[pos], size);
+    pos += size;
+  }
+};
+
+} // namespace
+
+Transfer_function_library::Transfer_function_library()
+  : m_presets()
+{}
+
+Transfer_function_preset Transfer_function_library::make_preset(std::string const& name,
+                                                                Transfer_function::container_type const& points)
+{
+  Transfer_function_preset preset;
+  preset.name = name;
+  preset.points = points;
+  preset.lut = Transfer_function::bake(points);
+  return preset;
+}
+
+unsigned Transfer_function_library::set(Transfer_function_preset const& preset)
+{
+  int index = find(preset.name);
+  if (index >= 0) {
+    m_presets[index] = preset;
+    return unsigned(index);
+  }
+
+  m_presets.push_back(preset);
+  return unsigned(m_presets.size() - 1);
+}
+
+void Transfer_function_library::remove(unsigned index)
+{
+  if (index < m_presets.size())
+    m_presets.erase(m_presets.begin() + index);
+}
+
+int Transfer_function_library::find(std::string const& name) const
+{
+  for (unsigned i = 0; i != m_presets.size(); ++i) {
+    if (m_presets[i].name == name)
+      return int(i);
+  }
+  return -1;
+}
+
+bool Transfer_function_library::save(std::string const& path) const
+{
+  std::vector<unsigned char> out;
+  write_bytes(out, (const unsigned char*)magic, sizeof(magic));
+  write_u32(out, version);
+  write_u32(out, unsigned(m_presets.size()));
+
+  for (std::vector<Transfer_function_preset>::const_iterator p = m_presets.begin(); p != m_presets.end(); ++p) {
+    std::string name = p->name.substr(0, 0xFFFF);
+    write_u16(out, unsigned(name.size()));
+    write_bytes(out, (const unsigned char*)name.data(), name.size());
+
+    write_u16(out, unsigned(p->points.size()));
+    for (Transfer_function::container_type::const_iterator c = p->points.begin(); c != p->points.end(); ++c) {
+      out.push_back((unsigned char)c->first);
+      for (int i = 0; i != 4; ++i)
+        write_f32(out, c->second[i]);
+    }
+
+    write_u16(out, unsigned(p->lut.size() / 4));
+    if (!p->lut.empty())
+      write_bytes(out, &p->lut[0], p->lut.size());
+
+    // side length of a pre-integrated table, no longer written
+    write_u16(out, 0);
+  }
+
+  std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+  if (!file.good())
+    return false;
+
+  file.write((const char*)&out[0], out.size());
+  return file.good();
+}
+
+bool Transfer_function_library::load(std::string const& path)
+{
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  if (!file.good())
+    return false;
+
+  std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  Reader in = { data, 0, true };
+
+  unsigned char file_magic[4] = { 0, 0, 0, 0 };
+  in.bytes(file_magic, sizeof(file_magic));
+  if (!in.ok || std::memcmp(file_magic, magic, sizeof(magic)) != 0)
+    return false;
+
+  // newer versions may change the layout
+  unsigned file_version = in.u32();
+  if (!in.ok || file_version == 0 || file_version > version)
+    return false;
+
+  unsigned count = in.u32();
+  std::vector<Transfer_function_preset> presets;
+
+  for (unsigned p = 0; p != count && in.ok; ++p) {
+    Transfer_function_preset preset;
+
+    unsigned name_size = in.u16();
+    if (!in.has(name_size))
+      break;
+    if (name_size)
+      preset.name.assign((const char*)&data[in.pos], name_size);
+    in.pos += name_size;
+
+    unsigned points = in.u16();
+    for (unsigned c = 0; c != points && in.ok; ++c) {
+      unsigned char value = 0;
+      in.bytes(&value, 1);
+      glm::vec4 color;
+      for (int i = 0; i != 4; ++i)
+        color[i] = in.f32();
+      preset.points[value] = color;
+    }
+
+    unsigned entries = in.u16();
+    preset.lut.resize(entries * 4);
+    if (entries)
+      in.bytes(&preset.lut[0], preset.lut.size());
+
+    // pre-integrated tables of older files are skipped
+    size_t preintegrated_entries = in.u16();
+    if (in.has(preintegrated_entries * preintegrated_entries * 4))
+      in.pos += preintegrated_entries * preintegrated_entries * 4;
+
+    // the table is uploaded into the transfer texture as is, presets without
+    // one or with another size are baked once here
+    image_data_type baked = Transfer_function::bake(preset.points);
+    if (preset.lut.size() != baked.size())
+      preset.lut.swap(baked);
+
+    presets.push_back(preset);
+  }
+
+  if (!in.ok)
+    return false;
+
+  m_presets.swap(presets);
+  return true;
+}
+
+bool Transfer_function_library::import_text(std::string const& path)
+{
+  std::ifstream file(path.c_str());
+  if (!file.good())
+    return false;
+
+  std::string line;
+  std::string name;
+  Transfer_function::container_type points;
+  bool in_preset = false;
+
+  while (std::getline(file, line)) {
+    std::istringstream tokens(line);
+    std::string keyword;
+    tokens >> keyword;
+
+    if (keyword.empty() || keyword[0] == '#')
+      continue;
+
+    if (keyword == "preset") {
+      std::getline(tokens >> std::ws, name);
+      points.clear();
+      in_preset = true;
+    }
+    else if (keyword == "point" && in_preset) {
+      unsigned value;
+      glm::vec4 color;
+      if (tokens >> value >> color.r >> color.g >> color.b >> color.a)
+        points[std::min(value, 255u)] = color;
+    }
+    else if (keyword == "end" && in_preset) {
+      set(make_preset(name, points));
+      in_preset = false;
+    }
+  }
+
+  return true;
+}
+
+bool Transfer_function_library::export_text(std::string const& path) const
+{
+  std::ofstream file(path.c_str());
+  if (!file.good())
+    return false;
+
+  file << "# transfer function presets, version " << version << "\n";
+  file.precision(9);
+
+  for (std::vector<Transfer_function_preset>::const_iterator p = m_presets.begin(); p != m_presets.end(); ++p) {
+    file << "preset " << p->name << "\n";
+    for (Transfer_function::container_type::const_iterator c = p->points.begin(); c != p->points.end(); ++c) {
+      file << "point " << c->first << " " << c->second.r << " " << c->second.g << " "
+           << c->second.b << " " << c->second.a << "\n";
+    }
+    file << "end\n";
+  }
+
+  return file.good();
+}
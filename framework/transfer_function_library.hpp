@@ -0,0 +1,60 @@
+#ifndef TRANSFER_FUNCTION_LIBRARY_HPP
+#define TRANSFER_FUNCTION_LIBRARY_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Transfer_function_library
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+#include "transfer_function.hpp"
+
+#include <string>
+#include <vector>
+
+// control points for editing plus the baked table, so switching needs no rebake
+struct Transfer_function_preset
+{
+  std::string                       name;
+  Transfer_function::container_type points;
+  image_data_type                   lut;
+};
+
+// named presets stored in a versioned little endian binary file, with a
+// line based text format for exchange
+class Transfer_function_library
+{
+public:
+  static const unsigned version = 1;
+
+  Transfer_function_library();
+
+  static Transfer_function_preset make_preset(std::string const& name,
+                                              Transfer_function::container_type const& points);
+
+  // replaces a preset of the same name, returns its index
+  unsigned set(Transfer_function_preset const& preset);
+  void     remove(unsigned index);
+  int      find(std::string const& name) const;
+
+  unsigned                        size() const { return unsigned(m_presets.size()); }
+  Transfer_function_preset const& get(unsigned index) const { return m_presets[index]; }
+
+  // tables of another size than the transfer function are baked again from the points
+  bool load(std::string const& path);
+  bool save(std::string const& path) const;
+
+  // "preset <name>", "point <value 0..255> <r> <g> <b> <a>" lines and "end",
+  // imported presets are baked and merged by name
+  bool import_text(std::string const& path);
+  bool export_text(std::string const& path) const;
+
+private:
+  std::vector<Transfer_function_preset> m_presets;
+};
+
+#endif // TRANSFER_FUNCTION_LIBRARY_HPP
@@ -13,6 +13,7 @@
 #define GLM_FORCE_RADIANS
 #include <glm/vec2.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
 
 class Turntable
 {
@@ -35,6 +36,16 @@ public:
     m_zoom += zoomScale * (e.y - o.y);
   }
 
+  inline glm::vec2 const& rotation() const { return m_rotation; }
+  inline glm::vec2 const& panning() const { return m_panning; }
+  inline float zoom() const { return m_zoom; }
+
+  inline void set(glm::vec2 const& rotation, glm::vec2 const& panning, float zoom) {
+    m_rotation = rotation;
+    m_panning = panning;
+    m_zoom = zoom;
+  }
+
   inline glm::mat4 matrix() const {
       glm::vec4 rotate_x = glm::rotate(m_rotation.x, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::vec4(1.0, 0.0f, 0.0f, 1.0f);
       return glm::translate(glm::vec3(0.0f, 0.0f, -m_zoom))
@@ -79,7 +79,8 @@ GLuint createTexture2D(unsigned const& width, unsigned const& height,
 
 GLuint createTexture3D(unsigned const& width, unsigned const& height,
     unsigned const& depth, unsigned const channel_size,
-    unsigned const channel_count, const char* data)
+    unsigned const channel_count, const char* data,
+    bool const half_float)
 {
   GLuint tex;
   glGenTextures(1, &tex);
@@ -95,13 +96,60 @@ GLuint createTexture3D(unsigned const& width, unsigned const& height,
   glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+  // rows of odd sized 8 bit volumes are not 4 byte aligned
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  // sized internal formats, unsized ones let the driver pick 8 bit storage
+  static const GLenum formats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+  static const GLenum formats_8[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+  static const GLenum formats_16[4] = { GL_R16, GL_RG16, GL_RGB16, GL_RGBA16 };
+  static const GLenum formats_16f[4] = { GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F };
+  static const GLenum formats_32f[4] = { GL_R32F, GL_RG32F, GL_RGB32F, GL_RGBA32F };
+
+  unsigned c = (channel_count >= 1 && channel_count <= 4) ? channel_count - 1 : 0;
+
   if (channel_size == 1)
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_RED, width, height, depth, 0, GL_RED,
+    glTexImage3D(GL_TEXTURE_3D, 0, formats_8[c], width, height, depth, 0, formats[c],
         GL_UNSIGNED_BYTE, data);
 
   if (channel_size == 2)
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_RED, width, height, depth, 0, GL_RED,
+    glTexImage3D(GL_TEXTURE_3D, 0, formats_16[c], width, height, depth, 0, formats[c],
         GL_UNSIGNED_SHORT, data);
 
+  if (channel_size == 4)
+    glTexImage3D(GL_TEXTURE_3D, 0, half_float ? formats_16f[c] : formats_32f[c],
+        width, height, depth, 0, formats[c], GL_FLOAT, data);
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  return tex;
+}
+
+GLuint createLabelTexture3D(unsigned const& width, unsigned const& height,
+    unsigned const& depth, unsigned const byte_per_label, const char* data)
+{
+  GLuint tex;
+  glGenTextures(1, &tex);
+  glBindTexture(GL_TEXTURE_3D, tex);
+
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+  // integer textures cannot be filtered
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  if (byte_per_label == 2)
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R16UI, width, height, depth, 0, GL_RED_INTEGER,
+        GL_UNSIGNED_SHORT, data);
+  else
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R8UI, width, height, depth, 0, GL_RED_INTEGER,
+        GL_UNSIGNED_BYTE, data);
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
   return tex;
 }
@@ -36,5 +36,9 @@ GLuint createTexture2D(unsigned const& width, unsigned const& height,
     const char* data);
 GLuint createTexture3D(unsigned const& width, unsigned const& height,
     unsigned const& depth, unsigned const channel_size,
-    unsigned const channel_count, const char* data);
+    unsigned const channel_count, const char* data,
+    bool const half_float = false);
+// unsigned integer ids, 1 or 2 byte, sampled nearest without filtering
+GLuint createLabelTexture3D(unsigned const& width, unsigned const& height,
+    unsigned const& depth, unsigned const byte_per_label, const char* data);
 #endif // #ifndef UTILS_HPP
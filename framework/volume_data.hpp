@@ -0,0 +1,82 @@
+#ifndef VOLUME_DATA_HPP
+#define VOLUME_DATA_HPP
+
+#include "data_types_fwd.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+// value of a voxel in texture units, matching what the shader samples
+// (normalized for 8 and 16 bit, raw for 32 bit float)
+inline float get_texture_value(volume_data_type const& data, size_t index, unsigned byte_per_channel)
+{
+  if (byte_per_channel == 2)
+    return ((const unsigned short*)&data[0])[index] / 65535.0f;
+  if (byte_per_channel == 4)
+    return ((const float*)&data[0])[index];
+  return data[index] / 255.0f;
+}
+
+// inverse of get_texture_value, 8 and 16 bit values are clamped to 0..1
+inline void set_texture_value(volume_data_type& data, size_t index, unsigned byte_per_channel, float value)
+{
+  if (byte_per_channel == 2)
+    ((unsigned short*)&data[0])[index] = (unsigned short)(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+  else if (byte_per_channel == 4)
+    ((float*)&data[0])[index] = value;
+  else
+    data[index] = (unsigned char)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+// value of a voxel windowed to the data range (0..1), as get_sample_data returns it
+inline float get_windowed_value(volume_data_type const& data, size_t index, unsigned byte_per_channel,
+                                glm::vec2 const& data_range)
+{
+  float value = (get_texture_value(data, index, byte_per_channel) - data_range.x) / (data_range.y - data_range.x);
+  return std::min(std::max(value, 0.0f), 1.0f);
+}
+
+// windowed data (0..255) box filtered down to at most max_resolution voxels per axis,
+// the reduced dimensions are returned in out_dimensions
+inline volume_data_type downsample_windowed(volume_data_type const& data, glm::ivec3 const& dimensions,
+                                            unsigned byte_per_channel, glm::vec2 const& data_range,
+                                            int max_resolution, glm::ivec3& out_dimensions)
+{
+  int max_dim = std::max(std::max(dimensions.x, dimensions.y), dimensions.z);
+  int factor = std::max(1, (max_dim + max_resolution - 1) / max_resolution);
+
+  glm::ivec3 dims = (dimensions + glm::ivec3(factor - 1)) / glm::ivec3(factor);
+  out_dimensions = dims;
+
+  volume_data_type result(size_t(dims.x) * dims.y * dims.z, 0);
+  if (data.empty() || result.empty())
+    return result;
+
+  parallel_for(0, dims.z, [&](int z_begin, int z_end) {
+    for (int z = z_begin; z != z_end; ++z) {
+      for (int y = 0; y != dims.y; ++y) {
+        for (int x = 0; x != dims.x; ++x) {
+          float sum = 0.0f;
+          int count = 0;
+          for (int vz = z * factor; vz < std::min((z + 1) * factor, dimensions.z); ++vz) {
+            for (int vy = y * factor; vy < std::min((y + 1) * factor, dimensions.y); ++vy) {
+              size_t row = size_t(dimensions.x) * (vy + size_t(dimensions.y) * vz);
+              for (int vx = x * factor; vx < std::min((x + 1) * factor, dimensions.x); ++vx) {
+                sum += get_windowed_value(data, row + vx, byte_per_channel, data_range);
+                ++count;
+              }
+            }
+          }
+          result[x + dims.x * (y + size_t(dims.y) * z)] = (unsigned char)(sum / count * 255.0f + 0.5f);
+        }
+      }
+    }
+  });
+
+  return result;
+}
+
+#endif // define VOLUME_DATA_HPP
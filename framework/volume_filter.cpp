@@ -0,0 +1,356 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Volume_filter_pipeline
+// -----------------------------------------------------------------------------
+
+#include "volume_filter.hpp"
+#include "volume_data.hpp"
+#include "parallel.hpp"
+
+#include <glm/vector_relational.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VOLUME_FILTER_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// exp through the float exponent bits, a few percent off but identical in
+// the scalar and the vector path; only used for bilateral weights
+float fast_exp(float x)
+{
+  int bits = (int)(12102203.0f * std::max(x, -80.0f) + 1065353216.0f);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+#ifdef VOLUME_FILTER_SSE2
+__m128 fast_exp(__m128 x)
+{
+  x = _mm_max_ps(x, _mm_set1_ps(-80.0f));
+  __m128i bits = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(12102203.0f)),
+                                             _mm_set1_ps(1065353216.0f)));
+  return _mm_castsi128_ps(bits);
+}
+
+// forgetful selection, the median of 27 with min/max only: keep 15 values,
+// drop the smallest and largest, add the next value, repeat
+__m128 median_27(__m128* v)
+{
+  int first = 0;
+  int end = 15;
+  int next = 15;
+
+  for (;;) {
+    for (int i = first + 1; i != end; ++i) {
+      __m128 lo = _mm_min_ps(v[first], v[i]);
+      v[i] = _mm_max_ps(v[first], v[i]);
+      v[first] = lo;
+    }
+    for (int i = first + 1; i != end - 1; ++i) {
+      __m128 hi = _mm_max_ps(v[i], v[end - 1]);
+      v[i] = _mm_min_ps(v[i], v[end - 1]);
+      v[end - 1] = hi;
+    }
+    ++first;
+    --end;
+
+    if (next == 27)
+      return v[first];
+    v[end++] = v[next++];
+  }
+}
+#endif
+
+// z slab in two ping-pong buffers of full xy layers
+struct Slab
+{
+  int    width;
+  int    height;
+  size_t plane;
+  int    base;  // first layer held by the buffers
+  int    lo;    // valid layers of the current source
+  int    hi;
+
+  float* layer(float* buffer, int z) const { return buffer + (z - base) * plane; }
+  float* row(float* buffer, int z, int y) const { return layer(buffer, z) + size_t(y) * width; }
+
+  int clamp_x(int x) const { return std::min(std::max(x, 0), width - 1); }
+  int clamp_y(int y) const { return std::min(std::max(y, 0), height - 1); }
+  int clamp_z(int z) const { return std::min(std::max(z, lo), hi - 1); }
+};
+
+// out[x] = sum of weights[i] * rows[i][x]
+void blend_rows(float* out, const float* const* rows, const float* weights, int count, int width)
+{
+  int x = 0;
+#ifdef VOLUME_FILTER_SSE2
+  for (; x + 4 <= width; x += 4) {
+    __m128 sum = _mm_setzero_ps();
+    for (int i = 0; i != count; ++i)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[i]), _mm_loadu_ps(rows[i] + x)));
+    _mm_storeu_ps(out + x, sum);
+  }
+#endif
+  for (; x != width; ++x) {
+    float sum = 0.0f;
+    for (int i = 0; i != count; ++i)
+      sum += weights[i] * rows[i][x];
+    out[x] = sum;
+  }
+}
+
+void gaussian_row(const float* in, float* out, int width, const float* weights, int radius)
+{
+  int x = 0;
+  for (; x < std::min(radius, width); ++x) {
+    float sum = 0.0f;
+    for (int k = -radius; k <= radius; ++k)
+      sum += weights[k + radius] * in[std::min(std::max(x + k, 0), width - 1)];
+    out[x] = sum;
+  }
+#ifdef VOLUME_FILTER_SSE2
+  for (; x + 4 + radius <= width; x += 4) {
+    __m128 sum = _mm_setzero_ps();
+    for (int k = -radius; k <= radius; ++k)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k + radius]), _mm_loadu_ps(in + x + k)));
+    _mm_storeu_ps(out + x, sum);
+  }
+#endif
+  for (; x < width; ++x) {
+    float sum = 0.0f;
+    for (int k = -radius; k <= radius; ++k)
+      sum += weights[k + radius] * in[std::min(std::max(x + k, 0), width - 1)];
+    out[x] = sum;
+  }
+}
+
+// separable, x and y run over all valid layers, z only over the output layers;
+// both buffers are used, the result ends up in dst
+void gaussian(Slab const& s, float* src, float* dst, int out_lo, int out_hi, float sigma, int radius)
+{
+  std::vector<float> weights(2 * radius + 1);
+  float total = 0.0f;
+  for (int k = -radius; k <= radius; ++k)
+    total += weights[k + radius] = std::exp(-0.5f * k * k / (sigma * sigma));
+  for (int k = 0; k != 2 * radius + 1; ++k)
+    weights[k] /= total;
+
+  std::vector<const float*> rows(2 * radius + 1);
+
+  for (int z = s.lo; z != s.hi; ++z) {
+    for (int y = 0; y != s.height; ++y)
+      gaussian_row(s.row(src, z, y), s.row(dst, z, y), s.width, &weights[0], radius);
+  }
+
+  for (int z = s.lo; z != s.hi; ++z) {
+    for (int y = 0; y != s.height; ++y) {
+      for (int k = -radius; k <= radius; ++k)
+        rows[k + radius] = s.row(dst, z, s.clamp_y(y + k));
+      blend_rows(s.row(src, z, y), &rows[0], &weights[0], 2 * radius + 1, s.width);
+    }
+  }
+
+  for (int z = out_lo; z != out_hi; ++z) {
+    for (int y = 0; y != s.height; ++y) {
+      for (int k = -radius; k <= radius; ++k)
+        rows[k + radius] = s.row(src, s.clamp_z(z + k), y);
+      blend_rows(s.row(dst, z, y), &rows[0], &weights[0], 2 * radius + 1, s.width);
+    }
+  }
+}
+
+void median(Slab const& s, float* src, float* dst, int out_lo, int out_hi)
+{
+  const float* rows[9];
+  float values[27];
+
+  for (int z = out_lo; z != out_hi; ++z) {
+    for (int y = 0; y != s.height; ++y) {
+      for (int j = 0; j != 9; ++j)
+        rows[j] = s.row(src, s.clamp_z(z + j / 3 - 1), s.clamp_y(y + j % 3 - 1));
+      float* out = s.row(dst, z, y);
+
+      int x = 0;
+      for (; x < std::min(1, s.width); ++x) {
+        for (int i = 0; i != 27; ++i)
+          values[i] = rows[i / 3][s.clamp_x(x + i % 3 - 1)];
+        std::nth_element(values, values + 13, values + 27);
+        out[x] = values[13];
+      }
+#ifdef VOLUME_FILTER_SSE2
+      __m128 lanes[27];
+      for (; x + 5 <= s.width; x += 4) {
+        for (int i = 0; i != 27; ++i)
+          lanes[i] = _mm_loadu_ps(rows[i / 3] + x + i % 3 - 1);
+        _mm_storeu_ps(out + x, median_27(lanes));
+      }
+#endif
+      for (; x < s.width; ++x) {
+        for (int i = 0; i != 27; ++i)
+          values[i] = rows[i / 3][s.clamp_x(x + i % 3 - 1)];
+        std::nth_element(values, values + 13, values + 27);
+        out[x] = values[13];
+      }
+    }
+  }
+}
+
+void bilateral(Slab const& s, float* src, float* dst, int out_lo, int out_hi,
+               float sigma, float range_sigma, int radius)
+{
+  int diameter = 2 * radius + 1;
+  std::vector<float> spatial(diameter * diameter * diameter);
+  for (int i = 0; i != (int)spatial.size(); ++i) {
+    glm::ivec3 d(i % diameter - radius, (i / diameter) % diameter - radius, i / (diameter * diameter) - radius);
+    spatial[i] = std::exp(-0.5f * float(d.x * d.x + d.y * d.y + d.z * d.z) / (sigma * sigma));
+  }
+  float range_scale = -0.5f / std::max(range_sigma * range_sigma, 1e-12f);
+
+  std::vector<const float*> rows(diameter * diameter);
+
+  for (int z = out_lo; z != out_hi; ++z) {
+    for (int y = 0; y != s.height; ++y) {
+      for (int j = 0; j != diameter * diameter; ++j)
+        rows[j] = s.row(src, s.clamp_z(z + j / diameter - radius), s.clamp_y(y + j % diameter - radius));
+      const float* center = s.row(src, z, y);
+      float* out = s.row(dst, z, y);
+
+      int x = 0;
+      for (; x < s.width; ++x) {
+#ifdef VOLUME_FILTER_SSE2
+        // the vector path covers all x whose neighbourhood lies inside the row
+        if (x >= radius && x + 4 + radius <= s.width) {
+          __m128 c = _mm_loadu_ps(center + x);
+          __m128 sum = _mm_setzero_ps();
+          __m128 weight_sum = _mm_setzero_ps();
+          for (int j = 0; j != diameter * diameter; ++j) {
+            for (int dx = -radius; dx <= radius; ++dx) {
+              __m128 v = _mm_loadu_ps(rows[j] + x + dx);
+              __m128 d = _mm_sub_ps(v, c);
+              __m128 w = _mm_mul_ps(_mm_set1_ps(spatial[j * diameter + dx + radius]),
+                                    fast_exp(_mm_mul_ps(_mm_mul_ps(d, d), _mm_set1_ps(range_scale))));
+              sum = _mm_add_ps(sum, _mm_mul_ps(w, v));
+              weight_sum = _mm_add_ps(weight_sum, w);
+            }
+          }
+          _mm_storeu_ps(out + x, _mm_div_ps(sum, weight_sum));
+          x += 3;
+          continue;
+        }
+#endif
+        float c = center[x];
+        float sum = 0.0f;
+        float weight_sum = 0.0f;
+        for (int j = 0; j != diameter * diameter; ++j) {
+          for (int dx = -radius; dx <= radius; ++dx) {
+            float v = rows[j][s.clamp_x(x + dx)];
+            float w = spatial[j * diameter + dx + radius] * fast_exp((v - c) * (v - c) * range_scale);
+            sum += w * v;
+            weight_sum += w;
+          }
+        }
+        out[x] = sum / weight_sum;
+      }
+    }
+  }
+}
+
+} // namespace
+
+int Volume_filter::get_radius() const
+{
+  switch (type) {
+  case gaussian:
+    return std::min(std::max((int)std::ceil(3.0f * sigma), 1), 8);
+  case bilateral:
+    return std::min(std::max((int)std::ceil(2.0f * sigma), 1), 3);
+  default:
+    return 1;
+  }
+}
+
+Volume_filter_pipeline::Volume_filter_pipeline()
+  : m_filters()
+{}
+
+int Volume_filter_pipeline::get_halo() const
+{
+  int halo = 0;
+  for (std::vector<Volume_filter>::const_iterator f = m_filters.begin(); f != m_filters.end(); ++f)
+    halo += f->get_radius();
+  return halo;
+}
+
+volume_data_type Volume_filter_pipeline::apply(volume_data_type const& data, glm::ivec3 const& dimensions,
+                                               unsigned byte_per_channel, glm::vec2 const& data_range,
+                                               int slab_depth) const
+{
+  if (m_filters.empty() || data.empty() || glm::any(glm::lessThan(dimensions, glm::ivec3(1))))
+    return data;
+
+  volume_data_type result(data.size());
+
+  int halo = get_halo();
+  slab_depth = std::max(slab_depth, 1);
+  int slabs = (dimensions.z + slab_depth - 1) / slab_depth;
+  size_t plane = size_t(dimensions.x) * dimensions.y;
+  size_t buffer_size = plane * std::min(slab_depth + 2 * halo, dimensions.z);
+
+  parallel_for(0, slabs, [&](int first, int last) {
+    std::vector<float> a(buffer_size);
+    std::vector<float> b(buffer_size);
+
+    for (int slab = first; slab != last; ++slab) {
+      int z_begin = slab * slab_depth;
+      int z_end = std::min(z_begin + slab_depth, dimensions.z);
+
+      Slab s = { dimensions.x, dimensions.y, plane, 0, 0, 0 };
+      s.base = s.lo = std::max(z_begin - halo, 0);
+      s.hi = std::min(z_end + halo, dimensions.z);
+
+      float* src = &a[0];
+      float* dst = &b[0];
+
+      for (size_t i = 0; i != plane * (s.hi - s.lo); ++i)
+        src[i] = get_texture_value(data, plane * s.base + i, byte_per_channel);
+
+      // every filter shrinks the valid layers by its radius, except at the volume border
+      for (std::vector<Volume_filter>::const_iterator f = m_filters.begin(); f != m_filters.end(); ++f) {
+        int radius = f->get_radius();
+        int out_lo = s.lo == 0 ? 0 : s.lo + radius;
+        int out_hi = s.hi == dimensions.z ? dimensions.z : s.hi - radius;
+
+        if (f->type == Volume_filter::gaussian)
+          gaussian(s, src, dst, out_lo, out_hi, std::max(f->sigma, 0.1f), radius);
+        else if (f->type == Volume_filter::median)
+          median(s, src, dst, out_lo, out_hi);
+        else
+          bilateral(s, src, dst, out_lo, out_hi, std::max(f->sigma, 0.1f),
+                    f->range_sigma * (data_range.y - data_range.x), radius);
+
+        std::swap(src, dst);
+        s.lo = out_lo;
+        s.hi = out_hi;
+      }
+
+      for (int z = z_begin; z != z_end; ++z) {
+        const float* in = s.layer(src, z);
+        for (size_t i = 0; i != plane; ++i)
+          set_texture_value(result, plane * z + i, byte_per_channel, in[i]);
+      }
+    }
+  });
+
+  return result;
+}
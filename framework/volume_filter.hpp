@@ -0,0 +1,60 @@
+#ifndef VOLUME_FILTER_HPP
+#define VOLUME_FILTER_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Volume_filter_pipeline
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+struct Volume_filter
+{
+  enum Type { gaussian, median, bilateral };
+
+  Type  type;
+  float sigma;        // spatial, in voxels (gaussian, bilateral)
+  float range_sigma;  // value similarity as a fraction of the data range (bilateral)
+
+  // neighbours read on each side along every axis
+  int get_radius() const;
+};
+
+// chain of smoothing filters over single channel volumes; the chain is fused,
+// each z slab is read once with enough halo for all filters, filtered in a
+// slab sized buffer and written once
+class Volume_filter_pipeline
+{
+public:
+  Volume_filter_pipeline();
+
+  void add(Volume_filter const& filter) { m_filters.push_back(filter); }
+  void clear() { m_filters.clear(); }
+  bool empty() const { return m_filters.empty(); }
+
+  std::vector<Volume_filter> const& get_filters() const { return m_filters; }
+
+  // layers beyond a slab needed to filter it, the sum of all radii
+  int get_halo() const;
+
+  // filtered copy in the same format, slabs of slab_depth layers are
+  // processed in parallel; values never leave the input range
+  volume_data_type apply(volume_data_type const& data, glm::ivec3 const& dimensions,
+                         unsigned byte_per_channel, glm::vec2 const& data_range,
+                         int slab_depth = 8) const;
+
+private:
+  std::vector<Volume_filter> m_filters;
+};
+
+#endif // VOLUME_FILTER_HPP
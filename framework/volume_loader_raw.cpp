@@ -1,49 +1,170 @@
 #include "volume_loader_raw.hpp"
+#include "volume_data.hpp"
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <vector>
 
-volume_data_type
-Volume_loader_raw::load_volume(std::string filepath)
+#include <glm/common.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VOLUME_LOADER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+glm::vec2 get_range_8bit(const unsigned char* data, size_t count)
 {
-  std::ifstream volume_file;
-  volume_file.open(filepath, std::ios::in | std::ios::binary);
+  unsigned char min_value = 255u;
+  unsigned char max_value = 0u;
+  size_t i = 0;
 
-  volume_data_type data;
+#ifdef VOLUME_LOADER_SSE2
+  if (count >= 16) {
+    __m128i v_min = _mm_set1_epi8((char)0xFF);
+    __m128i v_max = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+      v_min = _mm_min_epu8(v_min, v);
+      v_max = _mm_max_epu8(v_max, v);
+    }
+    unsigned char lanes_min[16];
+    unsigned char lanes_max[16];
+    _mm_storeu_si128((__m128i*)lanes_min, v_min);
+    _mm_storeu_si128((__m128i*)lanes_max, v_max);
+    for (unsigned l = 0; l != 16; ++l) {
+      min_value = std::min(min_value, lanes_min[l]);
+      max_value = std::max(max_value, lanes_max[l]);
+    }
+  }
+#endif
 
-  if (volume_file.is_open()) {
-    glm::ivec3 vol_dim = get_dimensions(filepath);
-    unsigned channels = get_channel_count(filepath);
-    unsigned byte_per_channel = get_bit_per_channel(filepath) / 8;
+  for (; i < count; ++i) {
+    min_value = std::min(min_value, data[i]);
+    max_value = std::max(max_value, data[i]);
+  }
 
+  return glm::vec2(min_value, max_value) / 255.0f;
+}
 
-    size_t data_size = vol_dim.x
-                      * vol_dim.y
-                      * vol_dim.z
-                      * channels
-                      * byte_per_channel;
+glm::vec2 get_range_16bit(const unsigned short* data, size_t count)
+{
+  unsigned short min_value = 65535u;
+  unsigned short max_value = 0u;
+  size_t i = 0;
 
-    
-    data.resize(data_size);
+#ifdef VOLUME_LOADER_SSE2
+  // SSE2 only has signed 16 bit min/max, flipping the sign bit keeps the order
+  if (count >= 8) {
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    __m128i v_min = _mm_set1_epi16(0x7FFF);
+    __m128i v_max = _mm_set1_epi16((short)0x8000);
+    for (; i + 8 <= count; i += 8) {
+      __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(data + i)), bias);
+      v_min = _mm_min_epi16(v_min, v);
+      v_max = _mm_max_epi16(v_max, v);
+    }
+    unsigned short lanes_min[8];
+    unsigned short lanes_max[8];
+    _mm_storeu_si128((__m128i*)lanes_min, _mm_xor_si128(v_min, bias));
+    _mm_storeu_si128((__m128i*)lanes_max, _mm_xor_si128(v_max, bias));
+    for (unsigned l = 0; l != 8; ++l) {
+      min_value = std::min(min_value, lanes_min[l]);
+      max_value = std::max(max_value, lanes_max[l]);
+    }
+  }
+#endif
 
-    volume_file.seekg(0, std::ios::beg);
-    volume_file.read((char*)&data.front(), data_size);
-    volume_file.close();
+  for (; i < count; ++i) {
+    min_value = std::min(min_value, data[i]);
+    max_value = std::max(max_value, data[i]);
+  }
 
-    //std::cout << "File " << filepath << " successfully loaded" << std::endl;
+  return glm::vec2(min_value, max_value) / 65535.0f;
+}
 
+glm::vec2 get_range_float(const float* data, size_t count)
+{
+  float min_value = std::numeric_limits<float>::max();
+  float max_value = -std::numeric_limits<float>::max();
+  size_t i = 0;
+
+#ifdef VOLUME_LOADER_SSE2
+  if (count >= 4) {
+    __m128 v_min = _mm_set1_ps(min_value);
+    __m128 v_max = _mm_set1_ps(max_value);
+    for (; i + 4 <= count; i += 4) {
+      __m128 v = _mm_loadu_ps(data + i);
+      v_min = _mm_min_ps(v_min, v);
+      v_max = _mm_max_ps(v_max, v);
+    }
+    float lanes_min[4];
+    float lanes_max[4];
+    _mm_storeu_ps(lanes_min, v_min);
+    _mm_storeu_ps(lanes_max, v_max);
+    for (unsigned l = 0; l != 4; ++l) {
+      min_value = std::min(min_value, lanes_min[l]);
+      max_value = std::max(max_value, lanes_max[l]);
+    }
+  }
+#endif
+
+  for (; i < count; ++i) {
+    min_value = std::min(min_value, data[i]);
+    max_value = std::max(max_value, data[i]);
+  }
+
+  return glm::vec2(min_value, max_value);
+}
+
+} // namespace
+
+volume_data_type
+Volume_loader_raw::load_volume(std::string filepath)
+{
+  volume_data_type data;
+
+  if (!is_readable(filepath)) {
+    std::cerr << "File " << filepath << " doesnt exist or is too short! Check Filepath!" << std::endl;
     return data;
-  } else {
-    std::cerr << "File " << filepath << " doesnt exist! Check Filepath!" << std::endl;
-    assert(0);
-    return data;
   }
 
-  //never reached
-  assert(0);
+  std::ifstream volume_file(filepath.c_str(), std::ios::in | std::ios::binary);
+  data.resize(get_data_size(filepath));
+  volume_file.read((char*)&data.front(), data.size());
+  if (!volume_file) {
+    std::cerr << "Could not read " << filepath << std::endl;
+    return volume_data_type();
+  }
+
+  if (get_big_endian(filepath)) {
+    swap_endianness(data, get_bit_per_channel(filepath) / 8);
+  }
+
   return data;
 }
 
+volume_data_type
+Volume_loader_raw::load_labels(std::string const& file_path)
+{
+  if (!std::ifstream(file_path.c_str(), std::ios::in | std::ios::binary).is_open()) {
+    std::cerr << "File " << file_path << " doesnt exist! Check Filepath!" << std::endl;
+    return volume_data_type();
+  }
+
+  unsigned bits = get_bit_per_channel(file_path);
+  if (get_channel_count(file_path) != 1 || (bits != 8 && bits != 16)) {
+    std::cerr << "Labels in " << file_path << " need one 8 or 16 bit channel" << std::endl;
+    return volume_data_type();
+  }
+
+  return load_volume(file_path);
+}
+
 glm::ivec3 Volume_loader_raw::get_dimensions(const std::string filepath) const
 {
   unsigned width = 0;
@@ -109,3 +230,233 @@ unsigned Volume_loader_raw::get_bit_per_channel(const std::string filepath) cons
 
   return byte_per_channel;
 }
+
+glm::vec3 Volume_loader_raw::get_spacing(const std::string filepath) const
+{
+  std::ifstream spacing_file((filepath + ".spacing").c_str());
+
+  glm::vec3 spacing(1.0f);
+  if (!(spacing_file >> spacing.x >> spacing.y >> spacing.z)
+      || spacing.x <= 0.0f || spacing.y <= 0.0f || spacing.z <= 0.0f)
+    return glm::vec3(1.0f);
+
+  return spacing;
+}
+
+bool Volume_loader_raw::get_big_endian(const std::string filepath) const
+{
+  // directories may contain the token as well, only the file name counts
+  std::string name = filepath.substr(filepath.find_last_of("/\\") + 1);
+
+  // the flag directly follows the "_b<bits>" field
+  size_t p0 = name.find("_b");
+  while (p0 != std::string::npos && !(p0 + 2 < name.size() && std::isdigit((unsigned char)name[p0 + 2])))
+    p0 = name.find("_b", p0 + 2);
+  if (p0 == std::string::npos)
+    return false;
+
+  size_t p1 = p0 + 2;
+  while (p1 < name.size() && std::isdigit((unsigned char)name[p1]))
+    ++p1;
+
+  if (name.compare(p1, 3, "_be") != 0)
+    return false;
+  p1 += 3;
+  return p1 == name.size() || name[p1] == '.' || name[p1] == '_';
+}
+
+size_t Volume_loader_raw::get_data_size(const std::string filepath) const
+{
+  glm::ivec3 vol_dim = get_dimensions(filepath);
+  if (vol_dim.x <= 0 || vol_dim.y <= 0 || vol_dim.z <= 0)
+    return 0;
+
+  return size_t(vol_dim.x)
+       * size_t(vol_dim.y)
+       * size_t(vol_dim.z)
+       * get_channel_count(filepath)
+       * (get_bit_per_channel(filepath) / 8);
+}
+
+bool Volume_loader_raw::is_readable(const std::string filepath) const
+{
+  std::ifstream volume_file(filepath.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+  if (!volume_file.is_open())
+    return false;
+
+  std::streamoff file_size = volume_file.tellg();
+  size_t data_size = get_data_size(filepath);
+  return data_size > 0 && file_size >= 0 && size_t(file_size) >= data_size;
+}
+
+void Volume_loader_raw::swap_endianness(volume_data_type& data, unsigned byte_per_channel) const
+{
+  if (byte_per_channel < 2)
+    return;
+
+  for (size_t i = 0; i + byte_per_channel <= data.size(); i += byte_per_channel) {
+    std::reverse(data.begin() + i, data.begin() + i + byte_per_channel);
+  }
+}
+
+glm::vec2 Volume_loader_raw::get_value_range(volume_data_type const& data, unsigned byte_per_channel) const
+{
+  if (data.empty())
+    return glm::vec2(0.0f, 1.0f);
+
+  size_t count = data.size() / byte_per_channel;
+
+  if (byte_per_channel == 2)
+    return get_range_16bit((const unsigned short*)&data[0], count);
+  if (byte_per_channel == 4)
+    return get_range_float((const float*)&data[0], count);
+  return get_range_8bit(&data[0], count);
+}
+
+volume_data_type Volume_loader_raw::equalize_to_8bit(volume_data_type const& data, unsigned byte_per_channel, glm::vec2 const& range) const
+{
+  const unsigned bin_count = 4096u;
+
+  size_t count = data.size() / byte_per_channel;
+  volume_data_type result(count);
+
+  if (count == 0)
+    return result;
+
+  float range_scale = range.y > range.x ? (bin_count - 1) / (range.y - range.x) : 0.0f;
+
+  auto get_bin = [&](size_t i) {
+    float bin = (get_texture_value(data, i, byte_per_channel) - range.x) * range_scale;
+    return (unsigned)std::min(std::max(bin, 0.0f), float(bin_count - 1));
+  };
+
+  std::vector<size_t> histogram(bin_count, 0);
+
+  for (size_t i = 0; i != count; ++i) {
+    ++histogram[get_bin(i)];
+  }
+
+  // cumulative distribution without the lowest occupied bin, so it maps to 0
+  std::vector<unsigned char> mapping(bin_count, 0);
+  size_t cdf_min = 0;
+  size_t cdf = 0;
+  for (unsigned b = 0; b != bin_count; ++b) {
+    cdf += histogram[b];
+    if (cdf_min == 0)
+      cdf_min = cdf;
+    if (count > cdf_min)
+      mapping[b] = (unsigned char)((cdf - cdf_min) * 255 / (count - cdf_min));
+  }
+
+  for (size_t i = 0; i != count; ++i) {
+    result[i] = mapping[get_bin(i)];
+  }
+
+  return result;
+}
+
+volume_data_type Volume_loader_raw::extract(volume_data_type const& data, glm::ivec3 const& dimensions,
+                                            unsigned byte_per_channel, unsigned channel_count,
+                                            glm::ivec3 const& begin, glm::ivec3 const& end) const
+{
+  glm::ivec3 first = glm::clamp(begin, glm::ivec3(0), dimensions);
+  glm::ivec3 size = glm::max(glm::clamp(end, glm::ivec3(0), dimensions) - first, glm::ivec3(0));
+
+  size_t voxel_size = size_t(std::max(channel_count, 1u)) * byte_per_channel;
+  size_t row_size = size.x * voxel_size;
+  volume_data_type result(row_size * size.y * size.z);
+  if (data.empty() || result.empty())
+    return result;
+
+  parallel_for(0, size.z, [&](int z_begin, int z_end) {
+    for (int z = z_begin; z != z_end; ++z) {
+      for (int y = 0; y != size.y; ++y) {
+        size_t source = (first.x + dimensions.x * (first.y + y + size_t(dimensions.y) * (first.z + z))) * voxel_size;
+        std::copy(data.begin() + source, data.begin() + source + row_size,
+                  result.begin() + (y + size_t(size.y) * z) * row_size);
+      }
+    }
+  });
+
+  return result;
+}
+
+bool Volume_loader_raw::save_volume(std::string const& file_path, volume_data_type const& data) const
+{
+  std::ofstream volume_file(file_path.c_str(), std::ios::out | std::ios::binary);
+  if (!volume_file.is_open())
+    return false;
+
+  if (!data.empty())
+    volume_file.write((const char*)&data[0], data.size());
+  return volume_file.good();
+}
+
+volume_data_type Volume_loader_raw::resample(volume_data_type const& data, glm::ivec3 const& dimensions,
+                                             unsigned byte_per_channel, unsigned channel_count,
+                                             glm::vec3 const& spacing, float target_spacing,
+                                             glm::ivec3& out_dimensions) const
+{
+  glm::vec3 extent = glm::vec3(dimensions) * spacing;
+  glm::ivec3 dims = glm::max(glm::ivec3(extent / target_spacing + 0.5f), glm::ivec3(1));
+  out_dimensions = dims;
+
+  channel_count = std::max(channel_count, 1u);
+  volume_data_type result(size_t(dims.x) * dims.y * dims.z * channel_count * byte_per_channel);
+  if (data.empty() || result.empty())
+    return result;
+
+  // voxel centers of the new grid in voxel coordinates of the old one
+  glm::vec3 scale = glm::vec3(dimensions) / glm::vec3(dims);
+  glm::ivec3 last = dimensions - glm::ivec3(1);
+
+  // the per axis weights only depend on one coordinate, x is tabulated once
+  std::vector<int> x0(dims.x);
+  std::vector<float> fx(dims.x);
+  for (int x = 0; x != dims.x; ++x) {
+    float p = std::min(std::max((x + 0.5f) * scale.x - 0.5f, 0.0f), float(last.x));
+    x0[x] = std::min(int(p), std::max(last.x - 1, 0));
+    fx[x] = p - x0[x];
+  }
+  int x_step = last.x > 0 ? 1 : 0;
+
+  parallel_for(0, dims.z, [&](int z_begin, int z_end) {
+    for (int z = z_begin; z != z_end; ++z) {
+      float pz = std::min(std::max((z + 0.5f) * scale.z - 0.5f, 0.0f), float(last.z));
+      int z0 = std::min(int(pz), std::max(last.z - 1, 0));
+      int z1 = std::min(z0 + 1, last.z);
+      float fz = pz - z0;
+
+      for (int y = 0; y != dims.y; ++y) {
+        float py = std::min(std::max((y + 0.5f) * scale.y - 0.5f, 0.0f), float(last.y));
+        int y0 = std::min(int(py), std::max(last.y - 1, 0));
+        int y1 = std::min(y0 + 1, last.y);
+        float fy = py - y0;
+
+        size_t rows[4] = {
+          size_t(dimensions.x) * (y0 + size_t(dimensions.y) * z0),
+          size_t(dimensions.x) * (y1 + size_t(dimensions.y) * z0),
+          size_t(dimensions.x) * (y0 + size_t(dimensions.y) * z1),
+          size_t(dimensions.x) * (y1 + size_t(dimensions.y) * z1)
+        };
+        float row_weights[4] = { (1.0f - fy) * (1.0f - fz), fy * (1.0f - fz), (1.0f - fy) * fz, fy * fz };
+        size_t out_row = size_t(dims.x) * (y + size_t(dims.y) * z);
+
+        for (int x = 0; x != dims.x; ++x) {
+          for (unsigned c = 0; c != channel_count; ++c) {
+            float value = 0.0f;
+            for (int r = 0; r != 4; ++r) {
+              size_t i = (rows[r] + x0[x]) * channel_count + c;
+              float a = get_texture_value(data, i, byte_per_channel);
+              float b = get_texture_value(data, i + x_step * channel_count, byte_per_channel);
+              value += row_weights[r] * (a + (b - a) * fx[x]);
+            }
+            set_texture_value(result, (out_row + x) * channel_count + c, byte_per_channel, value);
+          }
+        }
+      }
+    }
+  });
+
+  return result;
+}
@@ -6,6 +6,7 @@
 #include <array>
 #include <string>
 
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
 
@@ -14,11 +15,51 @@ class Volume_loader_raw
 public:
   Volume_loader_raw() {}
 
+  // empty if the file is missing or shorter than its name describes
   volume_data_type load_volume(std::string file_path);
 
+  // ids of a segmentation, one 8 or 16 bit channel in host byte order;
+  // empty if the file is missing or holds anything else
+  volume_data_type load_labels(std::string const& file_path);
+
   glm::ivec3 get_dimensions(const std::string file_path) const;
   unsigned   get_channel_count(const std::string file_path) const;
   unsigned   get_bit_per_channel(const std::string file_path) const;
+  // big endian files are marked with a "_be" token: "name_wxx_hxx_dxx_cx_bx_be.raw"
+  bool       get_big_endian(const std::string file_path) const;
+
+  // bytes of samples the name describes, 0 if a field is missing
+  size_t     get_data_size(const std::string file_path) const;
+  // true if the file exists and holds all those samples
+  bool       is_readable(const std::string file_path) const;
+
+  // voxel size per axis from the sidecar "<file>.spacing" holding three numbers,
+  // (1, 1, 1) if there is none
+  glm::vec3  get_spacing(const std::string file_path) const;
+
+  // reverses the byte order of every channel value in place
+  void       swap_endianness(volume_data_type& data, unsigned byte_per_channel) const;
+
+  // min and max value in texture units (normalized for 8/16 bit, raw for 32 bit float)
+  glm::vec2  get_value_range(volume_data_type const& data, unsigned byte_per_channel) const;
+
+  // maps 16 bit or float data to 8 bit through the equalized histogram of the given range
+  volume_data_type equalize_to_8bit(volume_data_type const& data, unsigned byte_per_channel, glm::vec2 const& range) const;
+
+  // copy of the voxels in [begin, end), rows are copied whole
+  volume_data_type extract(volume_data_type const& data, glm::ivec3 const& dimensions,
+                           unsigned byte_per_channel, unsigned channel_count,
+                           glm::ivec3 const& begin, glm::ivec3 const& end) const;
+
+  // raw samples in host byte order, name the file like the loader expects
+  bool save_volume(std::string const& file_path, volume_data_type const& data) const;
+
+  // trilinear resampling to cubic voxels of target_spacing, the new
+  // dimensions are returned in out_dimensions
+  volume_data_type resample(volume_data_type const& data, glm::ivec3 const& dimensions,
+                            unsigned byte_per_channel, unsigned channel_count,
+                            glm::vec3 const& spacing, float target_spacing,
+                            glm::ivec3& out_dimensions) const;
 private:
 };
 
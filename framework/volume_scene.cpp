@@ -0,0 +1,149 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Volume_scene
+// -----------------------------------------------------------------------------
+
+#include "volume_scene.hpp"
+#include "volume_data.hpp"
+
+#include <algorithm>
+
+#include <glm/common.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+glm::ivec3 get_halved(glm::ivec3 const& dimensions)
+{
+  return (dimensions + glm::ivec3(1)) / glm::ivec3(2);
+}
+
+// 2x2x2 box filter, odd dimensions repeat their last layer
+volume_data_type halve(volume_data_type const& data, glm::ivec3 const& dimensions,
+                       unsigned byte_per_channel)
+{
+  glm::ivec3 dims = get_halved(dimensions);
+  volume_data_type result(size_t(dims.x) * dims.y * dims.z * byte_per_channel);
+
+  parallel_for(0, dims.z, [&](int z_begin, int z_end) {
+    for (int z = z_begin; z != z_end; ++z) {
+      int z0 = 2 * z, z1 = std::min(2 * z + 1, dimensions.z - 1);
+      for (int y = 0; y != dims.y; ++y) {
+        int y0 = 2 * y, y1 = std::min(2 * y + 1, dimensions.y - 1);
+        for (int x = 0; x != dims.x; ++x) {
+          int x0 = 2 * x, x1 = std::min(2 * x + 1, dimensions.x - 1);
+
+          float sum = 0.0f;
+          const int zs[2] = { z0, z1 }, ys[2] = { y0, y1 }, xs[2] = { x0, x1 };
+          for (int k = 0; k != 8; ++k) {
+            size_t index = xs[k & 1] + dimensions.x * (ys[(k >> 1) & 1] + size_t(dimensions.y) * zs[k >> 2]);
+            sum += get_texture_value(data, index, byte_per_channel);
+          }
+
+          set_texture_value(result, x + dims.x * (y + size_t(dims.y) * z), byte_per_channel, sum * 0.125f);
+        }
+      }
+    }
+  });
+
+  return result;
+}
+
+} // namespace
+
+glm::ivec3 Scene_volume::get_resident_dimensions() const
+{
+  glm::ivec3 dims = dimensions;
+  for (int l = 0; l < level; ++l)
+    dims = get_halved(dims);
+  return dims;
+}
+
+size_t Scene_volume::get_resident_bytes() const
+{
+  glm::ivec3 dims = get_resident_dimensions();
+  return size_t(dims.x) * dims.y * dims.z * byte_per_channel;
+}
+
+glm::mat4 Scene_volume::get_model() const
+{
+  return glm::translate(glm::mat4(1.0f), position)
+       * glm::rotate(glm::mat4(1.0f), yaw, glm::vec3(0.0f, 1.0f, 0.0f))
+       * glm::scale(glm::mat4(1.0f), glm::vec3(scale))
+       * glm::translate(glm::mat4(1.0f), -0.5f * bounds);
+}
+
+Volume_scene::Volume_scene(size_t budget)
+  : m_volumes()
+  , m_budget(budget)
+{}
+
+unsigned Volume_scene::add(Scene_volume const& volume)
+{
+  m_volumes.push_back(volume);
+  m_volumes.back().level = 0;
+  return unsigned(m_volumes.size() - 1);
+}
+
+void Volume_scene::remove(unsigned index)
+{
+  if (index < m_volumes.size())
+    m_volumes.erase(m_volumes.begin() + index);
+}
+
+size_t Volume_scene::get_resident_bytes() const
+{
+  size_t bytes = 0;
+  for (unsigned i = 0; i != m_volumes.size(); ++i)
+    bytes += m_volumes[i].get_resident_bytes();
+  return bytes;
+}
+
+std::vector<unsigned> Volume_scene::fit_budget()
+{
+  std::vector<int> previous(m_volumes.size());
+  for (unsigned i = 0; i != m_volumes.size(); ++i) {
+    previous[i] = m_volumes[i].level;
+    m_volumes[i].level = 0;
+  }
+
+  while (get_resident_bytes() > m_budget) {
+    // single voxels cannot shrink any further
+    int largest = -1;
+    for (unsigned i = 0; i != m_volumes.size(); ++i) {
+      if (m_volumes[i].get_resident_dimensions() == glm::ivec3(1))
+        continue;
+      if (largest < 0 || m_volumes[i].get_resident_bytes() > m_volumes[largest].get_resident_bytes())
+        largest = int(i);
+    }
+    if (largest < 0)
+      break;
+    ++m_volumes[largest].level;
+  }
+
+  std::vector<unsigned> changed;
+  for (unsigned i = 0; i != m_volumes.size(); ++i)
+    if (m_volumes[i].level != previous[i])
+      changed.push_back(i);
+  return changed;
+}
+
+volume_data_type Volume_scene::get_resident_data(unsigned index) const
+{
+  Scene_volume const& volume = m_volumes[index];
+  if (volume.level == 0)
+    return volume.data;
+
+  glm::ivec3 dims = volume.dimensions;
+  volume_data_type data = halve(volume.data, dims, volume.byte_per_channel);
+  dims = get_halved(dims);
+  for (int l = 1; l < volume.level; ++l) {
+    data = halve(data, dims, volume.byte_per_channel);
+    dims = get_halved(dims);
+  }
+  return data;
+}
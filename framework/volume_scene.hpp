@@ -0,0 +1,80 @@
+#ifndef VOLUME_SCENE_HPP
+#define VOLUME_SCENE_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Volume_scene
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <string>
+#include <vector>
+
+// single channel volume placed in the scene; its object space spans
+// [0, bounds] like the proxy geometry of the main volume
+struct Scene_volume
+{
+  std::string      name;
+  volume_data_type data;
+  glm::ivec3       dimensions;
+  unsigned         byte_per_channel;
+  glm::vec2        data_range;
+  glm::vec3        bounds;
+
+  glm::vec3        position;           // of the volume center in the scene
+  float            yaw;                // around the scene y axis
+  float            scale;
+  image_data_type  transfer_function;
+
+  int              level;              // the texture holds the data reduced 2^level times
+
+  glm::ivec3 get_resident_dimensions() const;
+  size_t     get_resident_bytes() const;
+
+  // object space to scene space
+  glm::mat4  get_model() const;
+};
+
+// volumes rendered together, their textures share one memory budget
+class Volume_scene
+{
+public:
+  explicit Volume_scene(size_t budget = size_t(256) << 20);
+
+  unsigned add(Scene_volume const& volume);
+  void     remove(unsigned index);
+  void     clear() { m_volumes.clear(); }
+
+  unsigned size() const { return unsigned(m_volumes.size()); }
+  bool     empty() const { return m_volumes.empty(); }
+
+  Scene_volume&       operator[](unsigned index) { return m_volumes[index]; }
+  Scene_volume const& operator[](unsigned index) const { return m_volumes[index]; }
+
+  void   set_budget(size_t bytes) { m_budget = bytes; }
+  size_t get_budget() const { return m_budget; }
+  size_t get_resident_bytes() const;
+
+  // starting from full resolution, the largest resident volume is halved until
+  // all fit; returns the volumes whose level changed
+  std::vector<unsigned> fit_budget();
+
+  // the data of a volume at its level, 2x2x2 box averages per level
+  volume_data_type get_resident_data(unsigned index) const;
+
+private:
+  std::vector<Scene_volume> m_volumes;
+  size_t                    m_budget;
+};
+
+#endif // VOLUME_SCENE_HPP
@@ -0,0 +1,107 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Y4m_writer
+// -----------------------------------------------------------------------------
+
+#include "y4m_writer.hpp"
+
+#include <algorithm>
+
+namespace {
+
+glm::ivec2 get_chroma_size(glm::ivec2 const& size)
+{
+  return (size + glm::ivec2(1)) / glm::ivec2(2);
+}
+
+} // namespace
+
+Y4m_writer::Y4m_writer()
+  : m_file()
+  , m_size(0)
+  , m_frame_count(0)
+{}
+
+bool Y4m_writer::open(std::string const& file_path, glm::ivec2 const& size, unsigned frames_per_second)
+{
+  close();
+
+  m_file.open(file_path.c_str(), std::ios::out | std::ios::binary);
+  if (!m_file.is_open())
+    return false;
+
+  m_size = size;
+  m_frame_count = 0;
+  m_file << "YUV4MPEG2 W" << size.x << " H" << size.y << " F" << frames_per_second
+         << ":1 Ip A1:1 C420jpeg\n";
+  return m_file.good();
+}
+
+bool Y4m_writer::write_frame(std::vector<unsigned char> const& yuv)
+{
+  if (!m_file.is_open())
+    return false;
+
+  m_file << "FRAME\n";
+  m_file.write((const char*)&yuv[0], std::streamsize(yuv.size()));
+  ++m_frame_count;
+  return m_file.good();
+}
+
+bool Y4m_writer::close()
+{
+  if (!m_file.is_open())
+    return false;
+
+  bool good = m_file.good();
+  m_file.close();
+  return good;
+}
+
+void Y4m_writer::convert(image_data_type const& rgba, glm::ivec2 const& size,
+                         std::vector<unsigned char>& yuv)
+{
+  glm::ivec2 chroma = get_chroma_size(size);
+  size_t luma_bytes = size_t(size.x) * size.y;
+  size_t chroma_bytes = size_t(chroma.x) * chroma.y;
+  yuv.resize(luma_bytes + 2 * chroma_bytes);
+
+  unsigned char* y_plane = &yuv[0];
+  unsigned char* u_plane = y_plane + luma_bytes;
+  unsigned char* v_plane = u_plane + chroma_bytes;
+
+  // fixed point coefficients scaled by 256
+  for (int y = 0; y != size.y; ++y) {
+    const unsigned char* row = &rgba[size_t(size.y - 1 - y) * size.x * 4];
+    for (int x = 0; x != size.x; ++x) {
+      int r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+      y_plane[size_t(y) * size.x + x] = (unsigned char)((66 * r + 129 * g + 25 * b + 128 + (16 << 8)) >> 8);
+    }
+  }
+
+  for (int cy = 0; cy != chroma.y; ++cy) {
+    int y0 = 2 * cy, y1 = std::min(2 * cy + 1, size.y - 1);
+    const unsigned char* rows[2] = { &rgba[size_t(size.y - 1 - y0) * size.x * 4],
+                                     &rgba[size_t(size.y - 1 - y1) * size.x * 4] };
+    for (int cx = 0; cx != chroma.x; ++cx) {
+      int x0 = 2 * cx, x1 = std::min(2 * cx + 1, size.x - 1);
+
+      int r = 0, g = 0, b = 0;
+      for (int k = 0; k != 4; ++k) {
+        const unsigned char* pixel = rows[k >> 1] + (k & 1 ? x1 : x0) * 4;
+        r += pixel[0];
+        g += pixel[1];
+        b += pixel[2];
+      }
+
+      // sums of four pixels, the shift folds in the average
+      size_t index = size_t(cy) * chroma.x + cx;
+      u_plane[index] = (unsigned char)((-38 * r - 74 * g + 112 * b + 512 + (128 << 10)) >> 10);
+      v_plane[index] = (unsigned char)((112 * r - 94 * g - 18 * b + 512 + (128 << 10)) >> 10);
+    }
+  }
+}
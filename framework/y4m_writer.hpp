@@ -0,0 +1,52 @@
+#ifndef Y4M_WRITER_HPP
+#define Y4M_WRITER_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2015 Sebastian Thiele
+// License    : MIT (see the file LICENSE)
+// Maintainer : Sebastian Thiele <sebastian.thiele@uni-weimar.de>
+// Stability  : experimental
+//
+// Y4m_writer
+// -----------------------------------------------------------------------------
+
+#include "data_types_fwd.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// uncompressed YUV4MPEG2 video with 4:2:0 chroma, readable by common players
+// and encoders without any library
+class Y4m_writer
+{
+public:
+  Y4m_writer();
+
+  bool open(std::string const& file_path, glm::ivec2 const& size, unsigned frames_per_second);
+
+  // a frame converted with convert, frames are appended in call order
+  bool write_frame(std::vector<unsigned char> const& yuv);
+
+  bool close();
+
+  bool       is_open() const { return m_file.is_open(); }
+  glm::ivec2 get_size() const { return m_size; }
+  unsigned   get_frame_count() const { return m_frame_count; }
+
+  // RGBA rows bottom up (as read back from GL) to the planes of one frame,
+  // BT.601 studio range; chroma is averaged over 2x2 pixels. Independent of
+  // any writer, so frames can be converted in parallel
+  static void convert(image_data_type const& rgba, glm::ivec2 const& size,
+                      std::vector<unsigned char>& yuv);
+
+private:
+  std::ofstream m_file;
+  glm::ivec2    m_size;
+  unsigned      m_frame_count;
+};
+
+#endif // Y4M_WRITER_HPP
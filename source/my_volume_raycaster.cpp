@@ -20,6 +20,12 @@
 #include <algorithm>
 #include <stdexcept>
 #include <cmath>
+#include <map>
+#include <deque>
+#include <iomanip>
+#include <vector>
+#include <future>
+#include <chrono>
 
          ///GLM INCLUDES
 #define GLM_FORCE_RADIANS
@@ -28,12 +34,35 @@
 #include <glm/gtc/matrix_access.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/norm.hpp>
+#include <glm/gtx/component_wise.hpp>
 
          ///PROJECT INCLUDES
 #include <volume_loader_raw.hpp>
 #include <transfer_function.hpp>
 #include <utils.hpp>
 #include <turntable.hpp>
+#include <framebuffer.hpp>
+#include <brick_grid.hpp>
+#include <proxy_geometry.hpp>
+#include <iso_surface.hpp>
+#include <illumination_volume.hpp>
+#include <occlusion_volume.hpp>
+#include <transfer_function_library.hpp>
+#include <transfer_function_animation.hpp>
+#include <mesh_geometry.hpp>
+#include <thread_pool.hpp>
+#include <volume_filter.hpp>
+#include <slice_extractor.hpp>
+#include <slab_projector.hpp>
+#include <label_volume.hpp>
+#include <volume_scene.hpp>
+#include <pixel_readback.hpp>
+#include <ppm_writer.hpp>
+#include <camera_path.hpp>
+#include <y4m_writer.hpp>
+#include <control_server.hpp>
+#include <shared_memory.hpp>
+#include <shared_frame_ring.hpp>
 #include <imgui.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>        // stb_image.h for PNG loading
@@ -64,6 +93,18 @@
 const std::string g_file_vertex_shader("../../../source/shader/volume.vert");
 const std::string g_file_fragment_shader("../../../source/shader/volume.frag");
 
+const std::string g_ray_entry_exit_vertex_shader("../../../source/shader/ray_entry_exit.vert");
+const std::string g_ray_entry_exit_fragment_shader("../../../source/shader/ray_entry_exit.frag");
+
+const std::string g_iso_mesh_vertex_shader("../../../source/shader/iso_mesh.vert");
+const std::string g_iso_mesh_fragment_shader("../../../source/shader/iso_mesh.frag");
+
+const std::string g_deferred_shading_fragment_shader("../../../source/shader/deferred_shading.frag");
+
+const std::string g_slice_fragment_shader("../../../source/shader/slice.frag");
+
+const std::string g_scene_fragment_shader("../../../source/shader/scene.frag");
+
 const std::string g_GUI_file_vertex_shader("../../../source/shader/pass_through_GUI.vert");
 const std::string g_GUI_file_fragment_shader("../../../source/shader/pass_through_GUI.frag");
 
@@ -74,40 +115,44 @@ GLuint loadShaders(std::string const& vs, std::string const& fs)
     return createProgram(v, f);
 }
 
+// replaces the value of "#define name value" in a shader source
+void setShaderDefine(std::string& source, std::string const& name, const int value)
+{
+    std::string key = "#define " + name + " ";
+    size_t index = source.find(key);
+    if (index == std::string::npos)
+        return;
+
+    index += key.size();
+    size_t end = source.find_first_of(" \t\r\n", index);
+
+    std::stringstream ss;
+    ss << value;
+    source.replace(index, end - index, ss.str());
+}
+
+typedef std::map<std::string, int> shader_defines_type;
+
 GLuint loadShaders(
     std::string const& vs,
     std::string const& fs,
     const int task_nbr,
     const int enable_lightning,
     const int enable_shadowing,
-    const int enable_opeacity_cor)
+    const int enable_opeacity_cor,
+    shader_defines_type const& defines = shader_defines_type())
 {
     std::string v = readFile(vs);
     std::string f = readFile(fs);
 
-    std::stringstream ss1;
-    ss1 << task_nbr;
-
-    int index = f.find("#define TASK");
-    f.replace(index + 13, 2, ss1.str());
-
-    std::stringstream ss2;
-    ss2 << enable_opeacity_cor;
-
-    index = f.find("#define ENABLE_OPACITY_CORRECTION");
-    f.replace(index + 34, 1, ss2.str());
-
-    std::stringstream ss3;
-    ss3 << enable_lightning;
+    setShaderDefine(f, "TASK", task_nbr);
+    setShaderDefine(f, "ENABLE_OPACITY_CORRECTION", enable_opeacity_cor);
+    setShaderDefine(f, "ENABLE_LIGHTNING", enable_lightning);
+    setShaderDefine(f, "ENABLE_SHADOWING", enable_shadowing);
 
-    index = f.find("#define ENABLE_LIGHTNING");
-    f.replace(index + 25, 1, ss3.str());
-
-    std::stringstream ss4;
-    ss4 << enable_shadowing;
-
-    index = f.find("#define ENABLE_SHADOWING");
-    f.replace(index + 25, 1, ss4.str());
+    for (shader_defines_type::const_iterator d = defines.begin(); d != defines.end(); ++d) {
+        setShaderDefine(f, d->first, d->second);
+    }
 
     //std::cout << f << std::endl;
 
@@ -143,6 +188,10 @@ Window g_win(g_window_res);
 
 // Volume Rendering GLSL Program
 GLuint g_volume_program(0);
+GLuint g_ray_entry_exit_program(0);
+GLuint g_iso_mesh_program(0);
+GLuint g_deferred_shading_program(0);
+GLuint g_slice_program(0);
 std::string g_error_message;
 bool g_reload_shader_error = false;
 
@@ -150,11 +199,52 @@ Transfer_function g_transfer_fun;
 int g_current_tf_data_value = 0;
 GLuint g_transfer_texture;
 bool g_transfer_dirty = true;
+
+// named transfer function presets with their baked tables
+Transfer_function_library g_tf_library;
+const std::string g_tf_library_file("transfer_functions.tflib");
+const std::string g_tf_library_text_file("transfer_functions.txt");
+int g_preset_current = 0;
+
+// timed blends between baked tables, the previous classification is kept for comparison
+Transfer_function_animation g_tf_animation;
+float g_tf_transition_seconds = 1.0f;
+image_data_type g_transfer_lut;
+image_data_type g_transfer_shown;
+Transfer_function::container_type g_tf_previous_points;
+image_data_type g_tf_previous_lut;
 bool g_redraw_tf = true;
 bool g_lighting_toggle = false;
 bool g_shadow_toggle = false;
 bool g_opacity_correction_toggle = false;
 
+// early ray termination and step count instrumentation
+bool g_early_termination = true;
+float g_termination_alpha = 0.99f;
+glm::vec4 g_transfer_max = glm::vec4(1.0f);
+bool g_step_count_toggle = false;
+Framebuffer g_step_count_buffer;
+
+// first hit position and normal per pixel, ping-ponged so the last frame can seed the search
+bool g_hit_cache_toggle = false;
+Framebuffer g_hit_buffers[2];
+unsigned g_hit_buffer_index = 0;
+bool g_hit_cache_valid = false;
+float g_hit_cache_max_delta = 0.02f;
+int g_hit_search_steps = 4;
+glm::mat4 g_hit_cache_model_view;
+// seeded frames drift from the last full march, they are measured against it
+// and a full march is forced after a number of them
+glm::mat4 g_hit_cache_march_model_view;
+int g_hit_cache_seeded_frames = 0;
+int g_hit_cache_max_seeded_frames = 16;
+float g_hit_cache_iso_value = -1.0f;
+float g_hit_cache_sampling_distance = 0.0f;
+int g_hit_cache_interpolation = -1;
+
+// lights the hit buffer in a full screen pass instead of inside the ray loop
+bool g_deferred_shading = false;
+
 // imgui variables
 static bool g_show_gui = true;
 
@@ -184,111 +274,2344 @@ int g_task_chosen_old = g_task_chosen;
 
 bool  g_pause = false;
 
-Volume_loader_raw g_volume_loader;
-volume_data_type g_volume_data;
-glm::ivec3 g_vol_dimensions;
-glm::vec3 g_max_volume_bounds;
-unsigned g_channel_size = 0;
-unsigned g_channel_count = 0;
-GLuint g_volume_texture = 0;
-Cube g_cube;
+Volume_loader_raw g_volume_loader;
+volume_data_type g_volume_data;
+glm::ivec3 g_vol_dimensions;
+glm::vec3 g_max_volume_bounds;
+glm::vec3 g_voxel_spacing = glm::vec3(1.0f);
+bool g_resample_isotropic = false;
+int g_resample_max_resolution = 512;
+
+// region of interest as fractions of the volume, rays and CPU paths are clipped to it
+glm::vec3 g_roi_min = glm::vec3(0.0f);
+glm::vec3 g_roi_max = glm::vec3(1.0f);
+glm::vec3 g_roi_applied_min = glm::vec3(-1.0f);
+glm::vec3 g_roi_applied_max = glm::vec3(-1.0f);
+bool g_volume_cropped = false;
+
+// cutaway planes, each removes the side its normal points to; offsets are
+// relative to the volume center in half diagonals
+struct Clip_plane
+{
+    glm::vec3 normal;
+    float     offset;
+    bool      enabled;
+};
+
+const int g_max_clip_planes = 6;
+Clip_plane g_clip_planes[g_max_clip_planes] = {
+    { glm::vec3( 1.0f, 0.0f, 0.0f), 0.0f, true },
+    { glm::vec3(-1.0f, 0.0f, 0.0f), 0.0f, true },
+    { glm::vec3(0.0f,  1.0f, 0.0f), 0.0f, true },
+    { glm::vec3(0.0f, -1.0f, 0.0f), 0.0f, true },
+    { glm::vec3(0.0f, 0.0f,  1.0f), 0.0f, true },
+    { glm::vec3(0.0f, 0.0f, -1.0f), 0.0f, true }
+};
+int g_clip_plane_count = 0;
+std::vector<glm::vec4> g_clip_planes_applied;
+
+// axial, coronal, sagittal and oblique slices reformatted on the CPU, shown
+// in a column at the right window border
+struct Mpr_settings
+{
+    glm::vec3 center;      // fractions of the volume
+    float     yaw;         // oblique normal
+    float     pitch;
+    int       resolution;
+    float     slab_thickness;  // object units, 0 shows single slices
+    int       slab_mode;       // Slab_projector::Mode
+
+    bool operator==(Mpr_settings const& other) const
+    {
+        return center == other.center && yaw == other.yaw && pitch == other.pitch
+            && resolution == other.resolution && slab_thickness == other.slab_thickness
+            && slab_mode == other.slab_mode;
+    }
+};
+
+const int g_mpr_slice_count = 4;
+bool g_mpr_toggle = false;
+bool g_mpr_dirty = true;
+Mpr_settings g_mpr = { glm::vec3(0.5f), 0.6f, 0.4f, 0, 0.1f, Slab_projector::maximum };
+Mpr_settings g_mpr_applied = g_mpr;
+GLuint g_mpr_textures[g_mpr_slice_count] = { 0, 0, 0, 0 };
+image_data_type g_mpr_image;
+
+// thick slab around the slice center; the rays are bounded by two extra clip
+// planes and the slice views show the slab projections
+bool g_slab_toggle = false;
+int g_slab_orientation = 0;  // axial, coronal, sagittal, oblique
+unsigned g_channel_size = 0;
+unsigned g_channel_count = 0;
+glm::vec2 g_data_range = glm::vec2(0.0f, 1.0f);
+bool g_convert_to_8bit = false;
+bool g_half_float_texture = false;
+GLuint g_volume_texture = 0;
+Cube g_cube;
+
+// object space ray entry and exit positions, rasterized from the proxy geometry
+Framebuffer g_ray_entry_buffer;
+Framebuffer g_ray_exit_buffer;
+Plane g_screen_quad(glm::vec2(-1.0f), glm::vec2(1.0f));
+
+// proxy geometry around the bricks that are visible under the transfer function
+struct Brick_proxy_result
+{
+    Brick_grid::occupancy_type occupancy;
+    std::vector<glm::vec3>     triangles;
+    bool                       changed;
+};
+
+Brick_grid g_brick_grid;
+Proxy_geometry g_brick_proxy;
+Brick_grid::occupancy_type g_brick_occupancy;
+std::future<Brick_proxy_result> g_brick_proxy_job;
+image_data_type g_brick_proxy_pending_tf;
+bool g_brick_proxy_pending = false;
+bool g_use_brick_proxy = true;
+
+// iso surface mesh, rasterized instead of ray casting in mesh mode
+Iso_surface_extractor g_iso_extractor;
+Iso_mesh g_iso_mesh;
+Mesh_geometry g_iso_mesh_geometry;
+bool g_iso_mesh_mode = false;
+std::future<Iso_mesh> g_iso_mesh_job;
+float g_iso_mesh_requested = -1.0f;
+
+// light transmittance for compositing shadows, swept over several frames within a budget
+Illumination_volume g_illumination_volume;
+GLuint g_illumination_texture = 0;
+float g_illumination_budget_ms = 4.0f;
+float g_illumination_reference_step = 0.0f;
+
+// ambient visibility baked per transfer function on a worker, only while enabled
+Occlusion_volume g_occlusion_volume;
+std::future<volume_data_type> g_occlusion_job;
+GLuint g_occlusion_texture = 0;
+bool g_occlusion_toggle = false;
+bool g_occlusion_dirty = true;
+int g_occlusion_radius = 3;
+float g_occlusion_strength = 1.0f;
+
+// volumes are read and indexed on the pool, the current one is shown until the new one is ready
+struct Volume_load
+{
+    std::string           file;
+    std::string           error;         // set if the file could not be read
+    bool                  cropped;
+    bool                  convert_to_8bit;
+    bool                  resample_isotropic;
+    int                   resample_max_resolution;
+    Volume_filter_pipeline filters;
+    volume_data_type      data;
+    glm::ivec3            dimensions;
+    glm::vec3             spacing;
+    glm::vec3             bounds;
+    unsigned              channel_size;
+    unsigned              channel_count;
+    glm::vec2             data_range;
+    Brick_grid            brick_grid;
+    Iso_surface_extractor iso_extractor;
+    Illumination_volume   illumination;
+    Occlusion_volume      occlusion;
+};
+
+std::future<std::shared_ptr<Volume_load>> g_volume_load_job;
+std::string g_volume_load_pending_file;
+bool g_volume_load_pending = false;
+std::string g_volume_load_status;
+std::string g_volume_file;                                        // file of the volume shown
+
+// smoothing chain applied to every load before classification
+Volume_filter_pipeline g_volume_filters;
+int g_filter_type = Volume_filter::gaussian;
+float g_filter_sigma = 1.0f;
+float g_filter_range_sigma = 0.1f;
+
+// segmentation ids next to the intensities; visibility, color and transfer
+// function of a label live in its row of the label transfer texture, so
+// toggling a label rewrites one row and the volumes stay on the GPU
+struct Label_load
+{
+    std::string                   file;
+    volume_data_type              data;
+    glm::ivec3                    dimensions;
+    unsigned                      byte_per_label;
+    std::shared_ptr<Label_volume> index;
+};
+
+std::shared_ptr<const Label_volume> g_label_volume;
+std::vector<Label_style> g_label_styles;
+image_data_type g_label_rows;
+GLuint g_label_texture = 0;
+GLuint g_label_transfer_texture = 0;
+bool g_label_toggle = false;
+int g_label_selected = 0;
+char g_label_file[256] = "";
+std::future<std::shared_ptr<Label_load>> g_label_load_job;
+
+// further volumes rendered together in one ray loop, each with its own
+// transform and transfer function row; their textures share one budget
+const unsigned g_max_scene_volumes = 4;
+Volume_scene g_scene;
+std::vector<GLuint> g_scene_textures;
+GLuint g_scene_transfer_texture = 0;
+GLuint g_scene_program = 0;
+bool g_scene_toggle = false;
+int g_scene_selected = 0;
+int g_scene_budget_mb = 256;
+std::future<std::shared_ptr<Scene_volume>> g_scene_load_job;
+
+// screenshots and posters larger than the window; frames are read back through
+// pixel buffers without stalling and written as PPM files on the thread pool
+Pixel_readback g_readback;
+image_data_type g_readback_pixels;
+bool g_screenshot_requested = false;
+int g_screenshot_count = 0;
+std::future<bool> g_screenshot_job;
+std::string g_image_status;
+
+// the poster is rendered one window sized tile per frame with a sub-frustum of
+// the full projection; tiles are collected into bands of rows that are
+// appended to the file one after another, so only one band is in memory
+glm::ivec2 g_poster_request = glm::ivec2(8192, 8192);
+glm::ivec2 g_poster_size;
+glm::ivec2 g_poster_tile_size;
+Turntable g_poster_pose;
+bool g_poster_active = false;
+int g_poster_tile = 0;
+std::string g_poster_file;
+std::shared_ptr<Ppm_writer> g_poster_writer;
+std::shared_ptr<std::vector<unsigned char>> g_poster_band;
+Thread_pool::task_handle g_poster_write_task;
+std::future<bool> g_poster_job;
+
+// camera paths through turntable poses, keyed by hand, recorded while the
+// mouse moves the volume or generated as an orbit
+Camera_path g_camera_path;
+Turntable g_camera_pose;
+bool g_camera_playing = false;
+double g_camera_play_start = 0.0;
+bool g_camera_recording = false;
+double g_camera_record_start = 0.0;
+double g_camera_record_last = 0.0;
+float g_camera_record_interval = 0.25f;
+float g_camera_key_spacing = 2.0f;
+float g_orbit_seconds = 8.0f;
+float g_orbit_turns = 1.0f;
+
+// the path is exported one frame per loop at a fixed sampling step; while a
+// frame renders the ones before it are read back, converted in parallel and
+// appended in order on the thread pool
+enum Export_format { export_y4m, export_ppm_sequence };
+int g_export_format = export_y4m;
+int g_export_fps = 30;
+float g_export_sampling_distance = 0.0005f;
+float g_export_previous_sampling_distance = 0.0f;
+const unsigned g_export_max_frames_in_flight = 8;
+bool g_export_active = false;
+int g_export_frame = 0;
+int g_export_frame_count = 0;
+glm::ivec2 g_export_size;
+bool g_export_failed = false;
+std::string g_export_file;
+Pixel_readback g_export_readback;
+std::shared_ptr<Y4m_writer> g_export_video;
+Thread_pool::task_handle g_export_write_task;
+std::deque<std::future<bool>> g_export_writes;
+
+// scripts drive the renderer through a local socket; the commands of a frame
+// are applied before it renders and frames are returned in shared memory
+Control_server g_control;
+char g_control_socket[256] = "/tmp/scivis_control.sock";
+std::string g_control_status;
+bool g_control_camera = false;
+Turntable g_control_pose;
+Pixel_readback g_control_readback;
+std::vector<unsigned> g_control_frame_clients;                     // waiting for the next frame
+std::map<int, std::vector<unsigned>> g_control_frame_reads;        // by readback tag
+std::map<unsigned, std::shared_ptr<Shared_memory>> g_control_frames;
+int g_control_frame_id = 0;
+
+// every shown frame is published to a shared memory ring that encoders and
+// streamers in other processes read in place; the pixels go from the pixel
+// buffer straight into a ring slot
+Shared_frame_ring g_frame_ring;
+char g_frame_ring_name[64] = "/scivis_frames";
+int g_frame_ring_slots = 4;
+glm::ivec2 g_frame_ring_size;
+std::string g_frame_ring_status;
+Pixel_readback g_frame_ring_readback;
+std::map<int, std::uint64_t> g_frame_ring_times;   // render time by readback tag
+int g_frame_ring_id = 0;
+unsigned g_frame_ring_published = 0;
+unsigned g_frame_ring_dropped = 0;
+
+int g_bilinear_interpolation = true;
+
+const std::string g_volume_files[] = {
+    "../../../data/head_w256_h256_d225_c1_b8.raw",
+    "../../../data/Engine_w256_h256_d256_c1_b8.raw",
+    "../../../data/Bucky_uncertainty_data_w32_h32_d32_c1_b8.raw"
+};
+
+// the hit buffer was written for the current surface and window size
+bool hit_cache_current(glm::ivec2 const& size)
+{
+    return g_hit_cache_valid
+        && g_hit_buffers[g_hit_buffer_index].get_size() == size
+        && g_hit_cache_iso_value == g_iso_value
+        && g_hit_cache_sampling_distance == g_sampling_distance
+        && g_hit_cache_interpolation == g_bilinear_interpolation;
+}
+
+// the cached hits only seed the search if the camera and the surface barely
+// changed since the last full march
+bool hit_cache_usable(glm::mat4 const& model_view, glm::ivec2 const& size)
+{
+    if (!hit_cache_current(size) || g_hit_cache_seeded_frames >= g_hit_cache_max_seeded_frames)
+        return false;
+
+    float delta = 0.0f;
+    for (int c = 0; c != 4; ++c)
+        delta = glm::max(delta, glm::compMax(glm::abs(model_view[c] - g_hit_cache_march_model_view[c])));
+
+    return delta <= g_hit_cache_max_delta;
+}
+
+// average steps per ray for each task, dataset and termination setting
+struct Benchmark_run
+{
+    std::string volume;
+    int         task;
+    bool        early_termination;
+    float       average_steps;
+};
+
+std::vector<Benchmark_run> g_benchmark_runs;
+unsigned g_benchmark_index = 0;
+bool g_benchmark_active = false;
+bool g_benchmark_restore_step_count = false;
+bool g_benchmark_restore_early_termination = false;
+int g_benchmark_restore_task = 21;
+std::string g_benchmark_restore_file;
+
+bool hit_cache_enabled()
+{
+    return g_hit_cache_toggle && (g_task_chosen == 31 || g_task_chosen == 32);
+}
+
+// the step count heat map replaces the color, so it is not shaded
+bool deferred_shading_enabled()
+{
+    return g_deferred_shading && g_lighting_toggle && !g_step_count_toggle
+        && (g_task_chosen == 31 || g_task_chosen == 32);
+}
+
+bool labels_enabled()
+{
+    return g_label_toggle && g_label_volume;
+}
+
+shader_defines_type get_shader_defines()
+{
+    shader_defines_type defines;
+    defines["ENABLE_STEP_COUNT"] = g_step_count_toggle;
+    defines["ENABLE_HIT_CACHE"] = hit_cache_enabled();
+    defines["ENABLE_DEFERRED_SHADING"] = deferred_shading_enabled();
+    defines["ENABLE_AMBIENT_OCCLUSION"] = g_occlusion_toggle;
+    defines["ENABLE_LABELS"] = labels_enabled();
+    return defines;
+}
+
+struct Manipulator
+{
+    Manipulator()
+    : m_turntable()
+    , m_mouse_button_pressed(0, 0, 0)
+    , m_mouse(0.0f, 0.0f)
+    , m_lastMouse(0.0f, 0.0f)
+    {}
+
+    glm::mat4 matrix()
+    {
+        m_turntable.rotate(m_slidelastMouse, m_slideMouse);
+        return m_turntable.matrix();
+    }
+
+    Turntable const& turntable() const
+    {
+        return m_turntable;
+    }
+
+    glm::mat4 matrix(Window const& g_win)
+    {
+        m_mouse = g_win.mousePosition();
+        if (g_win.isButtonPressed(Window::MOUSE_BUTTON_LEFT)) {
+            if (!m_mouse_button_pressed[0]) {
+                m_mouse_button_pressed[0] = 1;
+            }
+            m_turntable.rotate(m_lastMouse, m_mouse);
+            m_slideMouse = m_mouse;
+            m_slidelastMouse = m_lastMouse;
+        }
+        else {
+            m_mouse_button_pressed[0] = 0;
+            m_turntable.rotate(m_slidelastMouse, m_slideMouse);
+            //m_slideMouse *= 0.99f;
+            //m_slidelastMouse *= 0.99f;
+        }
+
+        if (g_win.isButtonPressed(Window::MOUSE_BUTTON_MIDDLE)) {
+            if (!m_mouse_button_pressed[1]) {
+                m_mouse_button_pressed[1] = 1;
+            }
+            m_turntable.pan(m_lastMouse, m_mouse);
+        }
+        else {
+            m_mouse_button_pressed[1] = 0;
+        }
+
+        if (g_win.isButtonPressed(Window::MOUSE_BUTTON_RIGHT)) {
+            if (!m_mouse_button_pressed[2]) {
+                m_mouse_button_pressed[2] = 1;
+            }
+            m_turntable.zoom(m_lastMouse, m_mouse);
+        }
+        else {
+            m_mouse_button_pressed[2] = 0;
+        }
+
+        m_lastMouse = m_mouse;
+        return m_turntable.matrix();
+    }
+
+private:
+    Turntable  m_turntable;
+    glm::ivec3 m_mouse_button_pressed;
+    glm::vec2  m_mouse;
+    glm::vec2  m_lastMouse;
+    glm::vec2  m_slideMouse;
+    glm::vec2  m_slidelastMouse;
+};
+
+void get_roi_voxels(glm::ivec3& begin, glm::ivec3& end);
+
+// classifies the bricks on a worker thread, geometry is only rebuilt if the occupancy changed
+void request_brick_proxy(image_data_type const& transfer_function)
+{
+    if (g_brick_proxy_job.valid()){
+        g_brick_proxy_pending_tf = transfer_function;
+        g_brick_proxy_pending = true;
+        return;
+    }
+
+    Brick_grid::occupancy_type previous = g_brick_occupancy;
+    glm::vec3 bounds = g_max_volume_bounds;
+    glm::ivec3 roi_begin, roi_end;
+    get_roi_voxels(roi_begin, roi_end);
+
+    // with labels a brick is skipped if all its labels are transparent in its value range
+    std::shared_ptr<const Label_volume> labels;
+    image_data_type label_rows;
+    if (labels_enabled()){
+        labels = g_label_volume;
+        label_rows = g_label_rows;
+    }
+
+    g_brick_proxy_job = Thread_pool::instance().submit([transfer_function, previous, bounds, roi_begin, roi_end, labels, label_rows]() {
+        Brick_proxy_result result;
+        result.occupancy = labels ? labels->classify(g_brick_grid, label_rows) : g_brick_grid.classify(transfer_function);
+        g_brick_grid.clip(result.occupancy, roi_begin, roi_end);
+        result.changed = result.occupancy != previous;
+        if (result.changed)
+            result.triangles = g_brick_grid.get_boundary_faces(result.occupancy, bounds);
+        return result;
+    });
+    g_brick_proxy_pending = false;
+}
+
+void update_brick_proxy()
+{
+    if (!g_brick_proxy_job.valid()
+        || g_brick_proxy_job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    Brick_proxy_result result = g_brick_proxy_job.get();
+    if (result.changed){
+        g_brick_occupancy = result.occupancy;
+        g_brick_proxy.update(result.triangles);
+    }
+
+    if (g_brick_proxy_pending)
+        request_brick_proxy(g_brick_proxy_pending_tf);
+}
+
+void upload_illumination_volume(bool resized)
+{
+    glm::ivec3 dims = g_illumination_volume.get_dimensions();
+    char* data = (char*)&g_illumination_volume.get_illumination()[0];
+
+    glActiveTexture(GL_TEXTURE7);
+    if (resized){
+        glDeleteTextures(1, &g_illumination_texture);
+        g_illumination_texture = createTexture3D(dims.x, dims.y, dims.z, 1, 1, data);
+    }
+    else {
+        glBindTexture(GL_TEXTURE_3D, g_illumination_texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, dims.x, dims.y, dims.z, GL_RED, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void upload_occlusion_volume(volume_data_type const& visibility)
+{
+    glm::ivec3 dims = g_occlusion_volume.get_dimensions();
+
+    glActiveTexture(GL_TEXTURE8);
+    glDeleteTextures(1, &g_occlusion_texture);
+    g_occlusion_texture = createTexture3D(dims.x, dims.y, dims.z, 1, 1, (char*)&visibility[0]);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// same size every time, update in place
+void upload_transfer_texture(image_data_type const& lut)
+{
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, g_transfer_texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, GLsizei(lut.size() / 4), 1, GL_RGBA, GL_UNSIGNED_BYTE, &lut[0]);
+    glActiveTexture(GL_TEXTURE0);
+    g_transfer_shown = lut;
+}
+
+// distinct hues along the golden ratio, label 0 is the background
+Label_style get_default_label_style(unsigned label)
+{
+    float hue = std::fmod(float(label) * 0.618034f, 1.0f);
+    glm::vec3 rgb = glm::clamp(glm::abs(glm::fract(glm::vec3(hue) + glm::vec3(0.0f, 2.0f, 1.0f) / 3.0f) * 6.0f - 3.0f) - 1.0f,
+        0.0f, 1.0f);
+
+    Label_style style = { label != 0, glm::mix(glm::vec3(1.0f), rgb, 0.6f), 1.0f, image_data_type() };
+    return style;
+}
+
+// all rows again, the transfer function they follow changed
+void upload_label_rows(image_data_type const& lut)
+{
+    if (!g_label_volume || lut.empty())
+        return;
+
+    g_label_rows = Label_volume::get_transfer_rows(lut, g_label_styles);
+
+    glActiveTexture(GL_TEXTURE11);
+    if (!g_label_transfer_texture){
+        glGenTextures(1, &g_label_transfer_texture);
+        glBindTexture(GL_TEXTURE_2D, g_label_transfer_texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    glBindTexture(GL_TEXTURE_2D, g_label_transfer_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, GLsizei(lut.size() / 4), GLsizei(g_label_styles.size()), 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, &g_label_rows[0]);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// one label changed, only its row is rebuilt and uploaded
+void update_label_row(unsigned label)
+{
+    size_t row_size = g_transfer_shown.size();
+    if (!g_label_volume || label >= g_label_styles.size() || g_label_rows.size() != row_size * g_label_styles.size())
+        return;
+
+    Label_volume::get_transfer_row(g_transfer_shown, g_label_styles[label], &g_label_rows[label * row_size]);
+
+    glActiveTexture(GL_TEXTURE11);
+    glBindTexture(GL_TEXTURE_2D, g_label_transfer_texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, label, GLsizei(row_size / 4), 1, GL_RGBA, GL_UNSIGNED_BYTE,
+        &g_label_rows[label * row_size]);
+    glActiveTexture(GL_TEXTURE0);
+
+    if (labels_enabled())
+        request_brick_proxy(g_transfer_shown);
+}
+
+// labels belong to the volume they were loaded for
+void clear_labels()
+{
+    if (labels_enabled())
+        g_reload_shader = true;
+
+    g_label_volume.reset();
+    g_label_styles.clear();
+    g_label_rows.clear();
+    g_label_toggle = false;
+    g_label_selected = 0;
+    glDeleteTextures(1, &g_label_texture);
+    glDeleteTextures(1, &g_label_transfer_texture);
+    g_label_texture = 0;
+    g_label_transfer_texture = 0;
+}
+
+// reads the ids and indexes them per brick on the thread pool
+void request_labels(std::string const& file)
+{
+    if (g_label_load_job.valid())
+        return;
+
+    unsigned brick_size = g_brick_grid.get_brick_size();
+    g_label_load_job = Thread_pool::instance().submit([file, brick_size]() {
+        std::shared_ptr<Label_load> load(new Label_load);
+        Volume_loader_raw loader;
+        load->file = file;
+        load->data = loader.load_labels(file);
+        load->dimensions = loader.get_dimensions(file);
+        load->byte_per_label = loader.get_bit_per_channel(file) / 8;
+        load->index.reset(new Label_volume);
+        if (!load->data.empty())
+            load->index->build(load->data, load->dimensions, load->byte_per_label, brick_size);
+        return load;
+    });
+}
+
+void update_label_load()
+{
+    if (!g_label_load_job.valid()
+        || g_label_load_job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    std::shared_ptr<Label_load> load = g_label_load_job.get();
+    if (load->data.empty())
+        return;
+
+    if (load->dimensions != g_vol_dimensions){
+        std::cerr << "Labels " << load->file << " do not match the volume dimensions" << std::endl;
+        return;
+    }
+
+    GLint max_rows = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_rows);
+    if (load->index->get_label_count() > unsigned(max_rows)){
+        std::cerr << "Labels " << load->file << " hold more than " << max_rows << " ids" << std::endl;
+        return;
+    }
+
+    clear_labels();
+    g_label_volume = load->index;
+    for (unsigned l = 0; l != g_label_volume->get_label_count(); ++l)
+        g_label_styles.push_back(get_default_label_style(l));
+
+    glActiveTexture(GL_TEXTURE10);
+    g_label_texture = createLabelTexture3D(g_vol_dimensions.x, g_vol_dimensions.y, g_vol_dimensions.z,
+        load->byte_per_label, (char*)&load->data[0]);
+    glActiveTexture(GL_TEXTURE0);
+    upload_label_rows(g_transfer_shown);
+
+    g_label_toggle = true;
+    g_reload_shader = true;
+    g_hit_cache_valid = false;
+    request_brick_proxy(g_transfer_shown);
+}
+
+// everything that depends on the transfer function, from an already baked table
+void apply_transfer_lut(image_data_type const& lut)
+{
+    // the maximum intensity projection cannot exceed these values
+    g_transfer_max = glm::vec4(0.0f);
+    for (unsigned i = 0; i != lut.size() / 4; ++i){
+        g_transfer_max = glm::max(g_transfer_max, glm::vec4(lut[i * 4], lut[i * 4 + 1], lut[i * 4 + 2], lut[i * 4 + 3]) / 255.0f);
+    }
+
+    upload_label_rows(lut);
+    request_brick_proxy(lut);
+
+    // the deferred albedo comes from the transfer function
+    g_hit_cache_valid = false;
+
+    g_illumination_volume.set_transfer_function(lut, g_sampling_distance_ref);
+    g_occlusion_dirty = true;
+
+    upload_transfer_texture(lut);
+}
+
+// switches the classification, blending over g_tf_transition_seconds if set
+void transition_to(Transfer_function::container_type const& points, image_data_type const& lut)
+{
+    g_transfer_fun.get_piecewise_container() = points;
+    g_transfer_dirty = false;
+    g_transfer_lut = lut;
+
+    if (g_tf_transition_seconds <= 0.0f || g_transfer_shown.size() != lut.size()){
+        g_tf_animation.stop();
+        apply_transfer_lut(lut);
+        return;
+    }
+
+    // while blending, rays are bounded by what either table shows
+    image_data_type from = g_transfer_shown;
+    image_data_type both(lut.size());
+    for (size_t i = 0; i != lut.size(); ++i)
+        both[i] = std::max(from[i], lut[i]);
+    apply_transfer_lut(both);
+
+    g_tf_animation.start(from, lut, g_tf_transition_seconds, glfwGetTime());
+}
+
+// nothing to do without a running transition, the last step applies the target fully
+void update_transfer_animation()
+{
+    if (!g_tf_animation.is_active())
+        return;
+
+    image_data_type lut;
+    g_tf_animation.update(glfwGetTime(), lut);
+
+    if (g_tf_animation.is_active()){
+        upload_transfer_texture(lut);
+        upload_label_rows(lut);
+        g_hit_cache_valid = false;
+    }
+    else
+        apply_transfer_lut(lut);
+}
+
+void apply_preset(Transfer_function_preset const& preset)
+{
+    g_tf_previous_points = g_transfer_fun.get_piecewise_container();
+    g_tf_previous_lut = g_transfer_lut;
+    transition_to(preset.points, preset.lut);
+}
+
+bool get_preset_name(void* data, int index, const char** out_text)
+{
+    Transfer_function_library const* library = (Transfer_function_library const*)data;
+    if (index < 0 || index >= (int)library->size())
+        return false;
+    *out_text = library->get(index).name.c_str();
+    return true;
+}
+
+void save_tf_library()
+{
+    if (!g_tf_library.save(g_tf_library_file))
+        std::cerr << "Could not write " << g_tf_library_file << std::endl;
+}
+
+// the files of the former TF1..TF6 buttons, raw std::pair<unsigned, glm::vec4> arrays
+void import_legacy_transfer_functions()
+{
+    const char* names[] = { "TF1", "TF2", "TF3", "TF4", "TF5", "TF6" };
+    bool imported = false;
+
+    for (unsigned n = 0; n != IM_ARRAYSIZE(names); ++n){
+        std::ifstream tf_file(names[n], std::ios::in | std::ifstream::binary);
+        if (!tf_file.good())
+            continue;
+
+        std::vector<Transfer_function::element_type> load_vect;
+        tf_file.seekg(0, tf_file.end);
+        size_t size = tf_file.tellg();
+        load_vect.resize(size / sizeof(Transfer_function::element_type));
+        tf_file.seekg(0);
+        if (load_vect.empty() || !tf_file.read((char*)&load_vect[0], load_vect.size() * sizeof(Transfer_function::element_type)))
+            continue;
+
+        Transfer_function::container_type points(load_vect.begin(), load_vect.end());
+        g_tf_library.set(Transfer_function_library::make_preset(names[n], points));
+        imported = true;
+    }
+
+    if (imported)
+        save_tf_library();
+}
+
+// starts a bake if the occlusion is shown and out of date, one job at a time
+void update_occlusion_volume()
+{
+    if (g_occlusion_job.valid()
+        && g_occlusion_job.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+        upload_occlusion_volume(g_occlusion_job.get());
+    }
+
+    if (!g_occlusion_toggle || !g_occlusion_dirty || g_occlusion_job.valid())
+        return;
+
+    image_data_type transfer_function = g_transfer_fun.get_RGBA_transfer_function_buffer();
+    float reference_step = g_sampling_distance_ref;
+    int radius = g_occlusion_radius;
+    float strength = g_occlusion_strength;
+
+    g_occlusion_job = Thread_pool::instance().submit([transfer_function, reference_step, radius, strength]() {
+        return g_occlusion_volume.compute(transfer_function, reference_step, radius, strength);
+    });
+    g_occlusion_dirty = false;
+}
+
+void submit_volume_indexing(std::shared_ptr<Volume_load> const& load, Thread_pool::task_handle const& ready);
+
+// reading comes first, the indices over the data are then built side by side
+void request_volume(std::string const& file)
+{
+    if (g_volume_load_job.valid()){
+        g_volume_load_pending_file = file;
+        g_volume_load_pending = true;
+        return;
+    }
+
+    std::shared_ptr<Volume_load> load = std::make_shared<Volume_load>();
+    load->file = file;
+    load->cropped = false;
+    load->convert_to_8bit = g_convert_to_8bit;
+    load->resample_isotropic = g_resample_isotropic;
+    load->resample_max_resolution = g_resample_max_resolution;
+    load->filters = g_volume_filters;
+
+    Thread_pool& pool = Thread_pool::instance();
+
+    Thread_pool::task_handle read;
+    pool.submit([load]() {
+        load->dimensions = g_volume_loader.get_dimensions(load->file);
+        load->spacing = g_volume_loader.get_spacing(load->file);
+
+        load->data = g_volume_loader.load_volume(load->file);
+        if (load->data.empty()){
+            load->error = "Could not read " + load->file;
+            return;
+        }
+        load->channel_size = g_volume_loader.get_bit_per_channel(load->file) / 8;
+        load->channel_count = g_volume_loader.get_channel_count(load->file);
+
+        // window the samples to the actual data range
+        load->data_range = g_volume_loader.get_value_range(load->data, load->channel_size);
+
+        if (load->convert_to_8bit && load->channel_size > 1) {
+            load->data = g_volume_loader.equalize_to_8bit(load->data, load->channel_size, load->data_range);
+            load->channel_size = 1;
+            load->data_range = glm::vec2(0.0f, 1.0f);
+        }
+
+        if (load->data_range.y <= load->data_range.x) {
+            load->data_range.y = load->data_range.x + 1.0f / 255.0f;
+        }
+
+        // cubic voxels at the finest spacing, unless that exceeds the resolution limit
+        if (load->resample_isotropic && glm::compMin(load->spacing) != glm::compMax(load->spacing)) {
+            glm::vec3 extent = glm::vec3(load->dimensions) * load->spacing;
+            float target = std::max(glm::compMin(load->spacing),
+                glm::compMax(extent) / float(load->resample_max_resolution));
+            glm::ivec3 dimensions;
+            load->data = g_volume_loader.resample(load->data, load->dimensions, load->channel_size,
+                load->channel_count, load->spacing, target, dimensions);
+            load->dimensions = dimensions;
+            load->spacing = glm::vec3(target);
+        }
+
+        // calculating max volume bounds of volume (0.0 .. 1.0) from the physical extent
+        glm::vec3 extent = glm::vec3(load->dimensions) * load->spacing;
+        load->bounds = extent / glm::compMax(extent);
+    }, std::vector<Thread_pool::task_handle>(), &read);
+
+    // the filtered samples replace the read ones, so everything indexes those
+    Thread_pool::task_handle filtered;
+    pool.submit([load]() {
+        if (load->error.empty() && load->channel_count == 1)
+            load->data = load->filters.apply(load->data, load->dimensions, load->channel_size, load->data_range);
+    }, std::vector<Thread_pool::task_handle>(1, read), &filtered);
+
+    submit_volume_indexing(load, filtered);
+}
+
+// builds the indices of a volume once ready has finished
+void submit_volume_indexing(std::shared_ptr<Volume_load> const& load, Thread_pool::task_handle const& ready)
+{
+    Thread_pool& pool = Thread_pool::instance();
+
+    std::vector<Thread_pool::task_handle> after(1, ready);
+    std::vector<Thread_pool::task_handle> indexed(4);
+
+    pool.submit([load]() {
+        if (load->error.empty())
+            load->brick_grid.build(load->data, load->dimensions, load->channel_size, load->data_range);
+    }, after, &indexed[0]);
+    pool.submit([load]() {
+        if (load->error.empty())
+            load->iso_extractor.set_volume(load->data, load->dimensions, load->channel_size, load->data_range, load->bounds);
+    }, after, &indexed[1]);
+    pool.submit([load]() {
+        if (load->error.empty())
+            load->illumination.set_volume(load->data, load->dimensions, load->channel_size, load->data_range, load->bounds);
+    }, after, &indexed[2]);
+    pool.submit([load]() {
+        if (load->error.empty())
+            load->occlusion.set_volume(load->data, load->dimensions, load->channel_size, load->data_range, load->bounds);
+    }, after, &indexed[3]);
+
+    g_volume_load_job = pool.submit([load]() { return load; }, indexed);
+    g_volume_load_pending = false;
+}
+
+// voxels covered by the region of interest
+void get_roi_voxels(glm::ivec3& begin, glm::ivec3& end)
+{
+    glm::vec3 dims = glm::vec3(g_vol_dimensions);
+    begin = glm::clamp(glm::ivec3(glm::floor(glm::min(g_roi_min, g_roi_max) * dims)), glm::ivec3(0), g_vol_dimensions - 1);
+    end = glm::clamp(glm::ivec3(glm::ceil(glm::max(g_roi_min, g_roi_max) * dims)), begin + 1, g_vol_dimensions);
+}
+
+// the cropped voxels become the volume, read and filtered samples are kept as they are
+void request_volume_crop()
+{
+    if (g_volume_load_job.valid())
+        return;
+
+    std::shared_ptr<Volume_load> load = std::make_shared<Volume_load>();
+    load->file = g_file_string;
+    load->cropped = true;
+    load->spacing = g_voxel_spacing;
+    load->channel_size = g_channel_size;
+    load->channel_count = g_channel_count;
+    load->data_range = g_data_range;
+
+    glm::ivec3 begin, end;
+    get_roi_voxels(begin, end);
+    load->dimensions = end - begin;
+
+    // no load is running, so the current volume stays until this one is done
+    Thread_pool::task_handle cropped;
+    Thread_pool::instance().submit([load, begin, end]() {
+        load->data = g_volume_loader.extract(g_volume_data, g_vol_dimensions, load->channel_size,
+            load->channel_count, begin, end);
+
+        glm::vec3 extent = glm::vec3(load->dimensions) * load->spacing;
+        load->bounds = extent / glm::compMax(extent);
+    }, std::vector<Thread_pool::task_handle>(), &cropped);
+
+    submit_volume_indexing(load, cropped);
+}
+
+// writes the region of interest next to the executable, named so the loader can read it back
+void export_volume_roi()
+{
+    glm::ivec3 begin, end;
+    get_roi_voxels(begin, end);
+    glm::ivec3 size = end - begin;
+
+    volume_data_type data = g_volume_loader.extract(g_volume_data, g_vol_dimensions, g_channel_size,
+        g_channel_count, begin, end);
+
+    std::string name = g_file_string.substr(g_file_string.find_last_of("/\\") + 1);
+    name = name.substr(0, name.find("_w"));
+
+    std::stringstream ss;
+    ss << name << "_roi_w" << size.x << "_h" << size.y << "_d" << size.z
+       << "_c" << g_channel_count << "_b" << g_channel_size * 8 << ".raw";
+    std::string file = ss.str();
+    glm::vec3 spacing = g_voxel_spacing;
+
+    Thread_pool::instance().submit([data, file, spacing]() {
+        if (!g_volume_loader.save_volume(file, data)){
+            std::cerr << "Could not write " << file << std::endl;
+            return;
+        }
+        if (spacing != glm::vec3(1.0f)){
+            std::ofstream spacing_file((file + ".spacing").c_str());
+            spacing_file << spacing.x << " " << spacing.y << " " << spacing.z << std::endl;
+        }
+    });
+}
+
+// rays are bounded by the region of interest box, CPU side geometry follows it
+void update_roi()
+{
+    if (g_roi_min == g_roi_applied_min && g_roi_max == g_roi_applied_max)
+        return;
+
+    g_roi_applied_min = g_roi_min;
+    g_roi_applied_max = g_roi_max;
+
+    g_cube.freeVAO();
+    g_cube = Cube(glm::min(g_roi_min, g_roi_max) * g_max_volume_bounds, glm::max(g_roi_min, g_roi_max) * g_max_volume_bounds);
+
+    g_hit_cache_valid = false;
+    g_iso_mesh_requested = -1.0f;
+    request_brick_proxy(g_transfer_fun.get_RGBA_transfer_function_buffer());
+}
+
+// unit normal of the oblique slice
+glm::vec3 get_mpr_oblique_normal()
+{
+    return glm::vec3(std::cos(g_mpr.pitch) * std::sin(g_mpr.yaw), std::sin(g_mpr.pitch),
+        std::cos(g_mpr.pitch) * std::cos(g_mpr.yaw));
+}
+
+// slice axis of a view, volume axes for axial (z), coronal (y) and sagittal (x)
+int get_mpr_axis(int slice)
+{
+    return 2 - slice;
+}
+
+glm::vec3 get_slab_normal()
+{
+    if (g_slab_orientation == 3)
+        return get_mpr_oblique_normal();
+
+    glm::vec3 n(0.0f);
+    n[get_mpr_axis(g_slab_orientation)] = 1.0f;
+    return n;
+}
+
+// active planes in object space as (normal, distance from the origin)
+std::vector<glm::vec4> get_clip_planes()
+{
+    std::vector<glm::vec4> planes;
+    glm::vec3 center = g_max_volume_bounds * 0.5f;
+
+    for (int i = 0; i != std::min(g_clip_plane_count, g_max_clip_planes); ++i){
+        Clip_plane const& plane = g_clip_planes[i];
+        if (!plane.enabled || glm::length(plane.normal) == 0.0f)
+            continue;
+
+        glm::vec3 n = glm::normalize(plane.normal);
+        planes.push_back(glm::vec4(n, glm::dot(n, center) + plane.offset * glm::length(center)));
+    }
+
+    // the slab keeps dot(n, p) within half its thickness of the slice center
+    if (g_slab_toggle){
+        glm::vec3 n = get_slab_normal();
+        float distance = glm::dot(n, g_mpr.center * g_max_volume_bounds);
+        float half_thickness = 0.5f * g_mpr.slab_thickness;
+        planes.push_back(glm::vec4(n, distance + half_thickness));
+        planes.push_back(glm::vec4(-n, half_thickness - distance));
+    }
+
+    return planes;
+}
+
+void set_clip_plane_uniforms(GLuint program)
+{
+    std::vector<glm::vec4> planes = get_clip_planes();
+    glUniform1i(glGetUniformLocation(program, "clip_plane_count"), (GLint)planes.size());
+    if (!planes.empty())
+        glUniform4fv(glGetUniformLocation(program, "clip_planes"), (GLsizei)planes.size(), glm::value_ptr(planes[0]));
+}
+
+// cached hits may lie in a region that is clipped now
+void update_clip_planes()
+{
+    std::vector<glm::vec4> planes = get_clip_planes();
+    if (planes == g_clip_planes_applied)
+        return;
+
+    g_clip_planes_applied.swap(planes);
+    g_hit_cache_valid = false;
+}
+
+Slice_plane get_mpr_plane(int slice, int resolution)
+{
+    glm::vec3 axis_u(1.0f, 0.0f, 0.0f);
+    glm::vec3 axis_v(0.0f, 1.0f, 0.0f);
+    glm::vec3 center = g_mpr.center * g_max_volume_bounds;
+    float extent = glm::compMax(g_max_volume_bounds);
+
+    if (slice == 1)
+        axis_v = glm::vec3(0.0f, 0.0f, 1.0f);
+    else if (slice == 2){
+        axis_u = glm::vec3(0.0f, 1.0f, 0.0f);
+        axis_v = glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+    else if (slice == 3){
+        glm::vec3 n = get_mpr_oblique_normal();
+        axis_u = std::abs(n.y) < 0.999f ? glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), n))
+                                        : glm::vec3(1.0f, 0.0f, 0.0f);
+        axis_v = glm::cross(n, axis_u);
+        extent = glm::length(g_max_volume_bounds);
+    }
+
+    // axis slices stay centered on the volume, only their depth follows the center
+    if (slice < 3){
+        int axis = get_mpr_axis(slice);
+        center = g_max_volume_bounds * 0.5f;
+        center[axis] = g_mpr.center[axis] * g_max_volume_bounds[axis];
+    }
+
+    return Slice_plane::make(center, axis_u, axis_v, extent, resolution,
+        g_vol_dimensions, g_max_volume_bounds);
+}
+
+// reformats one view into g_mpr_image, returns the image size; axis slabs are
+// reduced voxel by voxel and cover only the volume, not the whole view
+glm::ivec2 extract_mpr_view(int slice, int side, Mpr_settings const& settings)
+{
+    Slab_projector::Mode mode = Slab_projector::Mode(settings.slab_mode);
+
+    if (settings.slab_thickness <= 0.0f){
+        Slice_extractor::extract(g_volume_data, g_vol_dimensions, g_channel_size, g_data_range,
+            get_mpr_plane(slice, side), glm::ivec2(side), g_mpr_image);
+        return glm::ivec2(side);
+    }
+
+    if (slice < 3){
+        int axis = get_mpr_axis(slice);
+        int voxels = g_vol_dimensions[axis];
+        float to_voxel = voxels / g_max_volume_bounds[axis];
+        int center = glm::clamp(int(settings.center[axis] * voxels), 0, voxels - 1);
+        int half = int(0.5f * settings.slab_thickness * to_voxel);
+
+        glm::ivec2 image_size;
+        Slab_projector::project_axis(g_volume_data, g_vol_dimensions, g_channel_size, g_data_range,
+            axis, center - half, center + half + 1, mode, g_mpr_image, image_size);
+        return image_size;
+    }
+
+    // oblique slabs are stacked trilinear slices one voxel apart
+    glm::vec3 to_voxel = glm::vec3(g_vol_dimensions) / g_max_volume_bounds;
+    float voxel = 1.0f / glm::compMax(to_voxel);
+    int count = std::max(1, int(settings.slab_thickness / voxel + 0.5f));
+
+    glm::vec3 step = get_mpr_oblique_normal() * voxel * to_voxel;
+    Slice_plane plane = get_mpr_plane(slice, side);
+    plane.origin -= 0.5f * float(count - 1) * step;
+
+    Slab_projector::project_plane(g_volume_data, g_vol_dimensions, g_channel_size, g_data_range,
+        plane, step, count, glm::ivec2(side), mode, g_mpr_image);
+    return glm::ivec2(side);
+}
+
+// slices are only reformatted when the volume or the settings changed
+void render_mpr_views(glm::ivec2 const& size)
+{
+    int side = size.y / g_mpr_slice_count;
+    if (side < 1 || g_volume_data.empty())
+        return;
+
+    g_mpr.resolution = side;
+    Mpr_settings settings = g_mpr;
+    if (!g_slab_toggle)
+        settings.slab_thickness = 0.0f;
+
+    if (g_mpr_dirty || !(settings == g_mpr_applied)){
+        glActiveTexture(GL_TEXTURE9);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (int i = 0; i != g_mpr_slice_count; ++i){
+            glm::ivec2 image_size = extract_mpr_view(i, side, settings);
+
+            if (!g_mpr_textures[i]){
+                glGenTextures(1, &g_mpr_textures[i]);
+                glBindTexture(GL_TEXTURE_2D, g_mpr_textures[i]);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            }
+            glBindTexture(GL_TEXTURE_2D, g_mpr_textures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, image_size.x, image_size.y, 0, GL_RED, GL_UNSIGNED_BYTE,
+                g_mpr_image.empty() ? 0 : &g_mpr_image[0]);
+        }
+
+        glActiveTexture(GL_TEXTURE0);
+        g_mpr_applied = settings;
+        g_mpr_dirty = false;
+    }
+
+    static const glm::vec3 colors[g_mpr_slice_count] = {
+        glm::vec3(0.2f, 0.4f, 1.0f), glm::vec3(0.2f, 1.0f, 0.3f),
+        glm::vec3(1.0f, 0.3f, 0.2f), glm::vec3(1.0f, 0.9f, 0.2f)
+    };
+
+    glDisable(GL_BLEND);
+    glUseProgram(g_slice_program);
+    glUniform1i(glGetUniformLocation(g_slice_program, "slice_texture"), 9);
+
+    for (int i = 0; i != g_mpr_slice_count; ++i){
+        // axis slab images span the volume, which sits centered in the view
+        glm::ivec2 extent(side);
+        if (g_mpr_applied.slab_thickness > 0.0f && i < 3){
+            glm::vec3 fraction = g_max_volume_bounds / glm::compMax(g_max_volume_bounds);
+            int axis_u = i == 2 ? 1 : 0;
+            int axis_v = i == 0 ? 1 : 2;
+            extent = glm::max(glm::ivec2(glm::vec2(fraction[axis_u], fraction[axis_v]) * float(side) + 0.5f), glm::ivec2(1));
+        }
+
+        glViewport(size.x - side + (side - extent.x) / 2, size.y - (i + 1) * side + (side - extent.y) / 2,
+            extent.x, extent.y);
+        glActiveTexture(GL_TEXTURE9);
+        glBindTexture(GL_TEXTURE_2D, g_mpr_textures[i]);
+        glUniform3fv(glGetUniformLocation(g_slice_program, "slice_color"), 1, glm::value_ptr(colors[i]));
+        g_screen_quad.draw();
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glUseProgram(0);
+    glEnable(GL_BLEND);
+    glViewport(0, 0, size.x, size.y);
+}
+
+// swaps a loaded volume in and uploads it, must run on the GL thread
+void finish_volume_load(std::shared_ptr<Volume_load> const& load)
+{
+    // a failed read keeps the current volume
+    if (!load->error.empty()){
+        std::cerr << load->error << std::endl;
+        g_volume_load_status = load->error;
+        if (!g_volume_file.empty())
+            g_file_string = g_volume_file;
+        return;
+    }
+    g_volume_load_status.clear();
+    g_volume_file = load->file;
+    g_volume_cropped = load->cropped;
+
+    // the brick grid and iso index are replaced below, wait for running jobs
+    if (g_brick_proxy_job.valid())
+        g_brick_proxy_job.wait();
+    if (g_iso_mesh_job.valid())
+        g_iso_mesh_job.wait();
+    if (g_occlusion_job.valid())
+        g_occlusion_job.wait();
+    g_brick_proxy_job = std::future<Brick_proxy_result>();
+    g_occlusion_job = std::future<volume_data_type>();
+    g_iso_mesh_job = std::future<Iso_mesh>();
+    clear_labels();
+
+    g_vol_dimensions = load->dimensions;
+    g_voxel_spacing = load->spacing;
+    g_max_volume_bounds = load->bounds;
+    g_channel_size = load->channel_size;
+    g_channel_count = load->channel_count;
+    g_data_range = load->data_range;
+    g_volume_data.swap(load->data);
+
+    // setting up proxy geometry, a new volume starts without a region of interest
+    g_roi_min = glm::vec3(0.0f);
+    g_roi_max = glm::vec3(1.0f);
+    g_roi_applied_min = g_roi_min;
+    g_roi_applied_max = g_roi_max;
+    g_cube.freeVAO();
+    g_cube = Cube(glm::vec3(0.0, 0.0, 0.0), g_max_volume_bounds);
+
+    std::swap(g_brick_grid, load->brick_grid);
+    std::swap(g_iso_extractor, load->iso_extractor);
+    g_iso_extractor.rebind(g_volume_data);
+    g_iso_mesh = Iso_mesh();
+    g_iso_mesh_requested = -1.0f;
+    g_hit_cache_valid = false;
+    g_brick_occupancy.clear();
+    g_brick_proxy.freeVAO();
+    request_brick_proxy(g_transfer_fun.get_RGBA_transfer_function_buffer());
+
+    std::swap(g_illumination_volume, load->illumination);
+    g_illumination_volume.set_transfer_function(g_transfer_fun.get_RGBA_transfer_function_buffer(), g_sampling_distance_ref);
+    g_illumination_reference_step = g_sampling_distance_ref;
+    upload_illumination_volume(true);
+
+    // unoccluded until the first bake arrives
+    std::swap(g_occlusion_volume, load->occlusion);
+    glm::ivec3 occlusion_dims = g_occlusion_volume.get_dimensions();
+    upload_occlusion_volume(volume_data_type(occlusion_dims.x * occlusion_dims.y * occlusion_dims.z, 255));
+    g_occlusion_dirty = true;
+
+    g_mpr_dirty = true;
+
+    glActiveTexture(GL_TEXTURE0);
+    glDeleteTextures(1, &g_volume_texture);
+    g_volume_texture = createTexture3D(g_vol_dimensions.x, g_vol_dimensions.y, g_vol_dimensions.z, g_channel_size, g_channel_count, (char*)&g_volume_data[0], g_half_float_texture);
+}
+
+void update_volume_load()
+{
+    if (!g_volume_load_job.valid()
+        || g_volume_load_job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    finish_volume_load(g_volume_load_job.get());
+
+    if (g_volume_load_pending)
+        request_volume(g_volume_load_pending_file);
+}
+
+// one transfer function row per scene volume
+void upload_scene_transfer_rows()
+{
+    size_t row_size = g_transfer_shown.size();
+    if (g_scene.empty() || row_size == 0)
+        return;
+
+    image_data_type rows;
+    for (unsigned i = 0; i != g_scene.size(); ++i){
+        image_data_type const& lut = g_scene[i].transfer_function.size() == row_size
+                                   ? g_scene[i].transfer_function : g_transfer_shown;
+        rows.insert(rows.end(), lut.begin(), lut.end());
+    }
+
+    glActiveTexture(GL_TEXTURE11);
+    if (!g_scene_transfer_texture){
+        glGenTextures(1, &g_scene_transfer_texture);
+        glBindTexture(GL_TEXTURE_2D, g_scene_transfer_texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    glBindTexture(GL_TEXTURE_2D, g_scene_transfer_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, GLsizei(row_size / 4), GLsizei(g_scene.size()), 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, &rows[0]);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// texture of a scene volume at the level the budget allows
+void upload_scene_volume(unsigned index)
+{
+    Scene_volume const& volume = g_scene[index];
+    glm::ivec3 dims = volume.get_resident_dimensions();
+    volume_data_type data = g_scene.get_resident_data(index);
+
+    glActiveTexture(GL_TEXTURE12 + index);
+    glDeleteTextures(1, &g_scene_textures[index]);
+    g_scene_textures[index] = createTexture3D(dims.x, dims.y, dims.z, volume.byte_per_channel, 1,
+        (char*)&data[0], g_half_float_texture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// levels of all volumes are fitted again, only volumes that changed are uploaded
+void update_scene_budget()
+{
+    g_scene.set_budget(size_t(g_scene_budget_mb) << 20);
+    std::vector<unsigned> changed = g_scene.fit_budget();
+    for (unsigned i = 0; i != changed.size(); ++i)
+        upload_scene_volume(changed[i]);
+}
+
+void add_scene_volume(Scene_volume const& volume)
+{
+    if (g_scene.size() >= g_max_scene_volumes || volume.data.empty())
+        return;
+
+    unsigned index = g_scene.add(volume);
+    g_scene_textures.push_back(0);
+
+    // fitted first, so the new volume is uploaded once at its final level
+    std::vector<unsigned> changed = g_scene.fit_budget();
+    upload_scene_volume(index);
+    for (unsigned i = 0; i != changed.size(); ++i)
+        if (changed[i] != index)
+            upload_scene_volume(changed[i]);
+
+    upload_scene_transfer_rows();
+    g_scene_selected = int(index);
+}
+
+void remove_scene_volume(unsigned index)
+{
+    if (index >= g_scene.size())
+        return;
+
+    glDeleteTextures(1, &g_scene_textures[index]);
+    g_scene_textures.erase(g_scene_textures.begin() + index);
+    g_scene.remove(index);
+
+    // the freed memory may bring the others back to a finer level
+    update_scene_budget();
+    upload_scene_transfer_rows();
+    g_scene_selected = std::max(0, std::min(g_scene_selected, int(g_scene.size()) - 1));
+}
+
+// placed next to the volumes already in the scene, along x
+Scene_volume get_scene_volume_defaults(std::string const& name)
+{
+    Scene_volume volume;
+    volume.name = name;
+    volume.position = g_max_volume_bounds * 0.5f + glm::vec3(1.1f * float(g_scene.size()), 0.0f, 0.0f);
+    volume.yaw = 0.0f;
+    volume.scale = 1.0f;
+    volume.transfer_function = g_transfer_shown;
+    volume.level = 0;
+    return volume;
+}
+
+// a copy of the volume shown now, only single channel volumes
+void add_current_volume_to_scene()
+{
+    if (g_channel_count != 1 || g_volume_data.empty())
+        return;
+
+    Scene_volume volume = get_scene_volume_defaults(g_file_string);
+    volume.data = g_volume_data;
+    volume.dimensions = g_vol_dimensions;
+    volume.byte_per_channel = g_channel_size;
+    volume.data_range = g_data_range;
+    volume.bounds = g_max_volume_bounds;
+    add_scene_volume(volume);
+}
+
+void request_scene_volume(std::string const& file)
+{
+    if (g_scene_load_job.valid() || g_scene.size() >= g_max_scene_volumes)
+        return;
+
+    Scene_volume defaults = get_scene_volume_defaults(file);
+    g_scene_load_job = Thread_pool::instance().submit([file, defaults]() {
+        std::shared_ptr<Scene_volume> volume(new Scene_volume(defaults));
+        if (g_volume_loader.get_channel_count(file) != 1)
+            return volume;
+
+        volume->dimensions = g_volume_loader.get_dimensions(file);
+        volume->data = g_volume_loader.load_volume(file);
+        if (volume->data.empty())
+            return volume;
+        volume->byte_per_channel = g_volume_loader.get_bit_per_channel(file) / 8;
+        volume->data_range = g_volume_loader.get_value_range(volume->data, volume->byte_per_channel);
+
+        glm::vec3 extent = glm::vec3(volume->dimensions) * g_volume_loader.get_spacing(file);
+        volume->bounds = extent / glm::compMax(extent);
+        return volume;
+    });
+}
+
+void update_scene_load()
+{
+    if (!g_scene_load_job.valid()
+        || g_scene_load_job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    add_scene_volume(*g_scene_load_job.get());
+}
+
+void render_scene(glm::mat4 const& projection, glm::mat4 const& model_view)
+{
+    std::vector<glm::mat4> inverse;
+    std::vector<glm::vec3> bounds;
+    std::vector<glm::vec2> ranges;
+    for (unsigned i = 0; i != g_scene.size(); ++i){
+        inverse.push_back(glm::inverse(g_scene[i].get_model()));
+        bounds.push_back(g_scene[i].bounds);
+        ranges.push_back(g_scene[i].data_range);
+
+        glActiveTexture(GL_TEXTURE12 + i);
+        glBindTexture(GL_TEXTURE_3D, g_scene_textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE11);
+    glBindTexture(GL_TEXTURE_2D, g_scene_transfer_texture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glUseProgram(g_scene_program);
+    for (unsigned i = 0; i != g_max_scene_volumes; ++i){
+        std::stringstream name;
+        name << "scene_volume_" << i;
+        glUniform1i(glGetUniformLocation(g_scene_program, name.str().c_str()), 12 + i);
+    }
+    glUniform1i(glGetUniformLocation(g_scene_program, "scene_transfer_texture"), 11);
+    glUniformMatrix4fv(glGetUniformLocation(g_scene_program, "ModelviewProjectionInverse"), 1, GL_FALSE,
+        glm::value_ptr(glm::inverse(projection * model_view)));
+    glUniform1f(glGetUniformLocation(g_scene_program, "sampling_distance"), g_sampling_distance);
+    glUniform1f(glGetUniformLocation(g_scene_program, "termination_alpha"),
+        g_early_termination ? g_termination_alpha : 2.0f);
+    glUniform1i(glGetUniformLocation(g_scene_program, "volume_count"), (GLint)g_scene.size());
+    glUniformMatrix4fv(glGetUniformLocation(g_scene_program, "volume_inverse"), (GLsizei)inverse.size(), GL_FALSE,
+        glm::value_ptr(inverse[0]));
+    glUniform3fv(glGetUniformLocation(g_scene_program, "volume_bounds"), (GLsizei)bounds.size(),
+        glm::value_ptr(bounds[0]));
+    glUniform2fv(glGetUniformLocation(g_scene_program, "volume_range"), (GLsizei)ranges.size(),
+        glm::value_ptr(ranges[0]));
+
+    g_screen_quad.draw();
+    glUseProgram(0);
+}
+
+glm::ivec2 get_poster_tiles()
+{
+    return (g_poster_size + g_poster_tile_size - glm::ivec2(1)) / g_poster_tile_size;
+}
+
+// tiles are still to be rendered, the last ones may be in flight
+bool poster_rendering()
+{
+    return g_poster_active && g_poster_tile < get_poster_tiles().x * get_poster_tiles().y;
+}
+
+// maps the part of the poster covered by the tile to the whole viewport,
+// applied after the projection of the full poster
+glm::mat4 get_poster_tile_projection(int tile)
+{
+    glm::ivec2 tiles = get_poster_tiles();
+    glm::vec2 poster = glm::vec2(g_poster_size);
+    glm::vec2 tile_size = glm::vec2(g_poster_tile_size);
+
+    // lower left tile corner in poster pixels, the first band is at the top
+    glm::vec2 low = glm::vec2(float(tile % tiles.x) * tile_size.x, poster.y - float(tile / tiles.x + 1) * tile_size.y);
+    glm::vec2 ndc_low = low / poster * 2.0f - 1.0f;
+    glm::vec2 ndc_high = (low + tile_size) / poster * 2.0f - 1.0f;
+
+    return glm::scale(glm::vec3(2.0f / (ndc_high - ndc_low), 1.0f))
+        * glm::translate(glm::vec3(-0.5f * (ndc_low + ndc_high), 0.0f));
+}
+
+void start_poster(glm::ivec2 const& window_size)
+{
+    if (g_poster_active || g_poster_job.valid() || g_export_active || window_size.x < 1 || window_size.y < 1)
+        return;
+
+    std::stringstream file;
+    file << "poster_" << g_poster_request.x << "x" << g_poster_request.y << ".ppm";
+
+    std::shared_ptr<Ppm_writer> writer(new Ppm_writer);
+    if (!writer->open(file.str(), g_poster_request)){
+        g_image_status = "Could not open " + file.str();
+        return;
+    }
+
+    g_poster_file = file.str();
+    g_poster_writer = writer;
+    g_poster_band.reset();
+    g_poster_size = g_poster_request;
+    g_poster_tile_size = window_size;
+    g_poster_tile = 0;
+    g_poster_pose = g_camera_pose;
+    g_poster_active = true;
+    g_image_status.clear();
+}
+
+// closes the file once all bands are written, incomplete posters report failure
+void finish_poster()
+{
+    std::shared_ptr<Ppm_writer> writer = g_poster_writer;
+    g_poster_job = Thread_pool::instance().submit([writer]() { return writer->close(); },
+        std::vector<Thread_pool::task_handle>(1, g_poster_write_task), &g_poster_write_task);
+
+    g_poster_writer.reset();
+    g_poster_band.reset();
+    g_poster_active = false;
+}
+
+void store_poster_tile(image_data_type const& pixels, glm::ivec2 const& size, int tile)
+{
+    glm::ivec2 tiles = get_poster_tiles();
+    int column = tile % tiles.x;
+    int band = tile / tiles.x;
+
+    // tiles at the right and bottom border are cropped to the poster
+    int x = column * g_poster_tile_size.x;
+    int width = std::min(size.x, g_poster_size.x - x);
+    int rows = std::min(size.y, g_poster_size.y - band * g_poster_tile_size.y);
+
+    if (!g_poster_band)
+        g_poster_band.reset(new std::vector<unsigned char>(size_t(g_poster_size.x) * rows * 3));
+    Ppm_writer::rgba_to_rgb(pixels, size, 0, width, 0, rows,
+        &(*g_poster_band)[size_t(x) * 3], size_t(g_poster_size.x) * 3);
+
+    if (column != tiles.x - 1)
+        return;
+
+    // a complete band is appended after the previous one
+    std::shared_ptr<Ppm_writer> writer = g_poster_writer;
+    std::shared_ptr<std::vector<unsigned char>> rgb = g_poster_band;
+    Thread_pool::instance().submit([writer, rgb, rows]() { return writer->write_rows(&(*rgb)[0], rows); },
+        std::vector<Thread_pool::task_handle>(1, g_poster_write_task), &g_poster_write_task);
+    g_poster_band.reset();
+
+    if (band == tiles.y - 1)
+        finish_poster();
+}
+
+void save_screenshot(image_data_type const& pixels, glm::ivec2 const& size)
+{
+    if (g_screenshot_job.valid())
+        return;
+
+    std::stringstream file;
+    file << "screenshot_" << g_screenshot_count++ << ".ppm";
+    g_image_status = file.str();
+
+    std::shared_ptr<image_data_type> rgba(new image_data_type(pixels));
+    std::string path = file.str();
+    g_screenshot_job = Thread_pool::instance().submit([rgba, size, path]() {
+        Ppm_writer writer;
+        if (!writer.open(path, size))
+            return false;
+
+        const int rows_per_write = 64;
+        std::vector<unsigned char> rgb(size_t(size.x) * rows_per_write * 3);
+        for (int row = 0; row < size.y; row += rows_per_write){
+            int rows = std::min(rows_per_write, size.y - row);
+            Ppm_writer::rgba_to_rgb(*rgba, size, 0, size.x, row, rows, &rgb[0], size_t(size.x) * 3);
+            writer.write_rows(&rgb[0], rows);
+        }
+        return writer.close();
+    });
+}
+
+// collects finished readbacks; a resized window invalidates the tiles of a poster
+void update_image_export(glm::ivec2 const& window_size)
+{
+    if (g_poster_active && window_size != g_poster_tile_size){
+        glm::ivec2 size;
+        int tag = 0;
+        while (g_readback.poll(g_readback_pixels, size, tag, true))
+            if (tag < 0)
+                save_screenshot(g_readback_pixels, size);
+        finish_poster();
+        g_image_status = "Poster aborted, the window was resized";
+    }
+
+    glm::ivec2 size;
+    int tag = 0;
+    while (g_readback.poll(g_readback_pixels, size, tag)){
+        if (tag < 0)
+            save_screenshot(g_readback_pixels, size);
+        else if (g_poster_active)
+            store_poster_tile(g_readback_pixels, size, tag);
+    }
+
+    if (g_screenshot_job.valid()
+        && g_screenshot_job.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+        if (!g_screenshot_job.get())
+            g_image_status = "Could not write " + g_image_status;
+        else
+            g_image_status = "Saved " + g_image_status;
+    }
+
+    if (g_poster_job.valid()
+        && g_poster_job.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+        if (g_poster_job.get())
+            g_image_status = "Saved " + g_poster_file;
+        else if (g_image_status.empty())
+            g_image_status = "Could not write " + g_poster_file;
+    }
+}
+
+// keys the interactive pose while recording, the path then replays the mouse motion
+void update_camera_path(Turntable const& pose)
+{
+    g_camera_pose = pose;
+
+    if (!g_camera_recording)
+        return;
+
+    double now = glfwGetTime();
+    if (g_camera_path.empty() || now - g_camera_record_last >= g_camera_record_interval){
+        g_camera_path.add_key(now - g_camera_record_start, pose);
+        g_camera_record_last = now;
+    }
+}
+
+void start_camera_recording()
+{
+    g_camera_path.clear();
+    g_camera_playing = false;
+    g_camera_recording = true;
+    g_camera_record_start = glfwGetTime();
+    g_camera_record_last = g_camera_record_start;
+}
+
+bool exporting_frames()
+{
+    return g_export_active && g_export_frame < g_export_frame_count;
+}
+
+// the pose of the frame being exported, or of the playback time; false while the
+// mouse controls the camera
+bool get_camera_path_pose(Turntable& pose)
+{
+    if (g_camera_path.empty())
+        return false;
+
+    if (exporting_frames()){
+        pose = g_camera_path.evaluate(double(g_export_frame) / g_export_fps);
+        return true;
+    }
+
+    if (g_camera_playing){
+        double duration = g_camera_path.get_duration();
+        double time = glfwGetTime() - g_camera_play_start;
+        pose = g_camera_path.evaluate(duration > 0.0 ? std::fmod(time, duration) : 0.0);
+        return true;
+    }
+
+    return false;
+}
+
+std::string get_export_frame_file(int frame)
+{
+    std::stringstream file;
+    file << "animation_" << std::setw(5) << std::setfill('0') << frame << ".ppm";
+    return file.str();
+}
+
+void start_animation_export(glm::ivec2 const& window_size)
+{
+    if (g_export_active || g_poster_active || !g_export_writes.empty() || g_camera_path.empty()
+        || window_size.x < 1 || window_size.y < 1)
+        return;
+
+    g_export_file = g_export_format == export_y4m ? "animation.y4m" : get_export_frame_file(0);
+    if (g_export_format == export_y4m){
+        g_export_video.reset(new Y4m_writer);
+        if (!g_export_video->open(g_export_file, window_size, g_export_fps)){
+            g_image_status = "Could not open " + g_export_file;
+            g_export_video.reset();
+            return;
+        }
+    }
+
+    g_export_active = true;
+    g_export_failed = false;
+    g_export_frame = 0;
+    g_export_frame_count = int(g_camera_path.get_duration() * g_export_fps) + 1;
+    g_export_size = window_size;
+    g_export_write_task.reset();
+    g_camera_playing = false;
+    g_camera_recording = false;
+    g_image_status.clear();
+
+    // fixed quality for every frame
+    g_export_previous_sampling_distance = g_sampling_distance;
+    g_sampling_distance = g_export_sampling_distance;
+}
+
+void finish_animation_export(std::string const& status)
+{
+    if (g_export_video){
+        std::shared_ptr<Y4m_writer> video = g_export_video;
+        g_export_writes.push_back(Thread_pool::instance().submit([video]() { return video->close(); },
+            std::vector<Thread_pool::task_handle>(1, g_export_write_task), &g_export_write_task));
+        g_export_video.reset();
+    }
+
+    g_sampling_distance = g_export_previous_sampling_distance;
+    g_export_active = false;
+    g_image_status = status;
+}
+
+// hands a read back frame to the pool: the conversion runs as soon as a worker
+// is free, writing waits for it and for the frame before
+void encode_export_frame(image_data_type const& pixels, glm::ivec2 const& size, int frame)
+{
+    std::shared_ptr<image_data_type> rgba(new image_data_type(pixels));
+
+    if (g_export_format == export_ppm_sequence){
+        std::string path = get_export_frame_file(frame);
+        g_export_writes.push_back(Thread_pool::instance().submit([rgba, size, path]() {
+            Ppm_writer writer;
+            if (!writer.open(path, size))
+                return false;
+            std::vector<unsigned char> rgb(size_t(size.x) * size.y * 3);
+            Ppm_writer::rgba_to_rgb(*rgba, size, 0, size.x, 0, size.y, &rgb[0], size_t(size.x) * 3);
+            writer.write_rows(&rgb[0], size.y);
+            return writer.close();
+        }));
+        return;
+    }
+
+    std::shared_ptr<std::vector<unsigned char>> yuv(new std::vector<unsigned char>);
+    Thread_pool::task_handle convert_task;
+    Thread_pool::instance().submit([rgba, size, yuv]() { Y4m_writer::convert(*rgba, size, *yuv); },
+        std::vector<Thread_pool::task_handle>(), &convert_task);
+
+    std::vector<Thread_pool::task_handle> after;
+    after.push_back(convert_task);
+    after.push_back(g_export_write_task);
+
+    std::shared_ptr<Y4m_writer> video = g_export_video;
+    g_export_writes.push_back(Thread_pool::instance().submit([video, yuv]() { return video->write_frame(*yuv); },
+        after, &g_export_write_task));
+}
+
+// collects read back frames and finished writes, ends the export after the last frame
+void update_animation_export(glm::ivec2 const& window_size)
+{
+    if (g_export_active && window_size != g_export_size){
+        glm::ivec2 size;
+        int frame = 0;
+        while (g_export_readback.poll(g_readback_pixels, size, frame, true)) {}
+        finish_animation_export("Export aborted, the window was resized");
+    }
+
+    glm::ivec2 size;
+    int frame = 0;
+    while (g_export_readback.poll(g_readback_pixels, size, frame))
+        if (g_export_active)
+            encode_export_frame(g_readback_pixels, size, frame);
+
+    while (!g_export_writes.empty()
+        && g_export_writes.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+        if (!g_export_writes.front().get())
+            g_export_failed = true;
+        g_export_writes.pop_front();
+    }
+
+    if (g_export_active && g_export_frame == g_export_frame_count && g_export_readback.get_pending_count() == 0){
+        std::stringstream status;
+        status << "Exported " << g_export_frame_count << " frames";
+        finish_animation_export(status.str());
+    }
+
+    if (!g_export_active && g_export_writes.empty() && g_export_failed){
+        g_export_failed = false;
+        g_image_status = "Could not write " + g_export_file;
+    }
+}
+
+// settings scripts can set and get, as float components within the limits
+// of the matching gui controls
+struct Control_parameter
+{
+    float* values;
+    int    count;
+    float  min;
+    float  max;
+};
+
+std::map<std::string, Control_parameter> get_control_parameters()
+{
+    std::map<std::string, Control_parameter> parameters;
+    Control_parameter iso_value = { &g_iso_value, 1, 0.0f, 1.0f };
+    Control_parameter sampling_distance = { &g_sampling_distance, 1, 0.0001f, 0.2f };
+    Control_parameter termination_alpha = { &g_termination_alpha, 1, 0.5f, 1.0f };
+    Control_parameter light_position = { &g_light_pos[0], 3, -10.0f, 10.0f };
+    Control_parameter light_ambient = { &g_ambient_light_color[0], 3, 0.0f, 1.0f };
+    Control_parameter light_diffuse = { &g_diffuse_light_color[0], 3, 0.0f, 1.0f };
+    Control_parameter light_specular = { &g_specula_light_color[0], 3, 0.0f, 1.0f };
+    Control_parameter light_ref_coef = { &g_ref_coef, 1, 0.0f, 20.0f };
+    Control_parameter background = { &g_background_color[0], 3, 0.0f, 1.0f };
+    Control_parameter roi_min = { &g_roi_min[0], 3, 0.0f, 1.0f };
+    Control_parameter roi_max = { &g_roi_max[0], 3, 0.0f, 1.0f };
+    parameters["iso_value"] = iso_value;
+    parameters["sampling_distance"] = sampling_distance;
+    parameters["termination_alpha"] = termination_alpha;
+    parameters["light_position"] = light_position;
+    parameters["light_ambient"] = light_ambient;
+    parameters["light_diffuse"] = light_diffuse;
+    parameters["light_specular"] = light_specular;
+    parameters["light_ref_coef"] = light_ref_coef;
+    parameters["background"] = background;
+    parameters["roi_min"] = roi_min;
+    parameters["roi_max"] = roi_max;
+    return parameters;
+}
+
+// switches that change the shader defines
+std::map<std::string, bool*> get_control_switches()
+{
+    std::map<std::string, bool*> switches;
+    switches["lighting"] = &g_lighting_toggle;
+    switches["shadows"] = &g_shadow_toggle;
+    switches["opacity_correction"] = &g_opacity_correction_toggle;
+    switches["deferred_shading"] = &g_deferred_shading;
+    switches["ambient_occlusion"] = &g_occlusion_toggle;
+    return switches;
+}
+
+bool parse_control_floats(std::vector<std::string> const& arguments, size_t first, int count, float* values)
+{
+    if (arguments.size() != first + count)
+        return false;
+
+    for (int i = 0; i != count; ++i){
+        std::stringstream stream(arguments[first + i]);
+        if (!(stream >> values[i]))
+            return false;
+    }
+    return true;
+}
+
+// the reply line for one command
+std::string apply_control_command(Control_command const& command)
+{
+    std::vector<std::string> const& arguments = command.arguments;
+
+    if (command.name == "set" || command.name == "get"){
+        if (arguments.empty())
+            return "error missing parameter name";
+
+        bool set = command.name == "set";
+        std::map<std::string, Control_parameter> parameters = get_control_parameters();
+        std::map<std::string, bool*> switches = get_control_switches();
+        std::stringstream reply;
+        reply << "ok";
+
+        if (parameters.count(arguments[0])){
+            Control_parameter parameter = parameters[arguments[0]];
+            if (set){
+                // nothing is written unless every component is valid
+                float values[3];
+                if (!parse_control_floats(arguments, 1, parameter.count, values))
+                    return "error expected " + std::to_string(parameter.count) + " numbers";
+                for (int i = 0; i != parameter.count; ++i){
+                    if (!(values[i] >= parameter.min && values[i] <= parameter.max)){
+                        std::stringstream error;
+                        error << "error expected values between " << parameter.min << " and " << parameter.max;
+                        return error.str();
+                    }
+                }
+                std::copy(values, values + parameter.count, parameter.values);
+            }
+            for (int i = 0; i != parameter.count; ++i)
+                reply << " " << parameter.values[i];
+        }
+        else if (switches.count(arguments[0])){
+            bool& value = *switches[arguments[0]];
+            if (set){
+                if (arguments.size() != 2 || (arguments[1] != "0" && arguments[1] != "1"))
+                    return "error expected 0 or 1";
+                g_reload_shader |= value != (arguments[1] == "1");
+                value = arguments[1] == "1";
+            }
+            reply << " " << int(value);
+        }
+        else if (arguments[0] == "task"){
+            if (set){
+                float task = 0.0f;
+                if (!parse_control_floats(arguments, 1, 1, &task)
+                    || (task != 21 && task != 22 && task != 23 && task != 31 && task != 32 && task != 41))
+                    return "error expected task 21, 22, 23, 31, 32 or 41";
+                g_task_chosen = int(task);
+                g_task_chosen_old = g_task_chosen;
+                g_reload_shader = true;
+            }
+            reply << " " << g_task_chosen;
+        }
+        else
+            return "error unknown parameter " + arguments[0];
+
+        return reply.str();
+    }
+
+    if (command.name == "load_volume"){
+        if (arguments.size() != 1)
+            return "error expected a file";
+        if (!g_volume_loader.is_readable(arguments[0]))
+            return "error cannot read " + arguments[0] + ", it is missing or shorter than its name describes";
+        g_file_string = arguments[0];
+        request_volume(g_file_string);
+        return "ok loading";
+    }
+
+    if (command.name == "load_tf"){
+        int index = arguments.size() == 1 ? g_tf_library.find(arguments[0]) : -1;
+        if (index < 0)
+            return "error expected the name of a preset";
+        g_preset_current = index;
+        apply_preset(g_tf_library.get(index));
+        return "ok";
+    }
+
+    // turntable rotation, panning and zoom; "camera mouse" gives control back
+    if (command.name == "camera"){
+        if (arguments.size() == 1 && arguments[0] == "mouse"){
+            g_control_camera = false;
+            return "ok";
+        }
+        float values[5];
+        if (!parse_control_floats(arguments, 0, 5, values))
+            return "error expected rotation x y, panning x y and zoom";
+        g_control_pose.set(glm::vec2(values[0], values[1]), glm::vec2(values[2], values[3]), values[4]);
+        g_control_camera = true;
+        return "ok";
+    }
+
+    // answered once the next frame is read back
+    if (command.name == "frame"){
+        g_control_frame_clients.push_back(command.client);
+        return std::string();
+    }
+
+    return "error unknown command " + command.name;
+}
+
+// copies the frame to the shared memory of each client waiting for it
+void reply_control_frame(image_data_type const& pixels, glm::ivec2 const& size, std::vector<unsigned> const& clients)
+{
+    for (unsigned i = 0; i != clients.size(); ++i){
+        std::shared_ptr<Shared_memory>& frame = g_control_frames[clients[i]];
+        if (!frame)
+            frame.reset(new Shared_memory);
+
+        if (frame->get_size() != pixels.size()){
+            std::stringstream name;
+            name << "/scivis_frame_" << clients[i];
+            if (!frame->create(name.str(), pixels.size())){
+                g_control.reply(clients[i], "error could not create shared memory");
+                continue;
+            }
+        }
+
+        std::memcpy(frame->get_data(), &pixels[0], pixels.size());
+
+        std::stringstream reply;
+        reply << "ok " << frame->get_name() << " " << size.x << " " << size.y << " rgba8 bottom_up";
+        g_control.reply(clients[i], reply.str());
+    }
+}
+
+// applies all commands that arrived since the last frame
+void update_control_server()
+{
+    if (!g_control.is_running())
+        return;
+
+    std::vector<Control_command> commands = g_control.take_commands();
+    for (unsigned i = 0; i != commands.size(); ++i){
+        std::string reply = apply_control_command(commands[i]);
+        if (!reply.empty())
+            g_control.reply(commands[i].client, reply);
+    }
+
+    glm::ivec2 size;
+    int tag = 0;
+    while (g_control_readback.poll(g_readback_pixels, size, tag)){
+        reply_control_frame(g_readback_pixels, size, g_control_frame_reads[tag]);
+        g_control_frame_reads.erase(tag);
+    }
+
+    // frames of clients that left are not read anymore
+    std::vector<unsigned> disconnected = g_control.take_disconnected();
+    for (unsigned i = 0; i != disconnected.size(); ++i){
+        unsigned client = disconnected[i];
+        g_control_frames.erase(client);
+        g_control_frame_clients.erase(std::remove(g_control_frame_clients.begin(), g_control_frame_clients.end(), client),
+                                      g_control_frame_clients.end());
+        for (std::map<int, std::vector<unsigned>>::iterator r = g_control_frame_reads.begin(); r != g_control_frame_reads.end(); ++r)
+            r->second.erase(std::remove(r->second.begin(), r->second.end(), client), r->second.end());
+    }
+}
+
+void stop_control_server()
+{
+    g_control.stop();
+    g_control_camera = false;
+    g_control_frame_clients.clear();
+    g_control_frame_reads.clear();
+    g_control_frames.clear();
+}
+
+// room for one window sized frame per slot
+bool start_frame_output(glm::ivec2 const& size)
+{
+    if (!g_frame_ring.create(g_frame_ring_name, g_frame_ring_slots, size_t(size.x) * size.y * 4)){
+        g_frame_ring_status = std::string("Could not create ") + g_frame_ring_name;
+        return false;
+    }
+
+    g_frame_ring_size = size;
+    g_frame_ring_status.clear();
+    return true;
+}
+
+void stop_frame_output()
+{
+    glm::ivec2 size;
+    int tag = 0;
+    bool copied = false;
+    while (g_frame_ring_readback.get_pending_count())
+        g_frame_ring_readback.poll(0, 0, size, tag, copied, true);
+
+    g_frame_ring.free();
+    g_frame_ring_times.clear();
+}
+
+// moves finished reads into free slots; frames are dropped while the consumer is behind
+void update_frame_output(glm::ivec2 const& window_size)
+{
+    if (!g_frame_ring.is_open())
+        return;
+
+    // a new ring for the new size, consumers see the old one closed and reopen
+    if (window_size != g_frame_ring_size && window_size.x > 0 && window_size.y > 0){
+        stop_frame_output();
+        if (!start_frame_output(window_size))
+            return;
+    }
+
+    glm::ivec2 size;
+    int tag = 0;
+    bool copied = false;
+    unsigned char* slot = g_frame_ring.begin_write();
+    while (g_frame_ring_readback.poll(slot, g_frame_ring.get_pixel_capacity(), size, tag, copied)){
+        // a slot is only published with the pixels of this read in it
+        if (copied){
+            size_t bytes = size_t(size.x) * size.y * 4;
+            g_frame_ring.end_write(tag, g_frame_ring_times[tag], size, std::uint32_t(bytes));
+            ++g_frame_ring_published;
+        }
+        else
+            ++g_frame_ring_dropped;
+
+        g_frame_ring_times.erase(tag);
+        slot = g_frame_ring.begin_write();
+    }
+}
+
+// blocking load for startup and the benchmark, a pending request is superseded
+bool read_volume(std::string& volume_string){
+
+    if (g_volume_load_job.valid())
+        g_volume_load_job.wait();
+    g_volume_load_job = std::future<std::shared_ptr<Volume_load>>();
+    g_volume_load_pending = false;
+
+    request_volume(volume_string);
+    finish_volume_load(g_volume_load_job.get());
+
+    return g_volume_texture;
+
+}
+
+// compositing shadows are only computed while they are shown
+bool illumination_needed()
+{
+    return g_shadow_toggle && g_task_chosen == 41;
+}
+
+// continues the illumination sweep and uploads it once complete
+void update_illumination_volume()
+{
+    if (!illumination_needed())
+        return;
+
+    if (g_illumination_reference_step != g_sampling_distance_ref){
+        g_illumination_reference_step = g_sampling_distance_ref;
+        g_illumination_volume.set_transfer_function(g_transfer_fun.get_RGBA_transfer_function_buffer(), g_sampling_distance_ref);
+    }
+
+    g_illumination_volume.set_light(g_light_pos);
+
+    if (!g_illumination_volume.is_complete() && g_illumination_volume.update(g_illumination_budget_ms))
+        upload_illumination_volume(false);
+}
+
+// the brick proxy only bounds rays for transfer function classified compositing
+void draw_proxy_geometry()
+{
+    if (g_use_brick_proxy && g_task_chosen == 41 && !g_brick_occupancy.empty())
+        g_brick_proxy.draw();
+    else
+        g_cube.draw();
+}
+
+// renders nearest front and farthest back faces of the proxy geometry
+void render_ray_entry_exit(glm::mat4 const& projection, glm::mat4 const& model_view, glm::ivec2 const& size)
+{
+    g_ray_entry_buffer.resize(size);
+    g_ray_exit_buffer.resize(size);
+
+    glUseProgram(g_ray_entry_exit_program);
+    glUniformMatrix4fv(glGetUniformLocation(g_ray_entry_exit_program, "Projection"), 1, GL_FALSE,
+        glm::value_ptr(projection));
+    glUniformMatrix4fv(glGetUniformLocation(g_ray_entry_exit_program, "Modelview"), 1, GL_FALSE,
+        glm::value_ptr(model_view));
+
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    g_ray_exit_buffer.bind();
+    glClearDepth(0.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDepthFunc(GL_GREATER);
+    glCullFace(GL_FRONT);
+    draw_proxy_geometry();
+
+    g_ray_entry_buffer.bind();
+    glClearDepth(1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDepthFunc(GL_LESS);
+    glCullFace(GL_BACK);
+    draw_proxy_geometry();
+
+    g_ray_entry_buffer.unbind();
 
-int g_bilinear_interpolation = true;
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glClearColor(g_background_color.x, g_background_color.y, g_background_color.z, 1.0);
+    glViewport(0, 0, size.x, size.y);
+    glUseProgram(0);
+}
 
-struct Manipulator
+// extraction runs in the background, the current mesh is drawn until the new one is ready
+void update_iso_mesh()
 {
-    Manipulator()
-    : m_turntable()
-    , m_mouse_button_pressed(0, 0, 0)
-    , m_mouse(0.0f, 0.0f)
-    , m_lastMouse(0.0f, 0.0f)
-    {}
+    if (g_iso_mesh_job.valid()
+        && g_iso_mesh_job.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+        g_iso_mesh = g_iso_mesh_job.get();
+        g_iso_mesh_geometry.update(g_iso_mesh.positions, g_iso_mesh.normals, g_iso_mesh.indices);
+    }
 
-    glm::mat4 matrix()
-    {
-        m_turntable.rotate(m_slidelastMouse, m_slideMouse);
-        return m_turntable.matrix();
+    // only the latest iso value is extracted, intermediate ones are skipped
+    if (!g_iso_mesh_job.valid() && g_iso_mesh_requested != g_iso_value){
+        float iso_value = g_iso_value;
+        g_iso_mesh_requested = iso_value;
+        glm::ivec3 roi_begin, roi_end;
+        get_roi_voxels(roi_begin, roi_end);
+        g_iso_mesh_job = Thread_pool::instance().submit([iso_value, roi_begin, roi_end]() {
+            return g_iso_extractor.extract(iso_value, g_iso_extractor.get_active_bricks(iso_value, roi_begin, roi_end));
+        });
     }
+}
 
-    glm::mat4 matrix(Window const& g_win)
-    {
-        m_mouse = g_win.mousePosition();
-        if (g_win.isButtonPressed(Window::MOUSE_BUTTON_LEFT)) {
-            if (!m_mouse_button_pressed[0]) {
-                m_mouse_button_pressed[0] = 1;
-            }
-            m_turntable.rotate(m_lastMouse, m_mouse);
-            m_slideMouse = m_mouse;
-            m_slidelastMouse = m_lastMouse;
-        }
-        else {
-            m_mouse_button_pressed[0] = 0;
-            m_turntable.rotate(m_slidelastMouse, m_slideMouse);
-            //m_slideMouse *= 0.99f;
-            //m_slidelastMouse *= 0.99f;
-        }
+void render_iso_mesh(glm::mat4 const& projection, glm::mat4 const& model_view, glm::vec3 const& camera_location)
+{
+    update_iso_mesh();
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    glUseProgram(g_iso_mesh_program);
+    glUniformMatrix4fv(glGetUniformLocation(g_iso_mesh_program, "Projection"), 1, GL_FALSE,
+        glm::value_ptr(projection));
+    glUniformMatrix4fv(glGetUniformLocation(g_iso_mesh_program, "Modelview"), 1, GL_FALSE,
+        glm::value_ptr(model_view));
+    glUniform3fv(glGetUniformLocation(g_iso_mesh_program, "camera_location"), 1,
+        glm::value_ptr(camera_location));
+    glUniform3fv(glGetUniformLocation(g_iso_mesh_program, "light_position"), 1,
+        glm::value_ptr(g_light_pos));
+    glUniform3fv(glGetUniformLocation(g_iso_mesh_program, "roi_min"), 1,
+        glm::value_ptr(glm::min(g_roi_min, g_roi_max) * g_max_volume_bounds));
+    glUniform3fv(glGetUniformLocation(g_iso_mesh_program, "roi_max"), 1,
+        glm::value_ptr(glm::max(g_roi_min, g_roi_max) * g_max_volume_bounds));
+    set_clip_plane_uniforms(g_iso_mesh_program);
+    glUniform3fv(glGetUniformLocation(g_iso_mesh_program, "light_ambient_color"), 1,
+        glm::value_ptr(g_ambient_light_color));
+    glUniform3fv(glGetUniformLocation(g_iso_mesh_program, "light_diffuse_color"), 1,
+        glm::value_ptr(g_diffuse_light_color));
+    glUniform3fv(glGetUniformLocation(g_iso_mesh_program, "light_specular_color"), 1,
+        glm::value_ptr(g_specula_light_color));
+    glUniform1f(glGetUniformLocation(g_iso_mesh_program, "light_ref_coef"), g_ref_coef);
+
+    if (!g_pause)
+        g_iso_mesh_geometry.draw();
 
-        if (g_win.isButtonPressed(Window::MOUSE_BUTTON_MIDDLE)) {
-            if (!m_mouse_button_pressed[1]) {
-                m_mouse_button_pressed[1] = 1;
-            }
-            m_turntable.pan(m_lastMouse, m_mouse);
-        }
-        else {
-            m_mouse_button_pressed[1] = 0;
-        }
+    glUseProgram(0);
+    glDisable(GL_DEPTH_TEST);
+}
 
-        if (g_win.isButtonPressed(Window::MOUSE_BUTTON_RIGHT)) {
-            if (!m_mouse_button_pressed[2]) {
-                m_mouse_button_pressed[2] = 1;
+// Blinn-Phong over the albedo, position and normal attachments of a hit buffer
+void render_deferred_shading(Framebuffer const& hit_buffer, glm::vec3 const& camera_location)
+{
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, hit_buffer.get_color_texture(0));
+    glActiveTexture(GL_TEXTURE5);
+    glBindTexture(GL_TEXTURE_2D, hit_buffer.get_color_texture(2));
+    glActiveTexture(GL_TEXTURE6);
+    glBindTexture(GL_TEXTURE_2D, hit_buffer.get_color_texture(3));
+    glActiveTexture(GL_TEXTURE0);
+
+    glUseProgram(g_deferred_shading_program);
+    glUniform1i(glGetUniformLocation(g_deferred_shading_program, "volume_texture"), 0);
+    glUniform1i(glGetUniformLocation(g_deferred_shading_program, "albedo_texture"), 4);
+    glUniform1i(glGetUniformLocation(g_deferred_shading_program, "position_texture"), 5);
+    glUniform1i(glGetUniformLocation(g_deferred_shading_program, "normal_texture"), 6);
+    glUniform1i(glGetUniformLocation(g_deferred_shading_program, "occlusion_texture"), 8);
+
+    glUniform3fv(glGetUniformLocation(g_deferred_shading_program, "camera_location"), 1,
+        glm::value_ptr(camera_location));
+    glUniform1f(glGetUniformLocation(g_deferred_shading_program, "sampling_distance"), g_sampling_distance);
+    glUniform1f(glGetUniformLocation(g_deferred_shading_program, "iso_value"), g_iso_value);
+    glUniform2fv(glGetUniformLocation(g_deferred_shading_program, "data_range"), 1,
+        glm::value_ptr(g_data_range));
+    glUniform3fv(glGetUniformLocation(g_deferred_shading_program, "max_bounds"), 1,
+        glm::value_ptr(g_max_volume_bounds));
+    glUniform3fv(glGetUniformLocation(g_deferred_shading_program, "light_position"), 1,
+        glm::value_ptr(g_light_pos));
+    glUniform3fv(glGetUniformLocation(g_deferred_shading_program, "light_ambient_color"), 1,
+        glm::value_ptr(g_ambient_light_color));
+    glUniform3fv(glGetUniformLocation(g_deferred_shading_program, "light_diffuse_color"), 1,
+        glm::value_ptr(g_diffuse_light_color));
+    glUniform3fv(glGetUniformLocation(g_deferred_shading_program, "light_specular_color"), 1,
+        glm::value_ptr(g_specula_light_color));
+    glUniform1f(glGetUniformLocation(g_deferred_shading_program, "light_ref_coef"), g_ref_coef);
+
+    g_screen_quad.draw();
+    glUseProgram(0);
+}
+
+bool file_exists(std::string const& file_path)
+{
+    std::ifstream file(file_path.c_str());
+    return file.good();
+}
+
+void start_step_benchmark()
+{
+    const int tasks[] = { 21, 22, 23, 31, 32, 41 };
+
+    g_benchmark_runs.clear();
+    for (unsigned v = 0; v != IM_ARRAYSIZE(g_volume_files); ++v){
+        if (!file_exists(g_volume_files[v]))
+            continue;
+        for (unsigned t = 0; t != IM_ARRAYSIZE(tasks); ++t){
+            for (int e = 0; e != 2; ++e){
+                Benchmark_run run = { g_volume_files[v], tasks[t], e == 1, 0.0f };
+                g_benchmark_runs.push_back(run);
             }
-            m_turntable.zoom(m_lastMouse, m_mouse);
         }
-        else {
-            m_mouse_button_pressed[2] = 0;
-        }
-
-        m_lastMouse = m_mouse;
-        return m_turntable.matrix();
     }
 
-private:
-    Turntable  m_turntable;
-    glm::ivec3 m_mouse_button_pressed;
-    glm::vec2  m_mouse;
-    glm::vec2  m_lastMouse;
-    glm::vec2  m_slideMouse;
-    glm::vec2  m_slidelastMouse;
-};
+    g_benchmark_restore_step_count = g_step_count_toggle;
+    g_benchmark_restore_early_termination = g_early_termination;
+    g_benchmark_restore_task = g_task_chosen;
+    g_benchmark_restore_file = g_file_string;
 
-bool read_volume(std::string& volume_string){
+    g_benchmark_index = 0;
+    g_benchmark_active = !g_benchmark_runs.empty();
+}
 
-    //init volume g_volume_loader
-    //Volume_loader_raw g_volume_loader;
-    //read volume dimensions
-    g_vol_dimensions = g_volume_loader.get_dimensions(g_file_string);
+// sets up the renderer for the current benchmark run, one run per frame
+void prepare_step_benchmark()
+{
+    Benchmark_run const& run = g_benchmark_runs[g_benchmark_index];
 
-    unsigned max_dim = std::max(std::max(g_vol_dimensions.x,
-        g_vol_dimensions.y),
-        g_vol_dimensions.z);
+    if (g_file_string != run.volume){
+        g_file_string = run.volume;
+        read_volume(g_file_string);
+    }
 
-    // calculating max volume bounds of volume (0.0 .. 1.0)
-    g_max_volume_bounds = glm::vec3(g_vol_dimensions) / glm::vec3((float)max_dim);
+    g_early_termination = run.early_termination;
+    g_reload_shader = g_reload_shader || !g_step_count_toggle || g_task_chosen != run.task;
+    g_step_count_toggle = true;
+    g_task_chosen = g_task_chosen_old = run.task;
+}
 
-    // loading volume file data
-    g_volume_data = g_volume_loader.load_volume(g_file_string);
-    g_channel_size = g_volume_loader.get_bit_per_channel(g_file_string) / 8;
-    g_channel_count = g_volume_loader.get_channel_count(g_file_string);
+void finish_step_benchmark(Framebuffer const& target)
+{
+    glm::ivec2 size = target.get_size();
+    std::vector<float> steps(size.x * size.y);
+    target.read_pixels(1, GL_RED, GL_FLOAT, &steps[0]);
+
+    // average over the pixels covered by the proxy geometry
+    double sum = 0.0;
+    size_t rays = 0;
+    for (std::vector<float>::const_iterator s = steps.begin(); s != steps.end(); ++s){
+        if (*s > 0.0f){
+            sum += *s;
+            ++rays;
+        }
+    }
 
-    // setting up proxy geometry
-    g_cube.freeVAO();
-    g_cube = Cube(glm::vec3(0.0, 0.0, 0.0), g_max_volume_bounds);
+    Benchmark_run& run = g_benchmark_runs[g_benchmark_index];
+    run.average_steps = rays ? float(sum / rays) : 0.0f;
 
-    glActiveTexture(GL_TEXTURE0);
-    g_volume_texture = createTexture3D(g_vol_dimensions.x, g_vol_dimensions.y, g_vol_dimensions.z, g_channel_size, g_channel_count, (char*)&g_volume_data[0]);
+    std::cout << run.volume << " task " << run.task
+        << " early termination " << (run.early_termination ? "on" : "off")
+        << ": " << run.average_steps << " steps per ray" << std::endl;
 
-    return g_volume_texture;
+    if (++g_benchmark_index == g_benchmark_runs.size()){
+        g_benchmark_active = false;
+        g_step_count_toggle = g_benchmark_restore_step_count;
+        g_early_termination = g_benchmark_restore_early_termination;
+        g_task_chosen = g_task_chosen_old = g_benchmark_restore_task;
+        g_reload_shader = true;
 
+        if (g_file_string != g_benchmark_restore_file){
+            g_file_string = g_benchmark_restore_file;
+            read_volume(g_file_string);
+        }
+    }
 }
 
 // This is the main rendering function that you have to implement and provide to ImGui (via setting up 'RenderDrawListsFn' in the ImGuiIO structure)
@@ -513,10 +2836,25 @@ void showGUI(){
         ImGui::Text("Introduction");
         ImGui::RadioButton("Max Intensity Projection", &g_task_chosen, 21);
         ImGui::RadioButton("Average Intensity Projection", &g_task_chosen, 22);
+        ImGui::RadioButton("Min Intensity Projection", &g_task_chosen, 23);
         ImGui::Text("Iso Surface Rendering");
         ImGui::RadioButton("Inaccurate", &g_task_chosen, 31);
         ImGui::RadioButton("Binary Search", &g_task_chosen, 32);
         ImGui::SliderFloat("Iso Value", &g_iso_value, 0.0f, 1.0f, "%.8f", 1.0f);
+        ImGui::Checkbox("Mesh Mode (rasterize extracted surface)", &g_iso_mesh_mode);
+        if (g_iso_mesh_mode){
+            ImGui::Text("Mesh: %u vertices, %u triangles", (unsigned)g_iso_mesh.positions.size(), (unsigned)g_iso_mesh.indices.size() / 3);
+
+            bool export_obj = false;
+            bool export_ply = false;
+            export_obj ^= ImGui::Button("Export OBJ"); ImGui::SameLine();
+            export_ply ^= ImGui::Button("Export PLY");
+
+            if (export_obj && !g_iso_mesh.save_obj("iso_surface.obj"))
+                std::cerr << "Could not write iso_surface.obj" << std::endl;
+            if (export_ply && !g_iso_mesh.save_ply("iso_surface.ply"))
+                std::cerr << "Could not write iso_surface.ply" << std::endl;
+        }
         ImGui::Text("Direct Volume Rendering");
         ImGui::RadioButton("Compositing", &g_task_chosen, 41);
         g_reload_shader ^= ImGui::Checkbox("1", &g_lighting_toggle); ImGui::SameLine();
@@ -528,6 +2866,9 @@ void showGUI(){
         g_reload_shader ^= ImGui::Checkbox("3", &g_opacity_correction_toggle); ImGui::SameLine();
         g_task_chosen == 41 ? ImGui::Text("Opacity Correction") : ImGui::TextColored(ImVec4(0.2f, 0.2f, 0.2f, 0.5f), "Opacity Correction");
 
+        g_reload_shader ^= ImGui::Checkbox("4", &g_deferred_shading); ImGui::SameLine();
+        g_task_chosen == 31 || g_task_chosen == 32 ? ImGui::Text("Deferred Lighting and Shadows") : ImGui::TextColored(ImVec4(0.2f, 0.2f, 0.2f, 0.5f), "Deferred Lighting and Shadows");
+
         if (g_task_chosen != g_task_chosen_old){
             g_reload_shader = true;
             g_task_chosen_old = g_task_chosen;
@@ -547,22 +2888,333 @@ void showGUI(){
         load_volume_2 ^= ImGui::Button("Load Volume Engine");
         load_volume_3 ^= ImGui::Button("Load Volume Bucky");
 
+        bool reload_volume = false;
+        reload_volume ^= ImGui::Checkbox("Convert to 8 bit (equalized)", &g_convert_to_8bit);
+        reload_volume ^= ImGui::Checkbox("Store float volumes as half", &g_half_float_texture);
+        ImGui::Text("Data range %.4f .. %.4f", g_data_range.x, g_data_range.y);
+        ImGui::Text("Voxels %d x %d x %d, spacing %.3f x %.3f x %.3f", g_vol_dimensions.x, g_vol_dimensions.y, g_vol_dimensions.z,
+            g_voxel_spacing.x, g_voxel_spacing.y, g_voxel_spacing.z);
+        reload_volume ^= ImGui::Checkbox("Resample to cubic voxels", &g_resample_isotropic);
+
+        ImGui::Text("Filters (applied on load)");
+        ImGui::Combo("Filter", &g_filter_type, "Gaussian\0Median 3x3x3\0Bilateral\0\0");
+        if (g_filter_type != Volume_filter::median)
+            ImGui::SliderFloat("Filter Sigma", &g_filter_sigma, 0.3f, 3.0f, "%.2f", 1.0f);
+        if (g_filter_type == Volume_filter::bilateral)
+            ImGui::SliderFloat("Filter Range Sigma", &g_filter_range_sigma, 0.01f, 0.5f, "%.3f", 1.0f);
+
+        if (ImGui::Button("Add Filter")){
+            Volume_filter filter = { Volume_filter::Type(g_filter_type), g_filter_sigma, g_filter_range_sigma };
+            g_volume_filters.add(filter);
+            reload_volume = true;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear Filters") && !g_volume_filters.empty()){
+            g_volume_filters.clear();
+            reload_volume = true;
+        }
+
+        static const char* filter_names[] = { "Gaussian", "Median", "Bilateral" };
+        for (unsigned i = 0; i != g_volume_filters.get_filters().size(); ++i){
+            Volume_filter const& filter = g_volume_filters.get_filters()[i];
+            ImGui::Text("%u: %s, radius %d", i + 1, filter_names[filter.type], filter.get_radius());
+        }
+        if (g_volume_load_job.valid())
+            ImGui::Text("Loading...");
+        else if (!g_volume_load_status.empty())
+            ImGui::Text("%s", g_volume_load_status.c_str());
+
+        if (reload_volume){
+            request_volume(g_file_string);
+        }
+
 
         if (load_volume_1){
-            g_file_string = "../../../data/head_w256_h256_d225_c1_b8.raw";
-            read_volume(g_file_string);
+            g_file_string = g_volume_files[0];
+            request_volume(g_file_string);
         }
         if (load_volume_2){
-            g_file_string = "../../../data/Engine_w256_h256_d256_c1_b8.raw";
-            read_volume(g_file_string);
+            g_file_string = g_volume_files[1];
+            request_volume(g_file_string);
         }
 
         if (load_volume_3){
-            g_file_string = "../../../data/Bucky_uncertainty_data_w32_h32_d32_c1_b8.raw";
-            read_volume(g_file_string);
+            g_file_string = g_volume_files[2];
+            request_volume(g_file_string);
+        }
+    }
+
+
+    if (ImGui::CollapsingHeader("Region of Interest"))
+    {
+        ImGui::SliderFloat3("ROI Min", &g_roi_min[0], 0.0f, 1.0f);
+        ImGui::SliderFloat3("ROI Max", &g_roi_max[0], 0.0f, 1.0f);
+
+        glm::ivec3 roi_begin, roi_end;
+        get_roi_voxels(roi_begin, roi_end);
+        ImGui::Text("Voxels %d..%d x %d..%d x %d..%d%s", roi_begin.x, roi_end.x, roi_begin.y, roi_end.y,
+            roi_begin.z, roi_end.z, g_volume_cropped ? " (cropped volume)" : "");
+
+        if (ImGui::Button("Reset ROI")){
+            g_roi_min = glm::vec3(0.0f);
+            g_roi_max = glm::vec3(1.0f);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Crop to ROI"))
+            request_volume_crop();
+        ImGui::SameLine();
+        if (ImGui::Button("Export ROI Raw"))
+            export_volume_roi();
+    }
+
+    if (ImGui::CollapsingHeader("Clipping Planes"))
+    {
+        ImGui::SliderInt("Planes", &g_clip_plane_count, 0, g_max_clip_planes);
+
+        for (int i = 0; i != g_clip_plane_count; ++i){
+            ImGui::PushID(i);
+            ImGui::Text("Plane %d", i + 1);
+            ImGui::Checkbox("Enabled", &g_clip_planes[i].enabled);
+            ImGui::SliderFloat3("Normal", &g_clip_planes[i].normal[0], -1.0f, 1.0f);
+            ImGui::SliderFloat("Offset", &g_clip_planes[i].offset, -1.0f, 1.0f);
+            if (ImGui::Button("Flip"))
+                g_clip_planes[i].normal = -g_clip_planes[i].normal;
+            ImGui::PopID();
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Slice Views"))
+    {
+        ImGui::Checkbox("Show Axial, Coronal, Sagittal, Oblique", &g_mpr_toggle);
+        ImGui::SliderFloat3("Slice Center", &g_mpr.center[0], 0.0f, 1.0f);
+        ImGui::SliderFloat("Oblique Yaw", &g_mpr.yaw, -PI, PI);
+        ImGui::SliderFloat("Oblique Pitch", &g_mpr.pitch, -0.5f * PI, 0.5f * PI);
+    }
+
+    if (ImGui::CollapsingHeader("Thick Slab"))
+    {
+        static const int slab_tasks[] = { 21, 23, 22 };
+        bool slab_changed = false;
+
+        slab_changed ^= ImGui::Checkbox("Enable Slab", &g_slab_toggle);
+        slab_changed ^= ImGui::RadioButton("Maximum", &g_mpr.slab_mode, Slab_projector::maximum); ImGui::SameLine();
+        slab_changed ^= ImGui::RadioButton("Minimum", &g_mpr.slab_mode, Slab_projector::minimum); ImGui::SameLine();
+        slab_changed ^= ImGui::RadioButton("Average", &g_mpr.slab_mode, Slab_projector::average);
+        ImGui::Combo("Orientation", &g_slab_orientation, "Axial\0Coronal\0Sagittal\0Oblique\0\0");
+        ImGui::SliderFloat("Thickness", &g_mpr.slab_thickness, 0.002f, 1.0f, "%.3f", 2.0f);
+        ImGui::Text("Centered on the slice center, slice views show the slabs");
+
+        // the volume is rendered with the matching projection
+        if (slab_changed && g_slab_toggle && g_task_chosen != slab_tasks[g_mpr.slab_mode]){
+            g_task_chosen = g_task_chosen_old = slab_tasks[g_mpr.slab_mode];
+            g_reload_shader = true;
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Segmentation Labels"))
+    {
+        ImGui::InputText("Label File", g_label_file, sizeof(g_label_file));
+        if (ImGui::Button("Load Labels") && g_label_file[0])
+            request_labels(g_label_file);
+        if (g_label_load_job.valid())
+            ImGui::Text("Loading labels...");
+
+        if (g_label_volume){
+            if (ImGui::Checkbox("Render Labels", &g_label_toggle)){
+                g_reload_shader = true;
+                g_hit_cache_valid = false;
+                request_brick_proxy(g_transfer_shown);
+            }
+
+            int label_count = (int)g_label_styles.size();
+            ImGui::Text("%d labels", label_count);
+            ImGui::SliderInt("Label", &g_label_selected, 0, label_count - 1);
+            g_label_selected = std::min(std::max(g_label_selected, 0), label_count - 1);
+
+            Label_style& style = g_label_styles[g_label_selected];
+            bool label_changed = false;
+            label_changed ^= ImGui::Checkbox("Visible", &style.visible);
+            label_changed ^= ImGui::ColorEdit3("Label Color", &style.color[0]);
+            label_changed ^= ImGui::SliderFloat("Label Opacity", &style.opacity, 0.0f, 1.0f);
+            if (ImGui::Button("Use Current Transfer Function")){
+                style.transfer_function = g_transfer_shown;
+                label_changed = true;
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Follow Global")){
+                style.transfer_function.clear();
+                label_changed = true;
+            }
+            ImGui::Text(style.transfer_function.empty() ? "Follows the global transfer function" : "Own transfer function");
+
+            if (label_changed){
+                update_label_row(g_label_selected);
+                g_hit_cache_valid = false;
+            }
+
+            bool show_all = ImGui::Button("Show All");
+            ImGui::SameLine();
+            bool hide_all = ImGui::Button("Hide All");
+            if (show_all || hide_all){
+                for (unsigned l = 0; l != g_label_styles.size(); ++l)
+                    g_label_styles[l].visible = show_all;
+                upload_label_rows(g_transfer_shown);
+                g_hit_cache_valid = false;
+                if (labels_enabled())
+                    request_brick_proxy(g_transfer_shown);
+            }
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Scene"))
+    {
+        ImGui::Checkbox("Render Scene", &g_scene_toggle);
+        ImGui::Text("%u of %u volumes, %.1f MB resident", g_scene.size(), g_max_scene_volumes,
+            g_scene.get_resident_bytes() / float(1 << 20));
+        if (ImGui::SliderInt("Texture Budget (MB)", &g_scene_budget_mb, 16, 2048))
+            update_scene_budget();
+
+        if (ImGui::Button("Add Current Volume"))
+            add_current_volume_to_scene();
+        static const char* scene_file_buttons[] = { "Add Head", "Add Engine", "Add Bucky" };
+        for (unsigned v = 0; v != IM_ARRAYSIZE(g_volume_files); ++v){
+            ImGui::SameLine();
+            if (ImGui::Button(scene_file_buttons[v]))
+                request_scene_volume(g_volume_files[v]);
+        }
+        if (g_scene_load_job.valid())
+            ImGui::Text("Loading...");
+
+        if (!g_scene.empty()){
+            ImGui::SliderInt("Scene Volume", &g_scene_selected, 0, int(g_scene.size()) - 1);
+            g_scene_selected = std::max(0, std::min(g_scene_selected, int(g_scene.size()) - 1));
+
+            Scene_volume& volume = g_scene[g_scene_selected];
+            glm::ivec3 resident = volume.get_resident_dimensions();
+            ImGui::Text("%s", volume.name.c_str());
+            ImGui::Text("Texture %d x %d x %d, level %d", resident.x, resident.y, resident.z, volume.level);
+            ImGui::SliderFloat3("Position", &volume.position[0], -2.0f, 3.0f);
+            ImGui::SliderFloat("Yaw", &volume.yaw, -PI, PI);
+            ImGui::SliderFloat("Scale", &volume.scale, 0.1f, 2.0f);
+            if (ImGui::Button("Assign Current Transfer Function")){
+                volume.transfer_function = g_transfer_shown;
+                upload_scene_transfer_rows();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Remove"))
+                remove_scene_volume(g_scene_selected);
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Screenshot and Poster"))
+    {
+        if (ImGui::Button("Save Screenshot"))
+            g_screenshot_requested = true;
+
+        ImGui::SliderInt("Poster Width", &g_poster_request.x, 256, 16384);
+        ImGui::SliderInt("Poster Height", &g_poster_request.y, 256, 16384);
+        if (g_poster_active){
+            glm::ivec2 tiles = get_poster_tiles();
+            ImGui::Text("Tile %d of %d", std::min(g_poster_tile + 1, tiles.x * tiles.y), tiles.x * tiles.y);
+        }
+        else if (g_poster_job.valid())
+            ImGui::Text("Writing %s...", g_poster_file.c_str());
+        else if (ImGui::Button("Render Poster"))
+            start_poster(g_win.windowSize());
+
+        if (!g_image_status.empty())
+            ImGui::Text("%s", g_image_status.c_str());
+    }
+
+    if (ImGui::CollapsingHeader("Camera Path"))
+    {
+        ImGui::Text("%u keys, %.2f s", g_camera_path.size(), g_camera_path.get_duration());
+
+        if (ImGui::Button("Add Key"))
+            g_camera_path.add_key(g_camera_path.empty() ? 0.0 : g_camera_path.get_duration() + g_camera_key_spacing,
+                g_camera_pose);
+        ImGui::SameLine();
+        if (ImGui::Button("Remove Last Key") && !g_camera_path.empty())
+            g_camera_path.remove_key(g_camera_path.size() - 1);
+        ImGui::SameLine();
+        if (ImGui::Button("Clear Path")){
+            g_camera_path.clear();
+            g_camera_playing = false;
         }
+        ImGui::SliderFloat("Key Spacing (s)", &g_camera_key_spacing, 0.1f, 10.0f);
+
+        bool recording = g_camera_recording;
+        if (ImGui::Checkbox("Record Mouse", &recording)){
+            if (recording)
+                start_camera_recording();
+            else
+                g_camera_recording = false;
+        }
+        ImGui::SliderFloat("Record Interval (s)", &g_camera_record_interval, 0.05f, 1.0f);
+
+        ImGui::SliderFloat("Orbit Duration (s)", &g_orbit_seconds, 1.0f, 60.0f);
+        ImGui::SliderFloat("Orbit Turns", &g_orbit_turns, -3.0f, 3.0f);
+        if (ImGui::Button("Create Orbit")){
+            g_camera_recording = false;
+            g_camera_path = Camera_path::orbit(g_camera_pose, g_orbit_seconds, g_orbit_turns);
+        }
+
+        if (ImGui::Checkbox("Play Path", &g_camera_playing)){
+            g_camera_recording = false;
+            g_camera_play_start = glfwGetTime();
+        }
+
+        ImGui::Combo("Export Format", &g_export_format, "Y4M Video\0PPM Sequence\0\0");
+        ImGui::SliderInt("Frames per Second", &g_export_fps, 10, 60);
+        ImGui::SliderFloat("Export Sampling Step", &g_export_sampling_distance, 0.0005f, 0.01f, "%.5f", 4.0f);
+        if (g_export_active)
+            ImGui::Text("Frame %d of %d, %u encoding", g_export_frame, g_export_frame_count,
+                unsigned(g_export_writes.size()));
+        else if (!g_export_writes.empty())
+            ImGui::Text("Writing %s...", g_export_file.c_str());
+        else if (ImGui::Button("Export Animation"))
+            start_animation_export(g_win.windowSize());
     }
 
+    if (ImGui::CollapsingHeader("Control Server"))
+    {
+        ImGui::InputText("Socket", g_control_socket, sizeof(g_control_socket));
+        bool listening = g_control.is_running();
+        if (ImGui::Checkbox("Listen", &listening)){
+            if (!listening)
+                stop_control_server();
+            else if (g_control.start(g_control_socket))
+                g_control_status.clear();
+            else
+                g_control_status = std::string("Could not listen on ") + g_control_socket;
+        }
+        if (g_control.is_running())
+            ImGui::Text("%u clients", g_control.get_client_count());
+        if (g_control_camera && ImGui::Button("Release Camera"))
+            g_control_camera = false;
+        if (!g_control_status.empty())
+            ImGui::Text("%s", g_control_status.c_str());
+    }
+
+    if (ImGui::CollapsingHeader("Frame Output"))
+    {
+        ImGui::InputText("Shared Memory Name", g_frame_ring_name, sizeof(g_frame_ring_name));
+        ImGui::SliderInt("Ring Slots", &g_frame_ring_slots, 2, 16);
+        bool publishing = g_frame_ring.is_open();
+        if (ImGui::Checkbox("Publish Frames", &publishing)){
+            if (publishing){
+                g_frame_ring_published = g_frame_ring_dropped = 0;
+                start_frame_output(g_win.windowSize());
+            }
+            else
+                stop_frame_output();
+        }
+        if (g_frame_ring.is_open())
+            ImGui::Text("%u published, %u dropped, %u unread", g_frame_ring_published, g_frame_ring_dropped,
+                g_frame_ring.get_pending_count());
+        if (!g_frame_ring_status.empty())
+            ImGui::Text("%s", g_frame_ring_status.c_str());
+    }
 
     if (ImGui::CollapsingHeader("Lighting Settings"))
     {
@@ -583,9 +3235,46 @@ void showGUI(){
         ImGui::RadioButton("Nearest Neighbour", &g_bilinear_interpolation, 0);
         ImGui::RadioButton("Bilinear", &g_bilinear_interpolation, 1);
 
+        ImGui::Checkbox("Brick Proxy Geometry (Compositing)", &g_use_brick_proxy);
+        ImGui::Text("Proxy triangles %u", g_brick_proxy.get_vertex_count() / 3);
+
+        ImGui::SliderFloat("Shadow Sweep Budget (ms)", &g_illumination_budget_ms, 0.5f, 33.0f, "%.1f", 1.0f);
+
+        g_reload_shader ^= ImGui::Checkbox("Ambient Occlusion", &g_occlusion_toggle);
+        g_occlusion_dirty |= ImGui::SliderInt("Occlusion Radius", &g_occlusion_radius, 1, 8);
+        g_occlusion_dirty |= ImGui::SliderFloat("Occlusion Strength", &g_occlusion_strength, 0.0f, 4.0f, "%.2f", 1.0f);
+
         ImGui::Text("Slamping Size");
         ImGui::SliderFloat("sampling step", &g_sampling_distance, 0.0005f, 0.1f, "%.5f", 4.0f);
-        ImGui::SliderFloat("reference sampling step", &g_sampling_distance_ref, 0.0005f, 0.1f, "%.5f", 4.0f);
+        g_occlusion_dirty |= ImGui::SliderFloat("reference sampling step", &g_sampling_distance_ref, 0.0005f, 0.1f, "%.5f", 4.0f);
+    }
+
+    if (ImGui::CollapsingHeader("Early Ray Termination"))
+    {
+        ImGui::Checkbox("Enable Early Termination", &g_early_termination);
+        ImGui::SliderFloat("Opacity Cutoff", &g_termination_alpha, 0.5f, 1.0f, "%.3f", 1.0f);
+        g_reload_shader ^= ImGui::Checkbox("Step Count Heat Map", &g_step_count_toggle);
+
+        g_reload_shader ^= ImGui::Checkbox("Cache First Hits (Task 31/32)", &g_hit_cache_toggle);
+        ImGui::SliderFloat("Max Camera Delta", &g_hit_cache_max_delta, 0.0f, 0.2f, "%.4f", 2.0f);
+        ImGui::SliderInt("Local Search Steps", &g_hit_search_steps, 1, 32);
+        ImGui::SliderInt("Full March Every", &g_hit_cache_max_seeded_frames, 1, 64);
+
+        bool start_benchmark = false;
+        start_benchmark ^= ImGui::Button("Run Step Benchmark");
+
+        if (start_benchmark && !g_benchmark_active){
+            start_step_benchmark();
+        }
+
+        if (!g_benchmark_runs.empty()){
+            ImGui::Text("volume / task / termination: steps per ray");
+            for (std::vector<Benchmark_run>::iterator r = g_benchmark_runs.begin(); r != g_benchmark_runs.end(); ++r){
+                std::string name = r->volume.substr(r->volume.find_last_of("/") + 1);
+                ImGui::Text("%s / %d / %s: %.1f", name.substr(0, name.find("_w")).c_str(),
+                    r->task, r->early_termination ? "on " : "off", r->average_steps);
+            }
+        }
     }
 
     if (ImGui::CollapsingHeader("Shader", 0, true, true))
@@ -782,92 +3471,52 @@ void showGUI(){
     if (ImGui::CollapsingHeader("Transfer Function - Save/Load", 0, true, false))
     {
 
-        ImGui::Text("Transferfunctions");
-        bool load_tf_1 = false;
-        bool load_tf_2 = false;
-        bool load_tf_3 = false;
-        bool load_tf_4 = false;
-        bool load_tf_5 = false;
-        bool load_tf_6 = false;
-        bool save_tf_1 = false;
-        bool save_tf_2 = false;
-        bool save_tf_3 = false;
-        bool save_tf_4 = false;
-        bool save_tf_5 = false;
-        bool save_tf_6 = false;
-
-        save_tf_1 ^= ImGui::Button("Save TF1"); ImGui::SameLine();
-        load_tf_1 ^= ImGui::Button("Load TF1");
-        save_tf_2 ^= ImGui::Button("Save TF2"); ImGui::SameLine();
-        load_tf_2 ^= ImGui::Button("Load TF2");
-        save_tf_3 ^= ImGui::Button("Save TF3"); ImGui::SameLine();
-        load_tf_3 ^= ImGui::Button("Load TF3");
-        save_tf_4 ^= ImGui::Button("Save TF4"); ImGui::SameLine();
-        load_tf_4 ^= ImGui::Button("Load TF4");
-        save_tf_5 ^= ImGui::Button("Save TF5"); ImGui::SameLine();
-        load_tf_5 ^= ImGui::Button("Load TF5");
-        save_tf_6 ^= ImGui::Button("Save TF6"); ImGui::SameLine();
-        load_tf_6 ^= ImGui::Button("Load TF6");
-
-        if (save_tf_1 || save_tf_2 || save_tf_3 || save_tf_4 || save_tf_5 || save_tf_6){
-            Transfer_function::container_type con = g_transfer_fun.get_piecewise_container();
-            std::vector<Transfer_function::element_type> save_vect;
-
-            for (Transfer_function::container_type::iterator c = con.begin(); c != con.end(); ++c)
-            {
-                save_vect.push_back(*c);
-            }
-
-            std::ofstream tf_file;
+        static char preset_name[64] = "preset";
 
-            if (save_tf_1){ tf_file.open("TF1", std::ios::out | std::ofstream::binary); }
-            if (save_tf_2){ tf_file.open("TF2", std::ios::out | std::ofstream::binary); }
-            if (save_tf_3){ tf_file.open("TF3", std::ios::out | std::ofstream::binary); }
-            if (save_tf_4){ tf_file.open("TF4", std::ios::out | std::ofstream::binary); }
-            if (save_tf_5){ tf_file.open("TF5", std::ios::out | std::ofstream::binary); }
-            if (save_tf_6){ tf_file.open("TF6", std::ios::out | std::ofstream::binary); }
+        ImGui::Text("Transferfunctions");
+        ImGui::InputText("Name", preset_name, sizeof(preset_name));
 
-            //std::copy(save_vect.begin(), save_vect.end(), std::ostreambuf_iterator<char>(tf_file));
-            tf_file.write((char*)&save_vect[0], sizeof(Transfer_function::element_type) * save_vect.size());
-            tf_file.close();
+        if (ImGui::Button("Save Preset")){
+            g_preset_current = g_tf_library.set(Transfer_function_library::make_preset(
+                preset_name, g_transfer_fun.get_piecewise_container()));
+            save_tf_library();
         }
 
-        if (load_tf_1 || load_tf_2 || load_tf_3 || load_tf_4 || load_tf_5 || load_tf_6){
-            Transfer_function::container_type con = g_transfer_fun.get_piecewise_container();
-            std::vector<Transfer_function::element_type> load_vect;
-
-            std::ifstream tf_file;
-
-            if (load_tf_1){ tf_file.open("TF1", std::ios::in | std::ifstream::binary); }
-            if (load_tf_2){ tf_file.open("TF2", std::ios::in | std::ifstream::binary); }
-            if (load_tf_3){ tf_file.open("TF3", std::ios::in | std::ifstream::binary); }
-            if (load_tf_4){ tf_file.open("TF4", std::ios::in | std::ifstream::binary); }
-            if (load_tf_5){ tf_file.open("TF5", std::ios::in | std::ifstream::binary); }
-            if (load_tf_6){ tf_file.open("TF6", std::ios::in | std::ifstream::binary); }
-
-
-            if (tf_file.good()){
-                tf_file.seekg(0, tf_file.end);
+        if (g_tf_library.size()){
+            g_preset_current = std::min(g_preset_current, (int)g_tf_library.size() - 1);
 
-                size_t size = tf_file.tellg();
-                unsigned elements = size / (unsigned)sizeof(Transfer_function::element_type);
-                tf_file.seekg(0);
+            // switching copies the baked table, no rebake
+            if (ImGui::Combo("Presets", &g_preset_current, get_preset_name, &g_tf_library, g_tf_library.size()))
+                apply_preset(g_tf_library.get(g_preset_current));
 
-                load_vect.resize(elements);
-                tf_file.read((char*)&load_vect[0], size);
-
-                g_transfer_fun.reset();
-                g_transfer_dirty = true;
-                for (std::vector<Transfer_function::element_type>::iterator c = load_vect.begin(); c != load_vect.end(); ++c)
-                {
-                    g_transfer_fun.add(c->first, c->second);
-                }
+            if (ImGui::Button("Apply Preset"))
+                apply_preset(g_tf_library.get(g_preset_current));
+            ImGui::SameLine();
+            if (ImGui::Button("Delete Preset")){
+                g_tf_library.remove(g_preset_current);
+                save_tf_library();
             }
+        }
 
-            tf_file.close();
-
+        // blends back and forth between the last two classifications
+        ImGui::SliderFloat("Transition (s)", &g_tf_transition_seconds, 0.0f, 5.0f, "%.2f", 1.0f);
+        if (!g_tf_previous_lut.empty() && ImGui::Button("Toggle Previous")){
+            Transfer_function::container_type points = g_tf_previous_points;
+            image_data_type lut = g_tf_previous_lut;
+            g_tf_previous_points = g_transfer_fun.get_piecewise_container();
+            g_tf_previous_lut = g_transfer_lut;
+            transition_to(points, lut);
         }
 
+        if (ImGui::Button("Export Text"))
+            g_tf_library.export_text(g_tf_library_text_file);
+        ImGui::SameLine();
+        if (ImGui::Button("Import Text")){
+            if (g_tf_library.import_text(g_tf_library_text_file))
+                save_tf_library();
+            else
+                std::cerr << "Could not read " << g_tf_library_text_file << std::endl;
+        }
     }
 
     ImGui::End();
@@ -878,6 +3527,10 @@ int main(int argc, char* argv[])
     //g_win = Window(g_window_res);
     InitImGui();
 
+    g_step_count_buffer = Framebuffer(std::vector<GLenum>{ GL_RGBA8, GL_R32F });
+    for (unsigned i = 0; i != 2; ++i)
+        g_hit_buffers[i] = Framebuffer(std::vector<GLenum>{ GL_RGBA8, GL_R32F, GL_RGBA32F, GL_RGBA16F });
+
     // initialize the transfer function
 
     // first clear possible old values
@@ -899,6 +3552,24 @@ int main(int argc, char* argv[])
     glActiveTexture(GL_TEXTURE1);
     g_transfer_texture = createTexture2D(255u, 1u, (char*)&g_transfer_fun.get_RGBA_transfer_function_buffer()[0]);
 
+    if (!g_tf_library.load(g_tf_library_file))
+        import_legacy_transfer_functions();
+
+    g_ray_entry_buffer = Framebuffer(std::vector<GLenum>{ GL_RGBA32F }, true);
+    g_ray_exit_buffer = Framebuffer(std::vector<GLenum>{ GL_RGBA32F }, true);
+
+    try {
+        g_ray_entry_exit_program = loadShaders(g_ray_entry_exit_vertex_shader, g_ray_entry_exit_fragment_shader);
+        g_iso_mesh_program = loadShaders(g_iso_mesh_vertex_shader, g_iso_mesh_fragment_shader);
+        g_slice_program = loadShaders(g_file_vertex_shader, g_slice_fragment_shader);
+        g_scene_program = loadShaders(g_file_vertex_shader, g_scene_fragment_shader);
+        g_deferred_shading_program = loadShaders(g_file_vertex_shader, g_deferred_shading_fragment_shader,
+            g_task_chosen, g_lighting_toggle, g_shadow_toggle, g_opacity_correction_toggle, get_shader_defines());
+    }
+    catch (std::logic_error& e) {
+        std::cerr << e.what() << std::endl;
+    }
+
     // loading actual raytracing shader code (volume.vert, volume.frag)
     // edit volume.frag to define the result of our volume raycaster  
     try {
@@ -906,7 +3577,8 @@ int main(int argc, char* argv[])
             g_task_chosen,
             g_lighting_toggle,
             g_shadow_toggle,
-            g_opacity_correction_toggle);
+            g_opacity_correction_toggle,
+            get_shader_defines());
     }
     catch (std::logic_error& e) {
         //std::cerr << e.what() << std::endl;
@@ -974,13 +3646,17 @@ int main(int argc, char* argv[])
         //    
         //}
 
+        if (g_benchmark_active){
+            prepare_step_benchmark();
+        }
+
         /// reload shader if key R ist pressed
         if (g_reload_shader){
 
             GLuint newProgram(0);
             try {
                 //std::cout << "Reload shaders" << std::endl;
-                newProgram = loadShaders(g_file_vertex_shader, g_file_fragment_shader, g_task_chosen, g_lighting_toggle, g_shadow_toggle, g_opacity_correction_toggle);
+                newProgram = loadShaders(g_file_vertex_shader, g_file_fragment_shader, g_task_chosen, g_lighting_toggle, g_shadow_toggle, g_opacity_correction_toggle, get_shader_defines());
                 g_error_message = "";
             }
             catch (std::logic_error& e) {
@@ -995,6 +3671,17 @@ int main(int argc, char* argv[])
                 glDeleteProgram(g_volume_program);
                 g_volume_program = newProgram;
                 g_reload_shader_error = false;
+                g_hit_cache_valid = false;
+
+                try {
+                    GLuint deferred_program = loadShaders(g_file_vertex_shader, g_deferred_shading_fragment_shader,
+                        g_task_chosen, g_lighting_toggle, g_shadow_toggle, g_opacity_correction_toggle, get_shader_defines());
+                    glDeleteProgram(g_deferred_shading_program);
+                    g_deferred_shading_program = deferred_program;
+                }
+                catch (std::logic_error& e) {
+                    std::cerr << e.what() << std::endl;
+                }
 
             }
             else
@@ -1021,16 +3708,21 @@ int main(int argc, char* argv[])
 
         if (g_transfer_dirty){
             g_transfer_dirty = false;
+            g_tf_animation.stop();
+            g_transfer_lut = g_transfer_fun.get_RGBA_transfer_function_buffer();
+            apply_transfer_lut(g_transfer_lut);
+        }
 
-            static unsigned byte_size = 255;
-
-            image_data_type color_con = g_transfer_fun.get_RGBA_transfer_function_buffer();
-
-            glActiveTexture(GL_TEXTURE1);
-            glDeleteTextures(1, &g_transfer_texture);
-            g_transfer_texture = createTexture2D(255u, 1u, (char*)&g_transfer_fun.get_RGBA_transfer_function_buffer()[0]);
+        update_transfer_animation();
 
-        }
+        update_volume_load();
+        update_label_load();
+        update_scene_load();
+        update_roi();
+        update_clip_planes();
+        update_brick_proxy();
+        update_illumination_volume();
+        update_occlusion_volume();
 
         glBindTexture(GL_TEXTURE_3D, g_volume_texture);
 
@@ -1044,6 +3736,11 @@ int main(int argc, char* argv[])
         }
 
         glm::ivec2 size = g_win.windowSize();
+        update_image_export(size);
+        update_animation_export(size);
+        update_control_server();
+        update_frame_output(size);
+
         glViewport(0, 0, size.x, size.y);
         glClearColor(g_background_color.x, g_background_color.y, g_background_color.z, 1.0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -1051,8 +3748,22 @@ int main(int argc, char* argv[])
         float fovy = 45.0f;
         float aspect = (float)size.x / (float)size.y;
         float zNear = 0.025f, zFar = 10.0f;
+        bool poster_tile = poster_rendering();
+        if (poster_tile)
+            aspect = float(g_poster_size.x) / float(g_poster_size.y);
         glm::mat4 projection = glm::perspective(fovy, aspect, zNear, zFar);
 
+        // every tile has its own projection, the hits of the last one do not fit
+        if (poster_tile){
+            projection = get_poster_tile_projection(g_poster_tile) * projection;
+            g_hit_cache_valid = false;
+        }
+
+        // exported frames do not depend on the hits of the frame before
+        bool export_frame = exporting_frames();
+        if (export_frame)
+            g_hit_cache_valid = false;
+
         glm::vec3 translate_rot = g_max_volume_bounds * glm::vec3(-0.5f, -0.5f, -0.5f);
         glm::vec3 translate_pos = g_max_volume_bounds * glm::vec3(+0.5f, -0.0f, -0.0f);
 
@@ -1068,6 +3779,21 @@ int main(int argc, char* argv[])
             turntable_matrix = manipulator.matrix(g_win);
         }
 
+        // the camera is kept while a poster is rendered, paths replace the mouse
+        Turntable path_pose;
+        if (g_poster_active)
+            turntable_matrix = g_poster_pose.matrix();
+        else if (g_control_camera){
+            turntable_matrix = g_control_pose.matrix();
+            update_camera_path(g_control_pose);
+        }
+        else if (get_camera_path_pose(path_pose)){
+            turntable_matrix = path_pose.matrix();
+            update_camera_path(path_pose);
+        }
+        else
+            update_camera_path(manipulator.turntable());
+
         glm::detail::tmat4x4<float, glm::highp> model_view = view
             //* glm::inverse(glm::translate(translate_pos))
             //* glm::translate(translate_rot)
@@ -1086,37 +3812,184 @@ int main(int argc, char* argv[])
 
         glm::vec4 light_location = glm::vec4(g_light_pos, 1.0f) * model_view;
 
-        glUseProgram(g_volume_program);
-
-        glUniform1i(glGetUniformLocation(g_volume_program, "volume_texture"), 0);
-        glUniform1i(glGetUniformLocation(g_volume_program, "transfer_texture"), 1);
-
-        glUniform3fv(glGetUniformLocation(g_volume_program, "camera_location"), 1,
-            glm::value_ptr(camera_location));
-        glUniform1f(glGetUniformLocation(g_volume_program, "sampling_distance"), g_sampling_distance);
-        glUniform1f(glGetUniformLocation(g_volume_program, "sampling_distance_ref"), g_sampling_distance_ref);
-        glUniform1f(glGetUniformLocation(g_volume_program, "iso_value"), g_iso_value);
-        glUniform3fv(glGetUniformLocation(g_volume_program, "max_bounds"), 1,
-            glm::value_ptr(g_max_volume_bounds));
-        glUniform3iv(glGetUniformLocation(g_volume_program, "volume_dimensions"), 1,
-            glm::value_ptr(g_vol_dimensions));
-        glUniform3fv(glGetUniformLocation(g_volume_program, "light_position"), 1,
-            glm::value_ptr(g_light_pos));
-        glUniform3fv(glGetUniformLocation(g_volume_program, "light_ambient_color"), 1,
-            glm::value_ptr(g_ambient_light_color));
-        glUniform3fv(glGetUniformLocation(g_volume_program, "light_diffuse_color"), 1,
-            glm::value_ptr(g_diffuse_light_color));
-        glUniform3fv(glGetUniformLocation(g_volume_program, "light_specular_color"), 1,
-            glm::value_ptr(g_specula_light_color));
-        glUniform1f(glGetUniformLocation(g_volume_program, "light_ref_coef"), g_ref_coef);
-
-        glUniformMatrix4fv(glGetUniformLocation(g_volume_program, "Projection"), 1, GL_FALSE,
-            glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(g_volume_program, "Modelview"), 1, GL_FALSE,
-            glm::value_ptr(model_view));
-        if (!g_pause)
-            g_cube.draw();
-        glUseProgram(0);
+        bool draw_iso_mesh = g_iso_mesh_mode && (g_task_chosen == 31 || g_task_chosen == 32);
+
+        if (g_scene_toggle && !g_scene.empty()){
+            render_scene(projection, model_view);
+        }
+        else if (draw_iso_mesh){
+            render_iso_mesh(projection, model_view, camera_location);
+        }
+        else {
+            // first hit modes write into the hit buffers, reading back the hits of the last frame
+            bool hit_cache = hit_cache_enabled();
+            bool deferred = deferred_shading_enabled();
+            bool hit_buffer = hit_cache || deferred;
+            unsigned hit_read = g_hit_buffer_index;
+            unsigned hit_write = 1 - g_hit_buffer_index;
+            bool use_hit_cache = hit_cache && hit_cache_usable(model_view, size);
+
+            // with only the light changed the hits are still current, just shade them again
+            bool ray_pass = !g_pause;
+            if (deferred && hit_cache_current(size) && model_view == g_hit_cache_model_view)
+                ray_pass = false;
+
+            if (ray_pass)
+                render_ray_entry_exit(projection, model_view, size);
+
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, g_ray_entry_buffer.get_color_texture(0));
+            glActiveTexture(GL_TEXTURE3);
+            glBindTexture(GL_TEXTURE_2D, g_ray_exit_buffer.get_color_texture(0));
+            glActiveTexture(GL_TEXTURE0);
+
+            glUseProgram(g_volume_program);
+
+            glUniform1i(glGetUniformLocation(g_volume_program, "volume_texture"), 0);
+            glUniform1i(glGetUniformLocation(g_volume_program, "transfer_texture"), 1);
+            glUniform1i(glGetUniformLocation(g_volume_program, "ray_entry_texture"), 2);
+            glUniform1i(glGetUniformLocation(g_volume_program, "ray_exit_texture"), 3);
+            glUniform1i(glGetUniformLocation(g_volume_program, "illumination_texture"), 7);
+            glUniform1i(glGetUniformLocation(g_volume_program, "occlusion_texture"), 8);
+
+            glUniform3fv(glGetUniformLocation(g_volume_program, "camera_location"), 1,
+                glm::value_ptr(camera_location));
+            glUniform1f(glGetUniformLocation(g_volume_program, "sampling_distance"), g_sampling_distance);
+            glUniform1f(glGetUniformLocation(g_volume_program, "sampling_distance_ref"), g_sampling_distance_ref);
+            glUniform1f(glGetUniformLocation(g_volume_program, "iso_value"), g_iso_value);
+            glUniform2fv(glGetUniformLocation(g_volume_program, "data_range"), 1,
+                glm::value_ptr(g_data_range));
+            glUniform1f(glGetUniformLocation(g_volume_program, "termination_alpha"),
+                g_early_termination ? g_termination_alpha : 2.0f);
+            glUniform4fv(glGetUniformLocation(g_volume_program, "transfer_max"), 1,
+                glm::value_ptr(g_early_termination && !labels_enabled() ? g_transfer_max : glm::vec4(2.0f)));
+            glUniform1f(glGetUniformLocation(g_volume_program, "step_count_max"),
+                glm::length(g_max_volume_bounds) / g_sampling_distance);
+            glUniform3fv(glGetUniformLocation(g_volume_program, "max_bounds"), 1,
+                glm::value_ptr(g_max_volume_bounds));
+            glUniform3iv(glGetUniformLocation(g_volume_program, "volume_dimensions"), 1,
+                glm::value_ptr(g_vol_dimensions));
+            glUniform3fv(glGetUniformLocation(g_volume_program, "roi_min"), 1,
+                glm::value_ptr(glm::min(g_roi_min, g_roi_max) * g_max_volume_bounds));
+            glUniform3fv(glGetUniformLocation(g_volume_program, "roi_max"), 1,
+                glm::value_ptr(glm::max(g_roi_min, g_roi_max) * g_max_volume_bounds));
+            set_clip_plane_uniforms(g_volume_program);
+            if (labels_enabled()){
+                glActiveTexture(GL_TEXTURE10);
+                glBindTexture(GL_TEXTURE_3D, g_label_texture);
+                glActiveTexture(GL_TEXTURE11);
+                glBindTexture(GL_TEXTURE_2D, g_label_transfer_texture);
+                glActiveTexture(GL_TEXTURE0);
+                glUniform1i(glGetUniformLocation(g_volume_program, "label_texture"), 10);
+                glUniform1i(glGetUniformLocation(g_volume_program, "label_transfer_texture"), 11);
+                glUniform1i(glGetUniformLocation(g_volume_program, "label_count"), (GLint)g_label_styles.size());
+            }
+            glUniform3fv(glGetUniformLocation(g_volume_program, "light_position"), 1,
+                glm::value_ptr(g_light_pos));
+            glUniform3fv(glGetUniformLocation(g_volume_program, "light_ambient_color"), 1,
+                glm::value_ptr(g_ambient_light_color));
+            glUniform3fv(glGetUniformLocation(g_volume_program, "light_diffuse_color"), 1,
+                glm::value_ptr(g_diffuse_light_color));
+            glUniform3fv(glGetUniformLocation(g_volume_program, "light_specular_color"), 1,
+                glm::value_ptr(g_specula_light_color));
+            glUniform1f(glGetUniformLocation(g_volume_program, "light_ref_coef"), g_ref_coef);
+
+            glUniformMatrix4fv(glGetUniformLocation(g_volume_program, "Projection"), 1, GL_FALSE,
+                glm::value_ptr(projection));
+            glUniformMatrix4fv(glGetUniformLocation(g_volume_program, "Modelview"), 1, GL_FALSE,
+                glm::value_ptr(model_view));
+            glUniformMatrix4fv(glGetUniformLocation(g_volume_program, "ModelviewProjectionInverse"), 1, GL_FALSE,
+                glm::value_ptr(glm::inverse(projection * model_view)));
+            glActiveTexture(GL_TEXTURE4);
+            glBindTexture(GL_TEXTURE_2D, hit_cache ? g_hit_buffers[hit_read].get_color_texture(2) : 0);
+            glActiveTexture(GL_TEXTURE0);
+            glUniform1i(glGetUniformLocation(g_volume_program, "previous_hit_texture"), 4);
+            glUniform1i(glGetUniformLocation(g_volume_program, "use_hit_cache"), use_hit_cache);
+            glUniform1i(glGetUniformLocation(g_volume_program, "hit_search_steps"), g_hit_search_steps);
+
+            Framebuffer* target = hit_buffer ? &g_hit_buffers[hit_write]
+                                : g_step_count_toggle ? &g_step_count_buffer : nullptr;
+
+            if (target && ray_pass){
+                // per-pixel step counts and hits go to float attachments next to the color
+                target->resize(size);
+                target->bind();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                const GLfloat no_data[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (unsigned i = 1; i != target->get_color_attachment_count(); ++i){
+                    glClearBufferfv(GL_COLOR, i, no_data);
+                    glDisablei(GL_BLEND, i);
+                }
+                g_screen_quad.draw();
+                for (unsigned i = 1; i != target->get_color_attachment_count(); ++i)
+                    glEnablei(GL_BLEND, i);
+                target->unbind();
+                glViewport(0, 0, size.x, size.y);
+
+                if (hit_buffer){
+                    g_hit_buffer_index = hit_write;
+                    g_hit_cache_valid = true;
+                    g_hit_cache_model_view = model_view;
+                    if (use_hit_cache)
+                        ++g_hit_cache_seeded_frames;
+                    else {
+                        g_hit_cache_march_model_view = model_view;
+                        g_hit_cache_seeded_frames = 0;
+                    }
+                    g_hit_cache_iso_value = g_iso_value;
+                    g_hit_cache_sampling_distance = g_sampling_distance;
+                    g_hit_cache_interpolation = g_bilinear_interpolation;
+                }
+
+                if (g_benchmark_active && g_step_count_toggle)
+                    finish_step_benchmark(*target);
+            }
+
+            // the latest hit buffer is shown even if the ray pass was skipped
+            Framebuffer const* shown = hit_buffer ? &g_hit_buffers[g_hit_buffer_index] : target;
+
+            if (shown && shown->get_size() == size){
+                if (deferred)
+                    render_deferred_shading(*shown, camera_location);
+                else {
+                    shown->blit_to_screen(0);
+                    glViewport(0, 0, size.x, size.y);
+                }
+            }
+            else if (!target && ray_pass)
+                g_screen_quad.draw();
+            glUseProgram(0);
+        }
+
+        // tiles and screenshots are read before the GUI is drawn over the frame
+        if (poster_tile){
+            if (g_readback.request(glm::ivec2(0), size, g_poster_tile))
+                ++g_poster_tile;
+        }
+        else if (export_frame){
+            // the frame is rendered again while the encoders are behind
+            if (g_export_writes.size() < g_export_max_frames_in_flight
+                && g_export_readback.request(glm::ivec2(0), size, g_export_frame))
+                ++g_export_frame;
+        }
+        else {
+            if (g_mpr_toggle)
+                render_mpr_views(size);
+
+            if (g_screenshot_requested && g_readback.request(glm::ivec2(0), size, -1))
+                g_screenshot_requested = false;
+
+            if (!g_control_frame_clients.empty() && g_control_readback.request(glm::ivec2(0), size, g_control_frame_id))
+                g_control_frame_reads[g_control_frame_id++].swap(g_control_frame_clients);
+
+            // with all pixel buffers in flight the GPU is behind, the frame is skipped
+            if (g_frame_ring.is_open()){
+                if (g_frame_ring_readback.request(glm::ivec2(0), size, g_frame_ring_id))
+                    g_frame_ring_times[g_frame_ring_id++] = Shared_frame_ring::get_timestamp();
+                else
+                    ++g_frame_ring_dropped;
+            }
+        }
 
         //IMGUI ROUTINE begin    
         ImGuiIO& io = ImGui::GetIO();
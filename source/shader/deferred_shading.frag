@@ -0,0 +1,89 @@
+#version 150
+#extension GL_ARB_shading_language_420pack : require
+#extension GL_ARB_explicit_attrib_location : require
+
+#define ENABLE_SHADOWING 0
+#define ENABLE_AMBIENT_OCCLUSION 0
+
+in vec2 frag_uv;
+
+layout(location = 0) out vec4 FragColor;
+
+uniform sampler3D volume_texture;
+uniform sampler2D albedo_texture;
+uniform sampler2D position_texture;
+uniform sampler2D normal_texture;
+uniform sampler3D occlusion_texture;
+
+uniform vec3    camera_location;
+uniform float   sampling_distance;
+uniform float   iso_value;
+uniform vec2    data_range;
+uniform vec3    max_bounds;
+
+uniform vec3    light_position;
+uniform vec3    light_ambient_color;
+uniform vec3    light_diffuse_color;
+uniform vec3    light_specular_color;
+uniform float   light_ref_coef;
+
+float
+get_sample_data(vec3 in_sampling_pos)
+{
+    vec3 obj_to_tex = vec3(1.0) / max_bounds;
+    float s = texture(volume_texture, in_sampling_pos * obj_to_tex).r;
+
+    // window to the data range found at load time
+    return clamp((s - data_range.x) / (data_range.y - data_range.x), 0.0, 1.0);
+}
+
+bool
+in_shadow(vec3 position, vec3 light_direction, float light_distance)
+{
+    // leave the volume box or reach the light, whichever comes first
+    vec3  t_far  = max(-position / light_direction, (max_bounds - position) / light_direction);
+    float t_exit = min(min(min(t_far.x, t_far.y), t_far.z), light_distance);
+
+    // start a few steps off the surface to not hit it again
+    for (float t = 4.0 * sampling_distance; t < t_exit; t += sampling_distance) {
+        if (get_sample_data(position + t * light_direction) >= iso_value)
+            return true;
+    }
+    return false;
+}
+
+void main()
+{
+    vec4 position = texture(position_texture, frag_uv);
+    if (position.a == 0.0)
+        discard;
+
+    vec3 albedo = texture(albedo_texture, frag_uv).rgb;
+    vec3 n      = texture(normal_texture, frag_uv).xyz;
+
+    // Blinn-Phong in object space, like the ray casting shader
+    vec3 color = albedo * light_ambient_color;
+#if ENABLE_AMBIENT_OCCLUSION == 1
+    color *= texture(occlusion_texture, position.xyz / max_bounds).r;
+#endif
+
+    if (dot(n, n) > 0.0) {
+        n = normalize(n);
+        vec3  l = light_position - position.xyz;
+        float light_distance = length(l);
+        l /= light_distance;
+        vec3  v = normalize(camera_location - position.xyz);
+        vec3  h = normalize(l + v);
+
+        float lit = 1.0;
+#if ENABLE_SHADOWING == 1
+        if (in_shadow(position.xyz, l, light_distance))
+            lit = 0.0;
+#endif
+
+        color += lit * (albedo * light_diffuse_color * max(dot(n, l), 0.0)
+                      + light_specular_color * pow(max(dot(n, h), 0.0), light_ref_coef));
+    }
+
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,50 @@
+#version 150
+#extension GL_ARB_shading_language_420pack : require
+#extension GL_ARB_explicit_attrib_location : require
+
+#define MAX_CLIP_PLANES 8
+
+in vec3 object_position;
+in vec3 object_normal;
+
+layout(location = 0) out vec4 FragColor;
+
+uniform vec3    camera_location;
+uniform vec3    light_position;
+uniform vec3    light_ambient_color;
+uniform vec3    light_diffuse_color;
+uniform vec3    light_specular_color;
+uniform float   light_ref_coef;
+uniform vec3    roi_min;
+uniform vec3    roi_max;
+uniform vec4    clip_planes[MAX_CLIP_PLANES];
+uniform int     clip_plane_count;
+
+void main()
+{
+    // bricks at the border of the region of interest reach beyond it
+    if (any(lessThan(object_position, roi_min)) || any(greaterThan(object_position, roi_max)))
+        discard;
+
+    for (int i = 0; i < clip_plane_count; ++i) {
+        if (dot(clip_planes[i].xyz, object_position) > clip_planes[i].w)
+            discard;
+    }
+
+    // Blinn-Phong in object space, like the ray casting shader
+    vec3 n = normalize(object_normal);
+    vec3 l = normalize(light_position - object_position);
+    vec3 v = normalize(camera_location - object_position);
+
+    // the mesh is not closed, light back faces as well
+    if (dot(n, v) < 0.0)
+        n = -n;
+
+    vec3 h = normalize(l + v);
+
+    vec3 color = light_ambient_color
+               + light_diffuse_color * max(dot(n, l), 0.0)
+               + light_specular_color * pow(max(dot(n, h), 0.0), light_ref_coef);
+
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 150
+#extension GL_ARB_shading_language_420pack : require
+#extension GL_ARB_explicit_attrib_location : require
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+uniform mat4 Projection;
+uniform mat4 Modelview;
+
+out vec3 object_position;
+out vec3 object_normal;
+
+void main()
+{
+    object_position = position;
+    object_normal   = normal;
+    gl_Position = Projection * Modelview * vec4(position, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 150
+#extension GL_ARB_shading_language_420pack : require
+#extension GL_ARB_explicit_attrib_location : require
+
+in vec3 object_position;
+
+layout(location = 0) out vec4 FragColor;
+
+void main()
+{
+    // alpha marks pixels covered by the proxy geometry
+    FragColor = vec4(object_position, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 150
+#extension GL_ARB_shading_language_420pack : require
+#extension GL_ARB_explicit_attrib_location : require
+
+layout(location = 0) in vec3 position;
+
+uniform mat4 Projection;
+uniform mat4 Modelview;
+
+out vec3 object_position;
+
+void main()
+{
+    object_position = position;
+    gl_Position = Projection * Modelview * vec4(position, 1.0);
+}
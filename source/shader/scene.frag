@@ -0,0 +1,132 @@
+#version 150
+#extension GL_ARB_shading_language_420pack : require
+#extension GL_ARB_explicit_attrib_location : require
+
+#define MAX_SCENE_VOLUMES 4
+
+in vec2 frag_uv;
+
+layout(location = 0) out vec4 FragColor;
+
+uniform mat4 ModelviewProjectionInverse;
+
+// samplers cannot be indexed dynamically in GLSL 1.50
+uniform sampler3D scene_volume_0;
+uniform sampler3D scene_volume_1;
+uniform sampler3D scene_volume_2;
+uniform sampler3D scene_volume_3;
+uniform sampler2D scene_transfer_texture;
+
+uniform float   sampling_distance;
+uniform float   termination_alpha;
+uniform int     volume_count;
+uniform mat4    volume_inverse[MAX_SCENE_VOLUMES];
+uniform vec3    volume_bounds[MAX_SCENE_VOLUMES];
+uniform vec2    volume_range[MAX_SCENE_VOLUMES];
+
+float
+get_sample_data(int volume, vec3 in_sampling_pos)
+{
+    vec3 tex_pos = in_sampling_pos / volume_bounds[volume];
+    float s = 0.0;
+    if (volume == 0)
+        s = texture(scene_volume_0, tex_pos).r;
+    else if (volume == 1)
+        s = texture(scene_volume_1, tex_pos).r;
+    else if (volume == 2)
+        s = texture(scene_volume_2, tex_pos).r;
+    else
+        s = texture(scene_volume_3, tex_pos).r;
+
+    // window to the data range found at load time
+    return clamp((s - volume_range[volume].x) / (volume_range[volume].y - volume_range[volume].x), 0.0, 1.0);
+}
+
+void main()
+{
+    /// Scene space ray from the near to the far plane
+    vec4 near_point = ModelviewProjectionInverse * vec4(frag_uv * 2.0 - 1.0, -1.0, 1.0);
+    vec4 far_point  = ModelviewProjectionInverse * vec4(frag_uv * 2.0 - 1.0,  1.0, 1.0);
+    near_point /= near_point.w;
+    far_point  /= far_point.w;
+
+    vec3  ray_direction = normalize(far_point.xyz - near_point.xyz);
+    float ray_length    = length(far_point.xyz - near_point.xyz);
+
+    /// Ray in the object space of every volume, parameterized by the scene distance
+    vec3  origin[MAX_SCENE_VOLUMES];
+    vec3  direction[MAX_SCENE_VOLUMES];
+    float t_enter[MAX_SCENE_VOLUMES];
+    float t_exit[MAX_SCENE_VOLUMES];
+    float t_begin = ray_length;
+    float t_end   = 0.0;
+
+    for (int i = 0; i < volume_count; ++i) {
+        origin[i]    = (volume_inverse[i] * vec4(near_point.xyz, 1.0)).xyz;
+        direction[i] = (volume_inverse[i] * vec4(ray_direction, 0.0)).xyz;
+
+        vec3 inv_direction = 1.0 / mix(direction[i], vec3(1e-8), equal(direction[i], vec3(0.0)));
+        vec3 t_low  = -origin[i] * inv_direction;
+        vec3 t_high = (volume_bounds[i] - origin[i]) * inv_direction;
+        vec3 t_near = min(t_low, t_high);
+        vec3 t_far  = max(t_low, t_high);
+
+        t_enter[i] = max(max(t_near.x, t_near.y), max(t_near.z, 0.0));
+        t_exit[i]  = min(min(t_far.x, t_far.y), min(t_far.z, ray_length));
+
+        if (t_enter[i] < t_exit[i]) {
+            t_begin = min(t_begin, t_enter[i]);
+            t_end   = max(t_end, t_exit[i]);
+        }
+    }
+
+    if (t_end <= t_begin)
+        discard;
+
+    /// Init color of fragment
+    vec4 dst = vec4(0.0, 0.0, 0.0, 0.0);
+
+    /// One loop over the union of all intervals; samples at the same depth are
+    /// merged before compositing so overlapping volumes interleave correctly
+    float t = t_begin;
+    while (t < t_end && dst.a < termination_alpha)
+    {
+        vec3  color_sum     = vec3(0.0);
+        float alpha_sum     = 0.0;
+        float transparency  = 1.0;
+        float next_enter    = t_end;
+        bool  inside        = false;
+
+        for (int i = 0; i < volume_count; ++i) {
+            if (t >= t_enter[i] && t <= t_exit[i]) {
+                float s = get_sample_data(i, origin[i] + direction[i] * t);
+                vec4 color = texture(scene_transfer_texture, vec2(s, (float(i) + 0.5) / float(volume_count)));
+
+                color_sum    += color.a * color.rgb;
+                alpha_sum    += color.a;
+                transparency *= 1.0 - color.a;
+                inside        = true;
+            }
+            else if (t < t_enter[i] && t_enter[i] < t_exit[i])
+                next_enter = min(next_enter, t_enter[i]);
+        }
+
+        // no volume at this depth, jump to the next entry
+        if (!inside) {
+            t = next_enter;
+            continue;
+        }
+
+        // the merged sample keeps the opacity of all volumes, colored by their share
+        float alpha = 1.0 - transparency;
+        if (alpha_sum > 0.0) {
+            dst.rgb += (1.0 - dst.a) * alpha * color_sum / alpha_sum;
+            dst.a   += (1.0 - dst.a) * alpha;
+        }
+
+        t += sampling_distance;
+    }
+
+    // return the calculated color value
+    FragColor = dst;
+}
@@ -0,0 +1,22 @@
+#version 150
+#extension GL_ARB_shading_language_420pack : require
+#extension GL_ARB_explicit_attrib_location : require
+
+in vec2 frag_uv;
+
+layout(location = 0) out vec4 FragColor;
+
+uniform sampler2D slice_texture;
+uniform vec3      slice_color;
+
+void main()
+{
+    // thin frame in the color of the slice orientation
+    vec2 border = min(frag_uv, vec2(1.0) - frag_uv);
+    if (min(border.x, border.y) < 0.01) {
+        FragColor = vec4(slice_color, 1.0);
+        return;
+    }
+
+    FragColor = vec4(vec3(texture(slice_texture, frag_uv).r), 1.0);
+}
@@ -2,27 +2,55 @@
 #extension GL_ARB_shading_language_420pack : require
 #extension GL_ARB_explicit_attrib_location : require
 
-#define TASK 21  // 21 22 31 32 33 4 5
+#define TASK 21  // 21 22 23 31 32 33 4 5
 #define ENABLE_OPACITY_CORRECTION 0
 #define ENABLE_LIGHTNING 0
 #define ENABLE_SHADOWING 0
+#define ENABLE_STEP_COUNT 0
+#define ENABLE_HIT_CACHE 0
+#define ENABLE_DEFERRED_SHADING 0
+#define ENABLE_AMBIENT_OCCLUSION 0
+#define MAX_CLIP_PLANES 8
+#define ENABLE_LABELS 0
 
-in vec3 ray_entry_position;
+in vec2 frag_uv;
 
 layout(location = 0) out vec4 FragColor;
+layout(location = 1) out float StepCount;
+layout(location = 2) out vec4 HitPosition;
+layout(location = 3) out vec4 HitNormal;
 
 uniform mat4 Modelview;
+uniform mat4 ModelviewProjectionInverse;
 
 uniform sampler3D volume_texture;
 uniform sampler2D transfer_texture;
+uniform sampler2D ray_entry_texture;
+uniform sampler2D ray_exit_texture;
+uniform sampler2D previous_hit_texture;
+uniform sampler3D illumination_texture;
+uniform sampler3D occlusion_texture;
+uniform usampler3D label_texture;
+uniform sampler2D label_transfer_texture;
 
 
 uniform vec3    camera_location;
 uniform float   sampling_distance;
 uniform float   sampling_distance_ref;
 uniform float   iso_value;
+uniform float   termination_alpha;
+uniform vec4    transfer_max;
+uniform float   step_count_max;
+uniform vec2    data_range;
 uniform vec3    max_bounds;
 uniform ivec3   volume_dimensions;
+uniform vec3    roi_min;
+uniform vec3    roi_max;
+uniform vec4    clip_planes[MAX_CLIP_PLANES];
+uniform int     clip_plane_count;
+uniform int     label_count;
+uniform bool    use_hit_cache;
+uniform int     hit_search_steps;
 
 uniform vec3    light_position;
 uniform vec3    light_ambient_color;
@@ -31,6 +59,21 @@ uniform vec3    light_specular_color;
 uniform float   light_ref_coef;
 
 
+#if ENABLE_STEP_COUNT == 1
+int ray_step_count = 0;
+#define COUNT_STEP ++ray_step_count
+#else
+#define COUNT_STEP
+#endif
+
+vec3
+heat_map(float t)
+{
+    // blue -> cyan -> green -> yellow -> red
+    t = clamp(t, 0.0, 1.0) * 4.0;
+    return clamp(vec3(t - 2.0, min(t, 4.0 - t), 2.0 - t), 0.0, 1.0);
+}
+
 bool
 inside_volume_bounds(const in vec3 sampling_position)
 {
@@ -43,22 +86,123 @@ float
 get_sample_data(vec3 in_sampling_pos){
     
     vec3 obj_to_tex = vec3(1.0) / max_bounds;
-    return texture(volume_texture, in_sampling_pos * obj_to_tex).r;
+    float s = texture(volume_texture, in_sampling_pos * obj_to_tex).r;
+
+    // window to the data range found at load time
+    return clamp((s - data_range.x) / (data_range.y - data_range.x), 0.0, 1.0);
+
+}
+
+/// Transfer function of the label at the position, one row per label
+vec4
+get_transfer_color(vec3 in_sampling_pos, float s)
+{
+#if ENABLE_LABELS == 1
+    uint label = texture(label_texture, in_sampling_pos / max_bounds).r;
+    return texture(label_transfer_texture, vec2(s, (float(label) + 0.5) / float(label_count)));
+#else
+    return texture(transfer_texture, vec2(s, s));
+#endif
+}
 
+vec3
+get_gradient(vec3 in_sampling_pos)
+{
+    // central differences with one voxel spacing
+    vec3 h = max_bounds / vec3(volume_dimensions);
+    return vec3(get_sample_data(in_sampling_pos + vec3(h.x, 0.0, 0.0)) - get_sample_data(in_sampling_pos - vec3(h.x, 0.0, 0.0)),
+                get_sample_data(in_sampling_pos + vec3(0.0, h.y, 0.0)) - get_sample_data(in_sampling_pos - vec3(0.0, h.y, 0.0)),
+                get_sample_data(in_sampling_pos + vec3(0.0, 0.0, h.z)) - get_sample_data(in_sampling_pos - vec3(0.0, 0.0, h.z)))
+           / (2.0 * h);
+}
+
+vec3
+binary_search(vec3 outside_pos, vec3 inside_pos)
+{
+    // bisect the step that crossed the iso value, the interval halves each iteration
+    for (int i = 0; i < 8; ++i) {
+        vec3 mid_pos = 0.5 * (outside_pos + inside_pos);
+        COUNT_STEP;
+        if (get_sample_data(mid_pos) >= iso_value)
+            inside_pos = mid_pos;
+        else
+            outside_pos = mid_pos;
+    }
+    return 0.5 * (outside_pos + inside_pos);
 }
 
 void main()
 {
+    /// Ray exit from the farthest back face of the proxy geometry
+    vec4 ray_exit = texture(ray_exit_texture, frag_uv);
+    if (ray_exit.a == 0.0)
+        discard;
+
+    /// Ray entry from the nearest front face, capped by the near plane
+    /// when the camera is inside the volume and front faces are clipped
+    vec4 near_point = ModelviewProjectionInverse * vec4(frag_uv * 2.0 - 1.0, -1.0, 1.0);
+    near_point /= near_point.w;
+
+    vec3 ray_entry_position = texture(ray_entry_texture, frag_uv).xyz;
+    if (inside_volume_bounds(near_point.xyz))
+        ray_entry_position = near_point.xyz;
+
+    vec3 ray_exit_position  = ray_exit.xyz;
+
     /// One step trough the volume
-    vec3 ray_increment      = normalize(ray_entry_position - camera_location) * sampling_distance;
+    vec3 ray_direction      = normalize(ray_exit_position - camera_location);
+
+    /// Clip the ray segment against the region of interest box
+    vec3 inv_direction = 1.0 / mix(ray_direction, vec3(1e-8), equal(ray_direction, vec3(0.0)));
+    vec3 t_roi_min     = (roi_min - ray_entry_position) * inv_direction;
+    vec3 t_roi_max     = (roi_max - ray_entry_position) * inv_direction;
+    vec3 t_roi_near    = min(t_roi_min, t_roi_max);
+    vec3 t_roi_far     = max(t_roi_min, t_roi_max);
+    float t_enter      = max(max(t_roi_near.x, t_roi_near.y), max(t_roi_near.z, 0.0));
+    float t_exit       = min(min(t_roi_far.x, t_roi_far.y),
+                             min(t_roi_far.z, dot(ray_exit_position - ray_entry_position, ray_direction)));
+
+    /// Clip planes remove the side dot(xyz, p) > w, the interval ends where the ray crosses them
+    for (int i = 0; i < clip_plane_count; ++i) {
+        float distance  = dot(clip_planes[i].xyz, ray_entry_position) - clip_planes[i].w;
+        float approach  = dot(clip_planes[i].xyz, ray_direction);
+        if (abs(approach) < 1e-8) {
+            if (distance > 0.0)
+                discard;
+            continue;
+        }
+
+        float t_plane = -distance / approach;
+        if (approach > 0.0)
+            t_exit = min(t_exit, t_plane);
+        else
+            t_enter = max(t_enter, t_plane);
+    }
+
+    if (t_exit <= t_enter)
+        discard;
+
+    ray_exit_position  = ray_entry_position + ray_direction * t_exit;
+    ray_entry_position = ray_entry_position + ray_direction * t_enter;
+
+    vec3 ray_increment      = ray_direction * sampling_distance;
     /// Position in Volume
-    vec3 sampling_pos       = ray_entry_position + ray_increment; // test, increment just to be sure we are in the volume
+    vec3 sampling_pos       = ray_entry_position;
+
+    /// Number of steps between entry and exit, replaces per step bounds tests
+    int  ray_steps          = int(dot(ray_exit_position - ray_entry_position, ray_direction)
+                                  / sampling_distance);
+    int  ray_step           = 0;
 
     /// Init color of fragment
     vec4 dst = vec4(0.0, 0.0, 0.0, 0.0);
 
     /// check if we are inside volume
-    bool inside_volume = inside_volume_bounds(sampling_pos);
+    bool inside_volume = ray_steps > 0;
+
+    /// First hit of the ray, written to the hit buffer for the next frame
+    bool hit = false;
+    vec3 hit_position = vec3(0.0);
 
 #if TASK == 21
     vec4 max_val = vec4(0.0, 0.0, 0.0, 0.0);
@@ -72,7 +216,7 @@ void main()
         float s = get_sample_data(sampling_pos);
                 
         // apply the transfer functions to retrieve color and opacity
-        vec4 color = texture(transfer_texture, vec2(s, s));
+        vec4 color = get_transfer_color(sampling_pos, s);
            
         // this is the example for maximum intensity projection
         max_val.r = max(color.r, max_val.r);
@@ -82,36 +226,109 @@ void main()
         
         // increment the ray sampling position
         sampling_pos  += ray_increment;
+        COUNT_STEP;
 
         // update the loop termination condition
-        inside_volume  = inside_volume_bounds(sampling_pos);
+        // the maximum cannot grow beyond the maximum of the transfer function
+        inside_volume  = ++ray_step < ray_steps
+                      && any(lessThan(max_val, transfer_max));
     }
 
     dst = max_val;
 #endif 
     
 #if TASK == 22
+    vec4 sum_val = vec4(0.0, 0.0, 0.0, 0.0);
+    int  sum_count = 0;
 
     // the traversal loop,
     // termination when the sampling position is outside volume boundarys
-    // another termination condition for early ray termination is added
     while (inside_volume)
     {      
         // get sample
         float s = get_sample_data(sampling_pos);
 
-        // dummy code
-        dst = vec4(sampling_pos, 1.0);
+        // apply the transfer functions to retrieve color and opacity
+        vec4 color = get_transfer_color(sampling_pos, s);
+
+        sum_val += color;
+        ++sum_count;
         
         // increment the ray sampling position
         sampling_pos  += ray_increment;
+        COUNT_STEP;
+
+        // update the loop termination condition
+        inside_volume  = ++ray_step < ray_steps;
+    }
+
+    if (sum_count > 0)
+        dst = sum_val / float(sum_count);
+#endif
+
+#if TASK == 23
+    vec4 min_val = vec4(1.0, 1.0, 1.0, 1.0);
+
+    // the traversal loop,
+    // termination when the sampling position is outside volume boundarys
+    while (inside_volume)
+    {      
+        // get sample
+        float s = get_sample_data(sampling_pos);
+
+        // apply the transfer functions to retrieve color and opacity
+        vec4 color = get_transfer_color(sampling_pos, s);
+
+        min_val = min(color, min_val);
+
+        // increment the ray sampling position
+        sampling_pos  += ray_increment;
+        COUNT_STEP;
 
         // update the loop termination condition
-        inside_volume  = inside_volume_bounds(sampling_pos);
+        inside_volume  = ++ray_step < ray_steps;
     }
+
+    // rays that took no sample stay transparent
+    if (ray_step > 0)
+        dst = min_val;
 #endif
     
 #if TASK == 31 || TASK == 32  
+    /// Last sample in front of the surface, the binary search starts between this and the hit
+    vec3 previous_pos = sampling_pos;
+
+#if ENABLE_HIT_CACHE == 1
+    // the camera moved only a little, so the hit of the last frame is close to
+    // the current ray: project it onto the ray and search a short window around it
+    vec4 cached_hit = texture(previous_hit_texture, frag_uv);
+    if (use_hit_cache && cached_hit.a > 0.0) {
+        float cached_t = dot(cached_hit.xyz - ray_entry_position, ray_direction);
+        int   first    = max(int(cached_t / sampling_distance) - hit_search_steps, 0);
+        int   last     = min(first + 2 * hit_search_steps, ray_steps);
+        vec3  pos      = ray_entry_position + float(first) * ray_increment;
+        COUNT_STEP;
+
+        // a window starting inside the surface may have skipped an earlier hit
+        if (first < last && get_sample_data(pos) < iso_value) {
+            for (int i = first + 1; i <= last; ++i) {
+                vec3 next_pos = pos + ray_increment;
+                COUNT_STEP;
+                if (get_sample_data(next_pos) >= iso_value) {
+                    hit          = true;
+                    previous_pos = pos;
+                    sampling_pos = next_pos;
+                    break;
+                }
+                pos = next_pos;
+            }
+        }
+
+        // no hit in the window, fall back to the full march below
+        inside_volume = inside_volume && !hit;
+    }
+#endif
+
     // the traversal loop,
     // termination when the sampling position is outside volume boundarys
     // another termination condition for early ray termination is added
@@ -119,24 +336,44 @@ void main()
     {
         // get sample
         float s = get_sample_data(sampling_pos);
+        COUNT_STEP;
 
-        // dummy code
-        dst = vec4(light_diffuse_color, 1.0);
+        // the first hit terminates the ray
+        if (s >= iso_value) {
+            hit = true;
+            break;
+        }
 
         // increment the ray sampling position
+        previous_pos  = sampling_pos;
         sampling_pos += ray_increment;
+
+        // update the loop termination condition
+        inside_volume = ++ray_step < ray_steps;
+    }
+
+    if (hit) {
+        hit_position = sampling_pos;
+
 #if TASK == 32 // Binary Search
-        IMPLEMENT;
+        // the entry sample has no predecessor outside the surface
+        if (previous_pos != sampling_pos)
+            hit_position = binary_search(previous_pos, sampling_pos);
 #endif
+
+#if ENABLE_DEFERRED_SHADING == 1
+        // albedo only, the deferred pass lights the hit buffer once per pixel
+        dst = vec4(get_transfer_color(hit_position, iso_value).rgb, 1.0);
+#else
+        dst = vec4(light_diffuse_color, 1.0);
+
 #if ENABLE_LIGHTNING == 1 // Add Shading
         IMPLEMENTLIGHT;
 #if ENABLE_SHADOWING == 1 // Add Shadows
         IMPLEMENTSHADOW;
 #endif
 #endif
-
-        // update the loop termination condition
-        inside_volume = inside_volume_bounds(sampling_pos);
+#endif
     }
 #endif 
 
@@ -152,21 +389,46 @@ void main()
 #else
         float s = get_sample_data(sampling_pos);
 #endif
-        // dummy code
-        dst = vec4(light_specular_color, 1.0);
-
-        // increment the ray sampling position
-        sampling_pos += ray_increment;
+        vec4 color = get_transfer_color(sampling_pos, s);
 
 #if ENABLE_LIGHTNING == 1 // Add Shading
         IMPLEMENT;
 #endif
+#if ENABLE_SHADOWING == 1 // Light transmittance from the precomputed illumination volume
+        color.rgb *= texture(illumination_texture, sampling_pos / max_bounds).r;
+#endif
+#if ENABLE_AMBIENT_OCCLUSION == 1 // Ambient visibility from the precomputed occlusion volume
+        color.rgb *= texture(occlusion_texture, sampling_pos / max_bounds).r;
+#endif
+
+        // front-to-back compositing
+        dst.rgb += (1.0 - dst.a) * color.a * color.rgb;
+        dst.a   += (1.0 - dst.a) * color.a;
+
+        // increment the ray sampling position
+        sampling_pos += ray_increment;
+        COUNT_STEP;
 
         // update the loop termination condition
-        inside_volume = inside_volume_bounds(sampling_pos);
+        // early ray termination once the accumulated opacity passes the cutoff
+        inside_volume = ++ray_step < ray_steps
+                     && dst.a < termination_alpha;
     }
 #endif 
 
     // return the calculated color value
     FragColor = dst;
+
+#if ENABLE_STEP_COUNT == 1
+    FragColor = vec4(heat_map(float(ray_step_count) / step_count_max), 1.0);
+    StepCount = float(ray_step_count);
+#endif
+
+#if ENABLE_HIT_CACHE == 1 || ENABLE_DEFERRED_SHADING == 1
+    // hit position and gradient normal, alpha marks pixels whose ray hit the surface;
+    // the cache seeds the next frame from them, deferred shading lights them
+    vec3 hit_gradient = hit ? get_gradient(hit_position) : vec3(0.0);
+    HitPosition = vec4(hit_position, hit ? 1.0 : 0.0);
+    HitNormal   = vec4(dot(hit_gradient, hit_gradient) > 0.0 ? -normalize(hit_gradient) : vec3(0.0), 0.0);
+#endif
 }
@@ -8,13 +8,11 @@ layout(location = 1) in vec2 texCoord;
 uniform mat4 Projection;
 uniform mat4 Modelview;
 
-out vec3 ray_entry_position;
 out vec2 frag_uv;
-out vec4 o_color;
 
 void main()
 {
-    ray_entry_position = position;
-    vec4 Position = vec4(position, 1.0);
-    gl_Position = Projection * Modelview * Position;
+    // full screen quad, rays are set up from the entry and exit textures
+    frag_uv = texCoord;
+    gl_Position = vec4(position.xy, 0.0, 1.0);
 }
@@ -0,0 +1,84 @@
+#include <UnitTest++.h>
+
+#include "iso_surface.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace {
+
+// distance from the center falling from 255 to 0, so the iso surface is a sphere
+volume_data_type make_sphere(glm::ivec3 const& dimensions, float radius)
+{
+  glm::vec3 center = glm::vec3(dimensions - 1) * 0.5f;
+  volume_data_type data(size_t(dimensions.x) * dimensions.y * dimensions.z);
+  for (int z = 0; z != dimensions.z; ++z)
+    for (int y = 0; y != dimensions.y; ++y)
+      for (int x = 0; x != dimensions.x; ++x) {
+        float distance = glm::length(glm::vec3(x, y, z) - center);
+        float value = std::max(0.0f, 255.0f * (1.0f - 0.5f * distance / radius));
+        data[x + dimensions.x * (y + size_t(dimensions.y) * z)] = (unsigned char)value;
+      }
+  return data;
+}
+
+} // namespace
+
+SUITE(Iso_surface_extractor)
+{
+  // several brick layers, so the sphere crosses the seams between z chunks
+  TEST(SphereIsClosedAcrossChunks)
+  {
+    glm::ivec3 dimensions(32, 32, 40);
+    volume_data_type data = make_sphere(dimensions, 12.0f);
+
+    Iso_surface_extractor extractor;
+    extractor.set_volume(data, dimensions, 1, glm::vec2(0.0f, 1.0f), glm::vec3(1.0f), 8);
+    // between two sample values, so no vertex sits on a voxel
+    Iso_mesh mesh = extractor.extract(127.5f / 255.0f);
+
+    CHECK(!mesh.indices.empty());
+    CHECK_EQUAL(0u, mesh.indices.size() % 3);
+    CHECK_EQUAL(mesh.positions.size(), mesh.normals.size());
+
+    // a vertex duplicated on a seam would be another index at the same position
+    std::set<std::pair<float, std::pair<float, float> > > positions;
+    for (unsigned i = 0; i != mesh.positions.size(); ++i) {
+      glm::vec3 const& p = mesh.positions[i];
+      positions.insert(std::make_pair(p.x, std::make_pair(p.y, p.z)));
+    }
+    CHECK_EQUAL(mesh.positions.size(), positions.size());
+
+    // closed: every edge is shared by exactly two triangles, once in each direction
+    std::map<std::pair<unsigned, unsigned>, int> edges;
+    for (unsigned t = 0; t + 2 < mesh.indices.size(); t += 3) {
+      for (unsigned e = 0; e != 3; ++e) {
+        unsigned a = mesh.indices[t + e];
+        unsigned b = mesh.indices[t + (e + 1) % 3];
+        CHECK(a < mesh.positions.size() && b < mesh.positions.size());
+        edges[std::make_pair(a, b)] += 1;
+      }
+    }
+    int open_edges = 0;
+    for (std::map<std::pair<unsigned, unsigned>, int>::const_iterator e = edges.begin(); e != edges.end(); ++e) {
+      std::map<std::pair<unsigned, unsigned>, int>::const_iterator twin = edges.find(std::make_pair(e->first.second, e->first.first));
+      if (e->second != 1 || twin == edges.end() || twin->second != 1)
+        ++open_edges;
+    }
+    CHECK_EQUAL(0, open_edges);
+  }
+
+  TEST(NoSurfaceOutsideDataRange)
+  {
+    glm::ivec3 dimensions(16, 16, 16);
+    volume_data_type data = make_sphere(dimensions, 4.0f);
+
+    Iso_surface_extractor extractor;
+    extractor.set_volume(data, dimensions, 1, glm::vec2(0.0f, 1.0f), glm::vec3(1.0f), 8);
+    CHECK(extractor.extract(1.5f).indices.empty());
+  }
+}
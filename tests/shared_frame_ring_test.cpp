@@ -0,0 +1,118 @@
+#include <UnitTest++.h>
+
+#include "shared_frame_ring.hpp"
+
+#include <cstring>
+
+namespace {
+
+const char* ring_name = "/scivis_frame_ring_test";
+
+// fills the next slot with value and publishes it as frame_id
+bool write_frame(Shared_frame_ring& ring, std::uint64_t frame_id, unsigned char value)
+{
+  unsigned char* pixels = ring.begin_write();
+  if (!pixels)
+    return false;
+  std::memset(pixels, value, 2 * 2 * 4);
+  ring.end_write(frame_id, frame_id * 10, glm::ivec2(2, 2), 2 * 2 * 4);
+  return true;
+}
+
+// the oldest frame must be frame_id holding value
+void check_read_frame(Shared_frame_ring& ring, std::uint64_t frame_id, unsigned char value)
+{
+  Shared_frame_header const* frame = ring.acquire();
+  CHECK(frame != 0);
+  if (!frame)
+    return;
+  CHECK_EQUAL(frame_id, frame->frame_id);
+  CHECK_EQUAL(frame_id * 10, frame->timestamp);
+  CHECK_EQUAL(2u, frame->width);
+  CHECK_EQUAL(2u, frame->height);
+  CHECK_EQUAL(16u, frame->bytes);
+  CHECK_EQUAL(unsigned(Shared_frame_ring::rgba8_bottom_up), frame->format);
+  CHECK_EQUAL(int(value), int(ring.get_pixels(frame)[0]));
+  CHECK_EQUAL(int(value), int(ring.get_pixels(frame)[15]));
+  ring.release();
+}
+
+} // namespace
+
+SUITE(Shared_frame_ring)
+{
+  TEST(ConsumerSeesPublishedFrames)
+  {
+    Shared_frame_ring producer;
+    CHECK(producer.create(ring_name, 3, 64));
+    CHECK_EQUAL(64u, producer.get_pixel_capacity());
+
+    Shared_frame_ring consumer;
+    CHECK(consumer.open(ring_name));
+    CHECK(!consumer.is_closed());
+    CHECK(consumer.acquire() == 0);
+
+    CHECK(write_frame(producer, 1, 11));
+    CHECK(write_frame(producer, 2, 22));
+    CHECK_EQUAL(2u, consumer.get_pending_count());
+    check_read_frame(consumer, 1, 11);
+    check_read_frame(consumer, 2, 22);
+    CHECK(consumer.acquire() == 0);
+    CHECK_EQUAL(0u, consumer.get_pending_count());
+  }
+
+  // the producer skips frames instead of overwriting unread ones
+  TEST(FullRingSkipsFrames)
+  {
+    Shared_frame_ring producer;
+    CHECK(producer.create(ring_name, 2, 64));
+    Shared_frame_ring consumer;
+    CHECK(consumer.open(ring_name));
+
+    CHECK(write_frame(producer, 1, 11));
+    CHECK(write_frame(producer, 2, 22));
+    CHECK(!write_frame(producer, 3, 33));
+    CHECK_EQUAL(2u, consumer.get_pending_count());
+
+    check_read_frame(consumer, 1, 11);
+    CHECK(write_frame(producer, 4, 44));
+    check_read_frame(consumer, 2, 22);
+    check_read_frame(consumer, 4, 44);
+  }
+
+  // indices keep growing while the slots are reused in turn
+  TEST(IndicesWrapAroundTheSlots)
+  {
+    Shared_frame_ring producer;
+    CHECK(producer.create(ring_name, 3, 64));
+    Shared_frame_ring consumer;
+    CHECK(consumer.open(ring_name));
+
+    for (std::uint64_t frame = 1; frame != 11; ++frame) {
+      CHECK(write_frame(producer, frame, (unsigned char)frame));
+      if (frame % 2 == 0) {
+        check_read_frame(consumer, frame - 1, (unsigned char)(frame - 1));
+        check_read_frame(consumer, frame, (unsigned char)frame);
+      }
+    }
+    CHECK_EQUAL(0u, consumer.get_pending_count());
+  }
+
+  TEST(ClosedAfterFree)
+  {
+    Shared_frame_ring producer;
+    CHECK(producer.create(ring_name, 2, 64));
+    Shared_frame_ring consumer;
+    CHECK(consumer.open(ring_name));
+    CHECK(write_frame(producer, 1, 11));
+
+    producer.free();
+    CHECK(!producer.is_open());
+    CHECK(consumer.is_closed());
+    // frames published before stay readable
+    check_read_frame(consumer, 1, 11);
+
+    Shared_frame_ring late;
+    CHECK(!late.open(ring_name));
+  }
+}
@@ -0,0 +1,85 @@
+#include <UnitTest++.h>
+
+#include "brick_grid.hpp"
+#include "span_space_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// smooth waves plus a flat region, sizes that are no multiple of the brick size
+volume_data_type make_waves(glm::ivec3 const& dimensions)
+{
+  volume_data_type data(size_t(dimensions.x) * dimensions.y * dimensions.z);
+  for (int z = 0; z != dimensions.z; ++z)
+    for (int y = 0; y != dimensions.y; ++y)
+      for (int x = 0; x != dimensions.x; ++x) {
+        float value = 127.5f + 127.5f * std::sin(x * 0.31f) * std::cos(y * 0.23f + z * 0.17f);
+        if (x < 10 && y < 10)
+          value = 42.0f;
+        data[x + dimensions.x * (y + size_t(dimensions.y) * z)] = (unsigned char)value;
+      }
+  return data;
+}
+
+std::vector<unsigned> scan_bricks(Brick_grid const& grid, float value)
+{
+  glm::ivec3 count = grid.get_brick_count();
+  std::vector<unsigned> bricks;
+  for (unsigned b = 0; b != unsigned(count.x * count.y * count.z); ++b) {
+    if (grid.get_min(b) <= value && value <= grid.get_max(b))
+      bricks.push_back(b);
+  }
+  return bricks;
+}
+
+void check_against_scan(glm::vec2 const& data_range)
+{
+  glm::ivec3 dimensions(37, 29, 21);
+  volume_data_type data = make_waves(dimensions);
+
+  Brick_grid grid;
+  grid.build(data, dimensions, 1, data_range, 8);
+  Span_space_index index;
+  index.build(grid);
+
+  const float values[] = { 0.0f, 0.5f, 1.0f, 41.0f, 42.0f, 42.25f, 100.0f, 127.5f, 200.75f, 254.5f, 255.0f };
+  for (unsigned v = 0; v != sizeof(values) / sizeof(values[0]); ++v) {
+    std::vector<unsigned> found = index.query(values[v]);
+    std::sort(found.begin(), found.end());
+    std::vector<unsigned> expected = scan_bricks(grid, values[v]);
+    CHECK_EQUAL(expected.size(), found.size());
+    CHECK(expected == found);
+  }
+}
+
+} // namespace
+
+SUITE(Span_space_index)
+{
+  TEST(QueryMatchesLinearScan)
+  {
+    check_against_scan(glm::vec2(0.0f, 1.0f));
+  }
+
+  // windowing makes brick min and max differ from the stored samples
+  TEST(QueryMatchesLinearScanWindowed)
+  {
+    check_against_scan(glm::vec2(0.1f, 0.8f));
+  }
+
+  TEST(QueryOutsideRangeIsEmpty)
+  {
+    glm::ivec3 dimensions(17, 9, 9);
+    volume_data_type data = make_waves(dimensions);
+    Brick_grid grid;
+    grid.build(data, dimensions, 1, glm::vec2(0.0f, 1.0f), 8);
+    Span_space_index index;
+    index.build(grid);
+
+    CHECK(index.query(-1.0f).empty());
+    CHECK(index.query(256.0f).empty());
+  }
+}
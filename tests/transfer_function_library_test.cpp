@@ -0,0 +1,178 @@
+#include <UnitTest++.h>
+
+#include "transfer_function_library.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* library_file = "transfer_function_library_test.tflib";
+const char* text_file = "transfer_function_library_test.txt";
+
+Transfer_function::container_type make_points(float shift)
+{
+  Transfer_function::container_type points;
+  points[0] = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+  points[64] = glm::vec4(0.25f + shift, 0.5f, 0.125f, 0.1f);
+  points[200] = glm::vec4(1.0f, 0.75f - shift, 0.3f, 0.6f);
+  points[255] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+  return points;
+}
+
+Transfer_function_library make_library()
+{
+  Transfer_function_library library;
+  library.set(Transfer_function_library::make_preset("bone", make_points(0.0f)));
+  library.set(Transfer_function_library::make_preset("soft tissue", make_points(0.125f)));
+  return library;
+}
+
+void check_same_presets(Transfer_function_library const& expected, Transfer_function_library const& actual)
+{
+  CHECK_EQUAL(expected.size(), actual.size());
+  for (unsigned i = 0; i != expected.size() && i != actual.size(); ++i) {
+    CHECK_EQUAL(expected.get(i).name, actual.get(i).name);
+    CHECK(expected.get(i).points == actual.get(i).points);
+    CHECK(expected.get(i).lut == actual.get(i).lut);
+  }
+}
+
+std::vector<unsigned char> read_file(std::string const& path)
+{
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+void write_file(std::string const& path, std::vector<unsigned char> const& data)
+{
+  std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+  file.write((const char*)&data[0], data.size());
+}
+
+void put_u16(std::vector<unsigned char>& out, unsigned value)
+{
+  out.push_back((unsigned char)(value & 0xFF));
+  out.push_back((unsigned char)((value >> 8) & 0xFF));
+}
+
+void put_u32(std::vector<unsigned char>& out, unsigned value)
+{
+  put_u16(out, value & 0xFFFF);
+  put_u16(out, value >> 16);
+}
+
+void put_preset(std::vector<unsigned char>& out, std::string const& name,
+                Transfer_function::container_type const& points, image_data_type const& lut,
+                unsigned preintegrated_entries)
+{
+  put_u16(out, unsigned(name.size()));
+  out.insert(out.end(), name.begin(), name.end());
+  put_u16(out, unsigned(points.size()));
+  for (Transfer_function::container_type::const_iterator c = points.begin(); c != points.end(); ++c) {
+    out.push_back((unsigned char)c->first);
+    for (int i = 0; i != 4; ++i) {
+      unsigned bits;
+      std::memcpy(&bits, &c->second[i], sizeof(bits));
+      put_u32(out, bits);
+    }
+  }
+  put_u16(out, unsigned(lut.size() / 4));
+  out.insert(out.end(), lut.begin(), lut.end());
+  put_u16(out, preintegrated_entries);
+  out.insert(out.end(), preintegrated_entries * preintegrated_entries * 4, 0x7F);
+}
+
+// a failed load must not touch the presets already there
+void check_rejected(std::vector<unsigned char> const& data)
+{
+  write_file(library_file, data);
+  Transfer_function_library library = make_library();
+  CHECK(!library.load(library_file));
+  check_same_presets(make_library(), library);
+  std::remove(library_file);
+}
+
+} // namespace
+
+SUITE(Transfer_function_library)
+{
+  TEST(BinaryRoundTrip)
+  {
+    Transfer_function_library saved = make_library();
+    CHECK(saved.save(library_file));
+
+    Transfer_function_library loaded;
+    CHECK(loaded.load(library_file));
+    check_same_presets(saved, loaded);
+    std::remove(library_file);
+  }
+
+  TEST(TextRoundTrip)
+  {
+    Transfer_function_library exported = make_library();
+    CHECK(exported.export_text(text_file));
+
+    Transfer_function_library imported;
+    CHECK(imported.import_text(text_file));
+    check_same_presets(exported, imported);
+    std::remove(text_file);
+  }
+
+  TEST(TruncatedFileIsRejected)
+  {
+    CHECK(make_library().save(library_file));
+    std::vector<unsigned char> data = read_file(library_file);
+    data.resize(data.size() - 10);
+    check_rejected(data);
+  }
+
+  TEST(BadMagicIsRejected)
+  {
+    CHECK(make_library().save(library_file));
+    std::vector<unsigned char> data = read_file(library_file);
+    data[0] = 'X';
+    check_rejected(data);
+  }
+
+  TEST(NewerVersionIsRejected)
+  {
+    CHECK(make_library().save(library_file));
+    std::vector<unsigned char> data = read_file(library_file);
+    data[4] = (unsigned char)(Transfer_function_library::version + 1);
+    check_rejected(data);
+  }
+
+  // older files may hold a pre-integrated table after the lut, and tables of
+  // another size than the transfer function are baked again
+  TEST(OlderPreintegratedTableIsSkipped)
+  {
+    Transfer_function::container_type points = make_points(0.0f);
+    image_data_type lut = Transfer_function::bake(points);
+
+    std::vector<unsigned char> data;
+    data.insert(data.end(), "TFLB", "TFLB" + 4);
+    put_u32(data, 1);
+    put_u32(data, 3);
+    put_preset(data, "preintegrated", points, lut, 4);
+    put_preset(data, "short lut", points, image_data_type(100 * 4, 0x11), 0);
+    put_preset(data, "last", make_points(0.125f), Transfer_function::bake(make_points(0.125f)), 0);
+    write_file(library_file, data);
+
+    Transfer_function_library library;
+    CHECK(library.load(library_file));
+    CHECK_EQUAL(3u, library.size());
+    if (library.size() == 3) {
+      CHECK_EQUAL("preintegrated", library.get(0).name);
+      CHECK(library.get(0).lut == lut);
+      CHECK_EQUAL("short lut", library.get(1).name);
+      CHECK(library.get(1).lut == lut);
+      CHECK_EQUAL("last", library.get(2).name);
+      CHECK(library.get(2).points == make_points(0.125f));
+    }
+    std::remove(library_file);
+  }
+}
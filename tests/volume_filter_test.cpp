@@ -0,0 +1,115 @@
+#include <UnitTest++.h>
+
+#include "volume_filter.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const glm::ivec3 dimensions(13, 11, 23);
+const size_t voxel_count = size_t(dimensions.x) * dimensions.y * dimensions.z;
+
+Volume_filter make_filter(Volume_filter::Type type, float sigma, float range_sigma)
+{
+  Volume_filter filter = { type, sigma, range_sigma };
+  return filter;
+}
+
+std::vector<Volume_filter> make_filters()
+{
+  std::vector<Volume_filter> filters;
+  filters.push_back(make_filter(Volume_filter::gaussian, 1.0f, 0.0f));
+  filters.push_back(make_filter(Volume_filter::median, 0.0f, 0.0f));
+  filters.push_back(make_filter(Volume_filter::bilateral, 1.0f, 0.1f));
+  filters.push_back(make_filter(Volume_filter::gaussian, 0.5f, 0.0f));
+  return filters;
+}
+
+// float samples are stored as they are, so a chain run filter by filter
+// sees the same intermediate values as the fused one
+volume_data_type make_noise()
+{
+  std::vector<float> values(voxel_count);
+  unsigned state = 12345u;
+  for (size_t i = 0; i != voxel_count; ++i) {
+    state = state * 1664525u + 1013904223u;
+    values[i] = float(state >> 8) / float(1 << 24) + 0.3f * std::sin(float(i) * 0.05f);
+  }
+  volume_data_type data(voxel_count * 4);
+  std::memcpy(&data[0], &values[0], data.size());
+  return data;
+}
+
+void check_close_floats(volume_data_type const& expected, volume_data_type const& actual)
+{
+  CHECK_EQUAL(expected.size(), actual.size());
+  if (expected.size() != actual.size())
+    return;
+
+  const float* e = (const float*)&expected[0];
+  const float* a = (const float*)&actual[0];
+  size_t differing = 0;
+  for (size_t i = 0; i != expected.size() / 4; ++i) {
+    if (std::fabs(e[i] - a[i]) > 1e-5f)
+      ++differing;
+  }
+  CHECK_EQUAL(0u, differing);
+}
+
+} // namespace
+
+SUITE(Volume_filter)
+{
+  TEST(ConstantVolumeIsUnchanged)
+  {
+    std::vector<Volume_filter> filters = make_filters();
+    volume_data_type data(voxel_count, 77);
+    for (unsigned f = 0; f != filters.size(); ++f) {
+      Volume_filter_pipeline pipeline;
+      pipeline.add(filters[f]);
+      CHECK(data == pipeline.apply(data, dimensions, 1, glm::vec2(0.0f, 1.0f)));
+    }
+
+    Volume_filter_pipeline chain;
+    for (unsigned f = 0; f != filters.size(); ++f)
+      chain.add(filters[f]);
+    CHECK(data == chain.apply(data, dimensions, 1, glm::vec2(0.0f, 1.0f)));
+  }
+
+  // inside, on a face and in a corner
+  TEST(MedianRemovesSpike)
+  {
+    Volume_filter_pipeline pipeline;
+    pipeline.add(make_filter(Volume_filter::median, 0.0f, 0.0f));
+
+    const glm::ivec3 spikes[] = { glm::ivec3(6, 5, 11), glm::ivec3(0, 5, 8), glm::ivec3(12, 10, 22) };
+    for (unsigned s = 0; s != 3; ++s) {
+      volume_data_type data(voxel_count, 40);
+      data[spikes[s].x + dimensions.x * (spikes[s].y + size_t(dimensions.y) * spikes[s].z)] = 250;
+      CHECK(volume_data_type(voxel_count, 40) == pipeline.apply(data, dimensions, 1, glm::vec2(0.0f, 1.0f)));
+    }
+  }
+
+  TEST(FusedChainMatchesSequentialFilters)
+  {
+    std::vector<Volume_filter> filters = make_filters();
+    volume_data_type data = make_noise();
+    glm::vec2 range(-0.3f, 1.3f);
+
+    volume_data_type sequential = data;
+    Volume_filter_pipeline chain;
+    for (unsigned f = 0; f != filters.size(); ++f) {
+      Volume_filter_pipeline single;
+      single.add(filters[f]);
+      sequential = single.apply(sequential, dimensions, 4, range, dimensions.z);
+      chain.add(filters[f]);
+    }
+
+    // slabs thinner than the halo and slabs not dividing the depth
+    const int slab_depths[] = { 1, 3, 8, 64 };
+    for (unsigned d = 0; d != 4; ++d)
+      check_close_floats(sequential, chain.apply(data, dimensions, 4, range, slab_depths[d]));
+  }
+}
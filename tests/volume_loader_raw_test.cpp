@@ -0,0 +1,171 @@
+#include <UnitTest++.h>
+
+#include "volume_loader_raw.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// counts around the 16 byte vector width, so the scalar tail is covered too
+const size_t counts[] = { 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 33, 100 };
+const unsigned count_total = sizeof(counts) / sizeof(counts[0]);
+
+template <typename T>
+volume_data_type to_bytes(std::vector<T> const& values)
+{
+  volume_data_type data(values.size() * sizeof(T));
+  if (!values.empty())
+    std::memcpy(&data[0], &values[0], data.size());
+  return data;
+}
+
+// middle values with the extremes at the first and last element, both ways round
+template <typename T>
+void check_range(T low, T middle, T high, float scale)
+{
+  Volume_loader_raw loader;
+  for (unsigned c = 0; c != count_total; ++c) {
+    for (int order = 0; order != 2; ++order) {
+      std::vector<T> values(counts[c], middle);
+      values.front() = order ? high : low;
+      values.back() = order ? low : high;
+
+      glm::vec2 range = loader.get_value_range(to_bytes(values), sizeof(T));
+      if (counts[c] == 1) {
+        CHECK_CLOSE(float(values[0]) / scale, range.x, 1e-6f);
+        CHECK_CLOSE(float(values[0]) / scale, range.y, 1e-6f);
+      }
+      else {
+        CHECK_CLOSE(float(low) / scale, range.x, 1e-6f);
+        CHECK_CLOSE(float(high) / scale, range.y, 1e-6f);
+      }
+    }
+  }
+}
+
+} // namespace
+
+SUITE(Volume_loader_raw)
+{
+  TEST(ValueRange8Bit)
+  {
+    check_range<unsigned char>(3, 128, 250, 255.0f);
+    check_range<unsigned char>(0, 0, 255, 255.0f);
+  }
+
+  // values above 32767 would be ordered wrongly by signed comparisons
+  TEST(ValueRange16Bit)
+  {
+    check_range<unsigned short>(1000, 30000, 65000, 65535.0f);
+    check_range<unsigned short>(32767, 32768, 40000, 65535.0f);
+  }
+
+  TEST(ValueRangeFloat)
+  {
+    check_range<float>(-2.5f, 0.25f, 7.0f, 1.0f);
+  }
+
+  TEST(ValueRangeOfEmptyData)
+  {
+    Volume_loader_raw loader;
+    glm::vec2 range = loader.get_value_range(volume_data_type(), 1);
+    CHECK_EQUAL(0.0f, range.x);
+    CHECK_EQUAL(1.0f, range.y);
+  }
+
+  TEST(SwapEndianness16Bit)
+  {
+    Volume_loader_raw loader;
+    for (unsigned c = 0; c != count_total; ++c) {
+      volume_data_type data;
+      for (size_t i = 0; i != counts[c]; ++i) {
+        data.push_back((unsigned char)i);
+        data.push_back((unsigned char)(0x80 | i));
+      }
+      loader.swap_endianness(data, 2);
+      for (size_t i = 0; i != counts[c]; ++i) {
+        CHECK_EQUAL(int(0x80 | i), int(data[i * 2]));
+        CHECK_EQUAL(int(i), int(data[i * 2 + 1]));
+      }
+    }
+  }
+
+  TEST(SwapEndianness32Bit)
+  {
+    Volume_loader_raw loader;
+    for (unsigned c = 0; c != count_total; ++c) {
+      volume_data_type data;
+      for (size_t i = 0; i != counts[c] * 4; ++i)
+        data.push_back((unsigned char)i);
+      loader.swap_endianness(data, 4);
+      for (size_t i = 0; i != counts[c]; ++i) {
+        for (size_t b = 0; b != 4; ++b)
+          CHECK_EQUAL(int((i * 4 + 3 - b) & 0xFF), int(data[i * 4 + b]));
+      }
+    }
+  }
+
+  TEST(SwapEndiannessTwiceRestores)
+  {
+    Volume_loader_raw loader;
+    volume_data_type data;
+    for (unsigned i = 0; i != 4 * 17; ++i)
+      data.push_back((unsigned char)(i * 7));
+    volume_data_type swapped = data;
+    loader.swap_endianness(swapped, 4);
+    loader.swap_endianness(swapped, 4);
+    CHECK(data == swapped);
+  }
+
+  TEST(EqualizeTo8BitSpreadsTheRange)
+  {
+    Volume_loader_raw loader;
+    std::vector<unsigned short> values;
+    for (unsigned i = 0; i != 37; ++i)
+      values.push_back((unsigned short)(20000 + i * 100));
+    volume_data_type data = to_bytes(values);
+
+    volume_data_type result = loader.equalize_to_8bit(data, 2, loader.get_value_range(data, 2));
+    CHECK_EQUAL(values.size(), result.size());
+    CHECK_EQUAL(0, int(result.front()));
+    CHECK_EQUAL(255, int(result.back()));
+    for (size_t i = 1; i < result.size(); ++i)
+      CHECK(result[i - 1] < result[i]);
+  }
+
+  // equal values share one bin, so they map to the same output
+  TEST(EqualizeTo8BitKeepsEqualValuesTogether)
+  {
+    Volume_loader_raw loader;
+    std::vector<float> values(33, 0.5f);
+    values.front() = -1.0f;
+    values.back() = 2.0f;
+    volume_data_type data = to_bytes(values);
+
+    volume_data_type result = loader.equalize_to_8bit(data, 4, loader.get_value_range(data, 4));
+    CHECK_EQUAL(values.size(), result.size());
+    CHECK_EQUAL(0, int(result.front()));
+    CHECK_EQUAL(255, int(result.back()));
+    for (size_t i = 2; i + 1 < result.size(); ++i)
+      CHECK_EQUAL(int(result[1]), int(result[i]));
+    CHECK(result[1] > 0 && result[1] < 255);
+  }
+
+  TEST(EqualizeConstantDataIsZero)
+  {
+    Volume_loader_raw loader;
+    volume_data_type data = to_bytes(std::vector<unsigned short>(19, 1234));
+    volume_data_type result = loader.equalize_to_8bit(data, 2, loader.get_value_range(data, 2));
+    CHECK(result == volume_data_type(19, 0));
+  }
+
+  TEST(BigEndianTokenFollowsBitField)
+  {
+    Volume_loader_raw loader;
+    CHECK(loader.get_big_endian("data/ct_w4_h4_d4_c1_b16_be.raw"));
+    CHECK(!loader.get_big_endian("data/ct_w4_h4_d4_c1_b16.raw"));
+    CHECK(!loader.get_big_endian("data_be/ct_w4_h4_d4_c1_b16.raw"));
+    CHECK(!loader.get_big_endian("data/beam_be_w4_h4_d4_c1_b16.raw"));
+  }
+}